@@ -1,6 +1,10 @@
 
+#include <stdexcept>
+
 #include "src/adt/repeat_mode.h"
 #include "src/adt/player.h"
+#include "src/adt/binary_io.h"
+#include "src/adt/queue_metrics.h"
 
 
 Player::Player() :
@@ -16,6 +20,59 @@ Player::~Player()
 }
 
 
+/*!
+ *  @brief       Appends the player's state to out: a small header with the repeat mode, then the saved queue
+ *  @param[out]  out   Buffer the saved player is appended to
+ */
+void Player::save(std::vector<unsigned char>& out) const
+{
+	QUEUE_METRICS_SCOPE(playerSave);
+
+	BinaryWriter writer(out);
+	writer.putU32(kSaveMagic);
+	writer.putU8(kSaveVersion);
+	writer.putU8(static_cast<std::uint8_t>(m_repMode));
+
+	m_queue->save(out);
+}
+
+
+/*!
+ *  @brief       Restores a player written by save(), the shuffle flag comes back with the queue
+ *  @param[in]   data, size   Buffer holding a saved player
+ *  @return      Number of bytes read from data
+ */
+std::size_t Player::load(const unsigned char* data, std::size_t size)
+{
+	QUEUE_METRICS_SCOPE(playerLoad);
+
+	BinaryReader reader(data, size);
+	if (reader.getU32() != kSaveMagic) {
+		throw std::invalid_argument("data does not hold a saved Player");
+	}
+	if (reader.getU8() != kSaveVersion) {
+		throw std::invalid_argument("saved Player has an unsupported format version");
+	}
+	const std::uint8_t repeatMode = reader.getU8();
+	if (repeatMode > static_cast<std::uint8_t>(RepeatMode::on)) {
+		throw std::invalid_argument("saved Player has an unknown repeat mode");
+	}
+
+	std::size_t read = reader.position();
+	read += m_queue->load(data + read, size - read);
+
+	m_repMode = static_cast<RepeatMode>(repeatMode);
+	m_shuffled = m_queue->isShuffled();
+	return read;
+}
+
+
+SongQueue* Player::getQueue()
+{
+	return m_queue.get();
+}
+
+
 SongQueue const* Player::getQueue() const
 {
 	return m_queue.get();
@@ -28,6 +85,15 @@ const RepeatMode& Player::getRepeatMode() const
 }
 
 
+/*!
+ *  @brief   Bytes held by the player and its queue, including unused pool capacity
+ */
+std::size_t Player::memoryUsage() const
+{
+	return sizeof(*this) + m_queue->memoryUsage();
+}
+
+
 void Player::setRepeatMode(const RepeatMode& repeatMode)
 {
 	m_repMode = repeatMode;
@@ -36,6 +102,8 @@ void Player::setRepeatMode(const RepeatMode& repeatMode)
 
 void Player::setShuffle(const bool& shuffle)
 {
+	QUEUE_METRICS_SCOPE(playerSetShuffle);
+
 	m_shuffled = shuffle;
 	m_queue->setShuffled(shuffle);
 }
\ No newline at end of file
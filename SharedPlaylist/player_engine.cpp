@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "src/adt/player_engine.h"
+
+
+const std::chrono::milliseconds PlayerEngine::kTick(10);
+
+
+/*!
+ *  @param[in]   trackLength   Length of each song, called when it starts playing
+ *  @param[in]   listener      Told about every track that starts and every queue that runs out, can be empty
+ *  @param[in]   start         Where the engine's clock starts, poll() moves it on from there
+ */
+PlayerEngine::PlayerEngine(TrackLength trackLength, Listener listener, Clock::time_point start) :
+	m_trackLength(std::move(trackLength)), m_listener(std::move(listener)), m_wheel(kTick, start), m_now(start),
+	m_stopping(false)
+{
+	if (!m_trackLength) {
+		throw std::invalid_argument("trackLength must be set");
+	}
+}
+
+
+PlayerEngine::~PlayerEngine()
+{
+
+}
+
+
+/*!
+ *  @brief       Starts a session with an empty, paused Player
+ *  @param[in]   id   Id of the new session
+ *  @return      False if a session with that id already exists
+ */
+bool PlayerEngine::create(SessionId id)
+{
+	if (m_sessions.count(id) != 0) {
+		return false;
+	}
+
+	std::unique_ptr<Session> session(new Session());
+	session->id = id;
+	session->hasTrack = false;
+	session->trackNumber = 0;
+	session->ends = m_now;
+	session->remaining = Clock::duration::zero();
+	m_sessions.emplace(id, std::move(session));
+	return true;
+}
+
+
+/*!
+ *  @brief       Ends a session, without an event
+ *  @return      False if there is no session with that id
+ */
+bool PlayerEngine::destroy(SessionId id)
+{
+	auto found = m_sessions.find(id);
+	if (found == m_sessions.end()) {
+		return false;
+	}
+
+	m_wheel.cancel(*found->second);
+	m_sessions.erase(found);
+	return true;
+}
+
+
+/*!
+ *  @brief       Plays the current song, from where it was paused if it is the same track. A session that has no
+ *               current song yet starts from the first one.
+ *  @return      False if there is no session with that id or its queue is empty
+ */
+bool PlayerEngine::play(SessionId id)
+{
+	Session* session = find(id);
+	if (session == nullptr) {
+		return false;
+	}
+	if (session->isScheduled()) {
+		return true;
+	}
+
+	SongQueue* queue = session->player.getQueue();
+	if (queue->getCurrSong() == nullptr) {
+		if (queue->isEmpty()) {
+			return false;
+		}
+		queue->setCurrSong(0);
+	}
+
+	if (session->hasTrack && session->trackNumber == queue->getCurrSong()->number) {
+		session->ends = m_now + session->remaining;
+		m_wheel.schedule(*session, session->ends);
+	}
+	else {
+		startTrack(*session, m_now);
+	}
+	return true;
+}
+
+
+/*!
+ *  @brief       Stops the session's timer, keeping how much of the track is left
+ *  @return      False if there is no session with that id
+ */
+bool PlayerEngine::pause(SessionId id)
+{
+	Session* session = find(id);
+	if (session == nullptr) {
+		return false;
+	}
+
+	if (session->isScheduled()) {
+		session->remaining = std::max(Clock::duration::zero(), session->ends - m_now);
+		m_wheel.cancel(*session);
+	}
+	return true;
+}
+
+
+/*!
+ *  @brief       Moves on as if the current track had just ended. RepeatMode::once skips like off, the other modes
+ *               wrap around as usual. A paused session stays paused on the next song.
+ *  @return      False if there is no session with that id or there is no next song
+ */
+bool PlayerEngine::skip(SessionId id)
+{
+	Session* session = find(id);
+	if (session == nullptr) {
+		return false;
+	}
+
+	RepeatMode repeatMode = session->player.getRepeatMode();
+	if (repeatMode == RepeatMode::once) {
+		repeatMode = RepeatMode::off;
+	}
+
+	if (session->isScheduled()) {
+		m_wheel.cancel(*session);
+		return advance(*session, repeatMode, m_now);
+	}
+
+	if (!session->player.getQueue()->nextSong(repeatMode)) {
+		return false;
+	}
+	session->hasTrack = false;
+	return true;
+}
+
+
+/*!
+ *  @brief       One step of the loop: runs the posted tasks, then ends every track that is over by now.
+ *               Can drive the engine in place of run(), from a thread's own loop or with a simulated clock.
+ *  @param[in]   now   Times before the engine's clock are ignored
+ */
+void PlayerEngine::poll(Clock::time_point now)
+{
+	m_now = std::max(m_now, now);
+	runTasks();
+	m_wheel.advance(m_now, [this](TimerWheel::Timer& timer) {
+		trackEnded(static_cast<Session&>(timer));
+	});
+}
+
+
+/*!
+ *  @brief       Queues task to run on the loop thread at its next step. Safe from any thread.
+ *  @param[in]   task   Called with PlayerEngine&
+ */
+void PlayerEngine::post(Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_wakeUp.notify_one();
+}
+
+
+/*!
+ *  @brief   Turns the calling thread into the loop thread until stop() is called. Sleeps until the next tick
+ *           while tracks are playing, and until a task is posted while none are.
+ */
+void PlayerEngine::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stopping) {
+		lock.unlock();
+		poll(Clock::now());
+		lock.lock();
+
+		if (!m_tasks.empty() || m_stopping) {
+			continue;
+		}
+		if (m_wheel.size() == 0) {
+			m_wakeUp.wait(lock);
+		}
+		else {
+			m_wakeUp.wait_until(lock, m_wheel.nextTick());
+		}
+	}
+	m_stopping = false;
+}
+
+
+/*!
+ *  @brief   Makes run() return after its current step. Safe from any thread, if run() isn't running
+ *           the next call returns straight away.
+ */
+void PlayerEngine::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wakeUp.notify_all();
+}
+
+
+bool PlayerEngine::contains(SessionId id) const
+{
+	return find(id) != nullptr;
+}
+
+
+bool PlayerEngine::isPlaying(SessionId id) const
+{
+	const Session* session = find(id);
+	return session != nullptr && session->isScheduled();
+}
+
+
+int PlayerEngine::size() const
+{
+	return static_cast<int>(m_sessions.size());
+}
+
+
+/*!
+ *  @brief   Sessions playing a track, every one of them has a timer on the wheel
+ */
+int PlayerEngine::playingCount() const
+{
+	return m_wheel.size();
+}
+
+
+/*!
+ *  @brief   The engine's clock, the time of the last poll()
+ */
+PlayerEngine::Clock::time_point PlayerEngine::now() const
+{
+	return m_now;
+}
+
+
+PlayerEngine::Session* PlayerEngine::find(SessionId id)
+{
+	auto found = m_sessions.find(id);
+	return found != m_sessions.end() ? found->second.get() : nullptr;
+}
+
+
+const PlayerEngine::Session* PlayerEngine::find(SessionId id) const
+{
+	auto found = m_sessions.find(id);
+	return found != m_sessions.end() ? found->second.get() : nullptr;
+}
+
+
+/*!
+ *  @brief   Called by the wheel when a session's track is over
+ */
+void PlayerEngine::trackEnded(Session& session)
+{
+	// The next track starts where this one ended rather than when the loop got to it, so lag doesn't add up
+	advance(session, session.player.getRepeatMode(), session.ends);
+}
+
+
+/*!
+ *  @brief       Moves the playing session to its next song and starts it, or stops it at the end of the queue
+ *  @param[in]   at   When the new track starts
+ *  @return      True if there was a next song
+ */
+bool PlayerEngine::advance(Session& session, RepeatMode repeatMode, Clock::time_point at)
+{
+	if (!session.player.getQueue()->nextSong(repeatMode)) {
+		session.hasTrack = false;
+		emit(session.id, EventType::queueEnded, nullptr);
+		return false;
+	}
+
+	startTrack(session, at);
+	return true;
+}
+
+
+/*!
+ *  @brief       Plays the current song from the beginning
+ *  @param[in]   at   When it starts
+ */
+void PlayerEngine::startTrack(Session& session, Clock::time_point at)
+{
+	const Song* song = session.player.getQueue()->getCurrSong();
+	session.hasTrack = true;
+	session.trackNumber = song->number;
+	session.remaining = m_trackLength(*song);
+	session.ends = at + session.remaining;
+	m_wheel.schedule(session, session.ends);
+
+	// Last, the listener may destroy the session
+	emit(session.id, EventType::trackStarted, song);
+}
+
+
+/*!
+ *  @brief   Catches the session up after its queue was edited: a playing session whose current song changed
+ *           starts the new one, or ends if the queue has none left
+ */
+void PlayerEngine::followQueue(Session& session)
+{
+	const Song* song = session.player.getQueue()->getCurrSong();
+	if (song != nullptr && session.hasTrack && session.trackNumber == song->number) {
+		return;
+	}
+
+	if (!session.isScheduled()) {
+		session.hasTrack = false;
+	}
+	else if (song == nullptr) {
+		m_wheel.cancel(session);
+		session.hasTrack = false;
+		emit(session.id, EventType::queueEnded, nullptr);
+	}
+	else {
+		startTrack(session, m_now);
+	}
+}
+
+
+/*!
+ *  @brief   Runs every task posted so far. If one throws, the tasks after it stay queued for the next step.
+ */
+void PlayerEngine::runTasks()
+{
+	std::vector<Task> tasks;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		tasks.swap(m_tasks);
+	}
+
+	for (std::size_t i = 0; i < tasks.size(); ++i) {
+		try {
+			tasks[i](*this);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.insert(m_tasks.begin(), std::make_move_iterator(tasks.begin() + i + 1),
+				std::make_move_iterator(tasks.end()));
+			throw;
+		}
+	}
+}
+
+
+void PlayerEngine::emit(SessionId id, EventType type, const Song* song)
+{
+	if (m_listener) {
+		m_listener(Event{ id, type, song });
+	}
+}
@@ -0,0 +1,255 @@
+
+#include "src/adt/player_registry.h"
+
+
+const int PlayerRegistry::kShards;
+
+
+PlayerRegistry::PlayerRegistry()
+{
+	for (Shard& shard : m_shards) {
+		shard.memory = 0;
+		shard.resident = 0;
+	}
+}
+
+
+PlayerRegistry::~PlayerRegistry()
+{
+
+}
+
+
+/*!
+ *  @brief       Starts a session with an empty Player
+ *  @param[in]   id   Id of the new session
+ *  @return      False if a session with that id already exists
+ */
+bool PlayerRegistry::create(SessionId id)
+{
+	std::unique_ptr<Player> player = std::make_unique<Player>();
+
+	Shard& shard = shardOf(id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto inserted = shard.sessions.emplace(id, Session());
+	if (!inserted.second) {
+		return false;
+	}
+
+	Session& session = inserted.first->second;
+	session.player = std::move(player);
+	session.lastUsed = Clock::now();
+	session.memory = 0;
+	shard.resident += 1;
+	account(shard, session);
+	return true;
+}
+
+
+/*!
+ *  @brief       Ends a session and frees its Player
+ *  @return      False if there is no session with that id
+ */
+bool PlayerRegistry::destroy(SessionId id)
+{
+	std::unique_ptr<Player> player;
+	{
+		Shard& shard = shardOf(id);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		auto found = shard.sessions.find(id);
+		if (found == shard.sessions.end()) {
+			return false;
+		}
+
+		Session& session = found->second;
+		shard.memory -= session.memory;
+		if (session.player) {
+			shard.resident -= 1;
+		}
+
+		// Freed once the shard is unlocked
+		player = std::move(session.player);
+		shard.sessions.erase(found);
+	}
+	return true;
+}
+
+
+/*!
+ *  @brief       Saves a session's Player into its compact form and frees it
+ *  @return      False if there is no session with that id
+ */
+bool PlayerRegistry::evict(SessionId id)
+{
+	Shard& shard = shardOf(id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto found = shard.sessions.find(id);
+	if (found == shard.sessions.end()) {
+		return false;
+	}
+
+	evict(shard, found->second);
+	return true;
+}
+
+
+/*!
+ *  @brief       Evicts every resident session that has not been used for idleFor, one shard at a time
+ *  @param[in]   idleFor   How long a session has to be idle, zero evicts every session
+ *  @return      Number of sessions evicted
+ */
+int PlayerRegistry::evictIdle(Clock::duration idleFor)
+{
+	const Clock::time_point cutoff = Clock::now() - idleFor;
+	int evicted = 0;
+
+	for (Shard& shard : m_shards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (auto& entry : shard.sessions) {
+			Session& session = entry.second;
+			if (session.player && session.lastUsed <= cutoff) {
+				evict(shard, session);
+				evicted += 1;
+			}
+		}
+	}
+	return evicted;
+}
+
+
+bool PlayerRegistry::contains(SessionId id) const
+{
+	const Shard& shard = shardOf(id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.sessions.count(id) != 0;
+}
+
+
+/*!
+ *  @brief   Whether the session's Player is in memory, false if it is evicted or does not exist
+ */
+bool PlayerRegistry::isResident(SessionId id) const
+{
+	const Shard& shard = shardOf(id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto found = shard.sessions.find(id);
+	return found != shard.sessions.end() && found->second.player != nullptr;
+}
+
+
+int PlayerRegistry::size() const
+{
+	int count = 0;
+	for (const Shard& shard : m_shards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		count += static_cast<int>(shard.sessions.size());
+	}
+	return count;
+}
+
+
+int PlayerRegistry::residentCount() const
+{
+	int count = 0;
+	for (const Shard& shard : m_shards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		count += shard.resident;
+	}
+	return count;
+}
+
+
+/*!
+ *  @brief   Bytes held by every session, kept up to date as sessions are used. O(kShards).
+ */
+std::size_t PlayerRegistry::memoryUsage() const
+{
+	std::size_t bytes = sizeof(*this);
+	for (const Shard& shard : m_shards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		bytes += shard.memory;
+	}
+	return bytes;
+}
+
+
+/*!
+ *  @brief   Bytes held by one session, its Player or its saved form. 0 if there is no such session.
+ */
+std::size_t PlayerRegistry::memoryUsage(SessionId id) const
+{
+	const Shard& shard = shardOf(id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto found = shard.sessions.find(id);
+	return found != shard.sessions.end() ? found->second.memory : 0;
+}
+
+
+/*!
+ *  @brief   Spreads ids evenly over the shards, even sequential ones
+ */
+PlayerRegistry::Shard& PlayerRegistry::shardOf(SessionId id)
+{
+	return m_shards[(id * 0x9E3779B97F4A7C15ull) >> 58];
+}
+
+
+const PlayerRegistry::Shard& PlayerRegistry::shardOf(SessionId id) const
+{
+	return m_shards[(id * 0x9E3779B97F4A7C15ull) >> 58];
+}
+
+
+/*!
+ *  @brief   Loads an evicted session's Player back from its saved form, the shard must be locked
+ */
+Player& PlayerRegistry::restore(Shard& shard, Session& session)
+{
+	if (!session.player) {
+		std::unique_ptr<Player> player = std::make_unique<Player>();
+		player->load(session.saved.data(), session.saved.size());
+
+		session.player = std::move(player);
+		std::vector<unsigned char>().swap(session.saved);
+		shard.resident += 1;
+		account(shard, session);
+	}
+	return *session.player;
+}
+
+
+/*!
+ *  @brief   Saves the session's Player and frees it, the shard must be locked
+ */
+void PlayerRegistry::evict(Shard& shard, Session& session)
+{
+	if (!session.player) {
+		return;
+	}
+
+	session.player->save(session.saved);
+	session.saved.shrink_to_fit();
+	session.player.reset();
+	shard.resident -= 1;
+	account(shard, session);
+}
+
+
+/*!
+ *  @brief   Recomputes the bytes a session holds and updates its shard's total, the shard must be locked
+ */
+void PlayerRegistry::account(Shard& shard, Session& session)
+{
+	std::size_t memory = sizeof(Session) + session.saved.capacity();
+	if (session.player) {
+		memory += session.player->memoryUsage();
+	}
+
+	shard.memory += memory - session.memory;
+	session.memory = memory;
+}
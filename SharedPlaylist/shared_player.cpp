@@ -0,0 +1,71 @@
+
+#include "src/adt/repeat_mode.h"
+#include "src/adt/shared_player.h"
+
+
+SharedPlayer::SharedPlayer() :
+	m_repMode(RepeatMode::off)
+{
+	m_queue.setShuffled(false);
+}
+
+
+SharedPlayer::~SharedPlayer()
+{
+
+}
+
+
+/*!
+ *  @brief   Advances playback using the current RepeatMode
+ *  @return  True if moved forward successfully
+ */
+bool SharedPlayer::nextSong()
+{
+	return m_queue.nextSong(m_repMode.load());
+}
+
+
+bool SharedPlayer::prevSong()
+{
+	return m_queue.prevSong();
+}
+
+
+SharedSongQueue& SharedPlayer::getQueue()
+{
+	return m_queue;
+}
+
+
+const SharedSongQueue& SharedPlayer::getQueue() const
+{
+	return m_queue;
+}
+
+
+RepeatMode SharedPlayer::getRepeatMode() const
+{
+	return m_repMode.load();
+}
+
+
+/*!
+ *  @brief   Read from the queue itself, so it always agrees with the snapshot listeners see
+ */
+bool SharedPlayer::getShuffle() const
+{
+	return m_queue.isShuffled();
+}
+
+
+void SharedPlayer::setRepeatMode(const RepeatMode& repeatMode)
+{
+	m_repMode.store(repeatMode);
+}
+
+
+void SharedPlayer::setShuffle(const bool& shuffle)
+{
+	m_queue.setShuffled(shuffle);
+}
@@ -0,0 +1,147 @@
+#ifndef BASIC_QUEUE_H
+#define BASIC_QUEUE_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "song.h"
+#include "treap_queue.h"
+
+
+/// Node of BasicSongQueue. The song lives in raw storage the queue constructs it in,
+/// so the sentinels need no song and T no default constructor.
+template <class T, class ShufflePolicy>
+struct BasicSongQueueNode : TreapQueueNode<BasicSongQueueNode<T, ShufflePolicy>, ShufflePolicy>
+{
+	T& value() { return *reinterpret_cast<T*>(storage); }
+	const T& value() const { return *reinterpret_cast<const T*>(storage); }
+
+	alignas(T) unsigned char storage[sizeof(T)];
+};
+
+
+/// Song queue over any payload type, with the features it carries picked at compile time.
+/// Everything but the payload is TreapQueue, the engine SongQueue runs on too: O(log n) indexing
+/// and a lazily drawn shuffle. Songs are held inline in nodes pooled through Allocator.
+/// A disabled policy drops its links and state from the node and its branches fold away, ShuffleOff
+/// alone halves the links every song carries.
+/// The default configuration is specialized by SongQueue itself, see song_queue.h.
+template <class T, class Allocator = std::allocator<T>, class ShufflePolicy = ShuffleOn, class SubQueuePolicy = SubQueueOn>
+class BasicSongQueue :
+	public TreapQueue<BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>, T, BasicSongQueueNode<T, ShufflePolicy>, Allocator, ShufflePolicy, SubQueuePolicy>
+{
+public:
+	explicit BasicSongQueue(const Allocator& allocator = Allocator());
+	~BasicSongQueue();
+
+	// GETTERS
+	std::size_t memoryUsage() const;
+
+
+private:
+	using Engine = TreapQueue<BasicSongQueue, T, BasicSongQueueNode<T, ShufflePolicy>, Allocator, ShufflePolicy, SubQueuePolicy>;
+	using Node = BasicSongQueueNode<T, ShufflePolicy>;
+
+	friend Engine;
+
+	// No copying from BasicSongQueue
+	BasicSongQueue(const BasicSongQueue&) = delete;
+	void operator=(const BasicSongQueue&) = delete;
+
+	template <class... Args>
+	Node* newNode(Args&&... args);
+	void deleteNode(Node* node);
+	void releaseNodes();
+	void releaseNodes(std::true_type);
+	void releaseNodes(std::false_type);
+	const T& songOf(const Node* node) const { return node->value(); }
+};
+
+
+/// SongQueue, defined in song_queue.h
+template <>
+class BasicSongQueue<Song, std::allocator<Song>, ShuffleOn, SubQueueOn>;
+
+
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::BasicSongQueue(const Allocator& allocator) :
+	Engine(allocator) { }
+
+
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::~BasicSongQueue()
+{
+	this->clear();
+}
+
+
+/*!
+ *  @brief   Bytes held by the queue's storage, including pooled slots not currently in use.
+ *           Memory the songs own themselves is not counted.
+ */
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+std::size_t BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::memoryUsage() const
+{
+	return sizeof(*this) + this->m_nodePool.memoryUsage();
+}
+
+
+/*!
+ *  @brief       Creates a pooled node and constructs its song in place
+ *  @param[in]   args   Forwarded to T's constructor
+ */
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class... Args>
+typename BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::Node* BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::newNode(Args&&... args)
+{
+	Node* node = this->createNode();
+	try {
+		new (node->storage) T(std::forward<Args>(args)...);
+	}
+	catch (...) {
+		this->destroyNode(node);
+		throw;
+	}
+	return node;
+}
+
+
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::deleteNode(Node* node)
+{
+	node->value().~T();
+	this->destroyNode(node);
+}
+
+
+/*!
+ *  @brief   Hands every node back to the pool at once, destroying the songs first unless that is a no-op
+ */
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::releaseNodes()
+{
+	releaseNodes(std::is_trivially_destructible<T>());
+}
+
+
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::releaseNodes(std::true_type)
+{
+	this->m_nodePool.releaseAll();
+}
+
+
+template <class T, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void BasicSongQueue<T, Allocator, ShufflePolicy, SubQueuePolicy>::releaseNodes(std::false_type)
+{
+	for (Node* node = this->m_head->getNext(false); node != this->m_tail; node = node->getNext(false)) {
+		node->value().~T();
+	}
+	this->m_nodePool.releaseAll();
+}
+
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+
+/// Appends fixed width little-endian values to a byte buffer, the same on every platform
+class BinaryWriter
+{
+public:
+	explicit BinaryWriter(std::vector<unsigned char>& out) : m_out(out) { }
+
+	void putU8(std::uint8_t value)
+	{
+		m_out.push_back(value);
+	}
+
+	void putU32(std::uint32_t value)
+	{
+		unsigned char bytes[4] = {
+			static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+			static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)
+		};
+		m_out.insert(m_out.end(), bytes, bytes + 4);
+	}
+
+	void putI32(std::int32_t value)
+	{
+		putU32(static_cast<std::uint32_t>(value));
+	}
+
+	void putU64(std::uint64_t value)
+	{
+		putU32(static_cast<std::uint32_t>(value));
+		putU32(static_cast<std::uint32_t>(value >> 32));
+	}
+
+private:
+	std::vector<unsigned char>& m_out;
+};
+
+
+/// Reads what BinaryWriter wrote, throwing std::invalid_argument instead of reading past the end
+class BinaryReader
+{
+public:
+	BinaryReader(const unsigned char* data, std::size_t size) : m_data(data), m_size(size), m_pos(0) { }
+
+	std::uint8_t getU8()
+	{
+		require(1);
+		return m_data[m_pos++];
+	}
+
+	std::uint32_t getU32()
+	{
+		require(4);
+		const unsigned char* bytes = m_data + m_pos;
+		m_pos += 4;
+		return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 |
+			static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+	}
+
+	std::int32_t getI32()
+	{
+		return static_cast<std::int32_t>(getU32());
+	}
+
+	std::uint64_t getU64()
+	{
+		std::uint64_t low = getU32();
+		return low | static_cast<std::uint64_t>(getU32()) << 32;
+	}
+
+	/// Throws unless count more bytes are left, lets callers check a whole array up front
+	void require(std::size_t count) const
+	{
+		if (m_size - m_pos < count) {
+			throw std::invalid_argument("data is truncated");
+		}
+	}
+
+	std::size_t position() const
+	{
+		return m_pos;
+	}
+
+private:
+	const unsigned char* m_data;
+	std::size_t m_size;
+	std::size_t m_pos;
+};
+
+
+#endif
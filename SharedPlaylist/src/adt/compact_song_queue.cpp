@@ -0,0 +1,77 @@
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include "compact_song_queue.h"
+
+
+CompactSongQueue::CompactSongQueue() :
+	m_state()
+{
+	m_state.shuffleSeed = (std::uint64_t(std::random_device{}()) << 32) | std::random_device{}();
+	clear();
+}
+
+
+CompactSongQueue::~CompactSongQueue()
+{
+
+}
+
+
+/*!
+ *  @brief       Grows the arrays so count songs fit without reallocating
+ */
+void CompactSongQueue::reserve(int count)
+{
+	m_songs.reserve(count + 1);
+	for (int shuffled = 0; shuffled < 2; ++shuffled) {
+		m_next[shuffled].reserve(count + 1);
+		m_prev[shuffled].reserve(count + 1);
+	}
+}
+
+
+/*!
+ *  @brief   Bytes held by the queue's storage, including unused capacity
+ */
+std::size_t CompactSongQueue::memoryUsage() const
+{
+	std::size_t bytes = sizeof(*this) + m_songs.capacity() * sizeof(Song);
+	for (int shuffled = 0; shuffled < 2; ++shuffled) {
+		bytes += (m_next[shuffled].capacity() + m_prev[shuffled].capacity()) * sizeof(NodeIndex);
+	}
+	return bytes;
+}
+
+
+/*!
+ *  @brief   Appends a slot holding song, its links are set by the caller
+ */
+CompactSongQueue::NodeIndex CompactSongQueue::addRecord(const Song& song)
+{
+	if (m_songs.size() > std::numeric_limits<NodeIndex>::max()) {
+		throw std::length_error("CompactSongQueue is limited to 2^32 - 1 songs");
+	}
+
+	NodeIndex node = static_cast<NodeIndex>(m_songs.size());
+	m_songs.push_back(song);
+	for (int shuffled = 0; shuffled < 2; ++shuffled) {
+		m_next[shuffled].push_back(kSentinel);
+		m_prev[shuffled].push_back(kSentinel);
+	}
+	return node;
+}
+
+
+/*!
+ *  @brief   Drops every slot but the sentinel, keeping the arrays' capacity for reuse
+ */
+void CompactSongQueue::clearRecords()
+{
+	m_songs.assign(1, Song(0));
+	for (int shuffled = 0; shuffled < 2; ++shuffled) {
+		m_next[shuffled].resize(1);
+		m_prev[shuffled].resize(1);
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef COMPACT_QUEUE_H
+#define COMPACT_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "song.h"
+#include "index_linked_queue.h"
+
+
+/// Alternate storage mode for SongQueue with the same playback semantics.
+/// Songs live inline in one contiguous array and both orders link to each other through
+/// 32-bit indices kept in parallel arrays, so traversals touch a few dense arrays instead of
+/// chasing heap pointers. Index based operations walk the list from the nearer end, so this
+/// mode trades SongQueue's O(log n) indexing for memory.
+///
+/// Approximate storage per track on x64:
+///     SongQueue          node 136 B (4 list links + 2 treaps + 2 duplicate links + 4 B track id),
+///                        plus the song index and pool slack                      ~ 178 B
+///     CompactSongQueue   4 x 4 B links + inline song 4 B                         =  20 B
+class CompactSongQueue : public IndexLinkedQueue<CompactSongQueue>
+{
+public:
+	CompactSongQueue();
+	~CompactSongQueue();
+
+	void reserve(int count);
+
+	// GETTERS
+	std::size_t memoryUsage() const;
+
+private:
+	friend class IndexLinkedQueue<CompactSongQueue>;
+
+	// No copying from CompactSongQueue
+	CompactSongQueue(const CompactSongQueue&) = delete;
+	void operator=(const CompactSongQueue&) = delete;
+
+	Song& song(NodeIndex node) { return m_songs[node]; }
+	const Song& song(NodeIndex node) const { return m_songs[node]; }
+	NodeIndex& next(NodeIndex node, bool shuffled) { return m_next[shuffled][node]; }
+	NodeIndex next(NodeIndex node, bool shuffled) const { return m_next[shuffled][node]; }
+	NodeIndex& prev(NodeIndex node, bool shuffled) { return m_prev[shuffled][node]; }
+	NodeIndex prev(NodeIndex node, bool shuffled) const { return m_prev[shuffled][node]; }
+	IndexLinkedState& state() { return m_state; }
+	const IndexLinkedState& state() const { return m_state; }
+
+	NodeIndex addRecord(const Song& song);
+	void clearRecords();
+
+
+	std::vector<Song> m_songs;
+
+	/// Links, indexed by the shuffled flag
+	std::vector<NodeIndex> m_next[2];
+	std::vector<NodeIndex> m_prev[2];
+
+	IndexLinkedState m_state;
+};
+
+
+#endif
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "epoch_domain.h"
+
+
+const int EpochDomain::kSlots;
+
+
+EpochDomain::EpochDomain() :
+	m_epoch(1)
+{
+	for (Slot& slot : m_slots) {
+		slot.epoch.store(0, std::memory_order_relaxed);
+	}
+}
+
+
+/*!
+ *  @brief   Deletes everything still retired, no Guard may outlive the domain
+ */
+EpochDomain::~EpochDomain()
+{
+	for (Retired& retired : m_retired) {
+		retired.deleter(retired.obj);
+	}
+}
+
+
+/*!
+ *  @brief       Pins the domain's current epoch until the Guard is destroyed
+ */
+EpochDomain::Guard::Guard(const EpochDomain& domain) :
+	m_domain(&domain), m_slot(-1)
+{
+	// Each thread starts looking at its own slot so readers rarely compete for one
+	static std::atomic<int> nextHint(0);
+	thread_local int hint = nextHint.fetch_add(1, std::memory_order_relaxed) % kSlots;
+
+	for (int slot = hint, tried = 1; ; slot = (slot + 1) % kSlots, ++tried) {
+		std::atomic<std::uint64_t>& epoch = m_domain->m_slots[slot].epoch;
+		std::uint64_t free = 0;
+		if (epoch.load(std::memory_order_relaxed) == 0 &&
+			epoch.compare_exchange_strong(free, m_domain->m_epoch.load())) {
+			m_slot = slot;
+			return;
+		}
+
+		// Every slot is taken, give the readers holding them a chance to run and leave
+		if (tried % kSlots == 0) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+EpochDomain::Guard::Guard(Guard&& guard) noexcept :
+	m_domain(guard.m_domain), m_slot(guard.m_slot)
+{
+	guard.m_slot = -1;
+}
+
+
+EpochDomain::Guard::~Guard()
+{
+	if (m_slot >= 0) {
+		m_domain->m_slots[m_slot].epoch.store(0, std::memory_order_release);
+	}
+}
+
+
+/*!
+ *  @brief       Hands obj to the domain, deleter(obj) runs once no reader can still hold it
+ *  @param[in]   obj       Object already unpublished, so new readers can't reach it
+ *  @param[in]   deleter   Frees obj, called from whichever thread reclaims it
+ */
+void EpochDomain::retire(void* obj, void (*deleter)(void*))
+{
+	std::lock_guard<std::mutex> lock(m_retiredMutex);
+
+	// Readers pinned at this epoch or earlier may have loaded obj, later ones can't
+	m_retired.push_back({ obj, deleter, m_epoch.fetch_add(1) });
+	reclaimLocked();
+}
+
+
+/*!
+ *  @brief   Deletes the retired objects no reader can still hold
+ */
+void EpochDomain::reclaim()
+{
+	std::lock_guard<std::mutex> lock(m_retiredMutex);
+	reclaimLocked();
+}
+
+
+int EpochDomain::pendingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_retiredMutex);
+	return static_cast<int>(m_retired.size());
+}
+
+
+void EpochDomain::reclaimLocked()
+{
+	std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+	for (const Slot& slot : m_slots) {
+		std::uint64_t epoch = slot.epoch.load();
+		if (epoch != 0) {
+			oldest = std::min(oldest, epoch);
+		}
+	}
+
+	auto reclaimable = std::stable_partition(m_retired.begin(), m_retired.end(),
+		[oldest](const Retired& retired) { return retired.epoch >= oldest; });
+	for (auto retired = reclaimable; retired != m_retired.end(); ++retired) {
+		retired->deleter(retired->obj);
+	}
+	m_retired.erase(reclaimable, m_retired.end());
+}
@@ -0,0 +1,92 @@
+#ifndef EPOCH_DOMAIN_H
+#define EPOCH_DOMAIN_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+/// Epoch based reclamation for objects that readers reach through an atomic pointer.
+/// Readers pin the current epoch with a Guard for as long as they use an object, which costs one
+/// uncontended compare-and-swap on a slot of their own. Writers unpublish an object and retire()
+/// it, it is deleted once no reader pinned before the retirement is still inside its Guard.
+class EpochDomain
+{
+public:
+	/// Readers that can be inside a Guard at the same time, further readers yield until a slot frees up
+	static const int kSlots = 128;
+
+	EpochDomain();
+	~EpochDomain();
+
+	class Guard
+	{
+	public:
+		explicit Guard(const EpochDomain& domain);
+		Guard(Guard&& guard) noexcept;
+		~Guard();
+
+	private:
+		Guard(const Guard&) = delete;
+		void operator=(const Guard&) = delete;
+		void operator=(Guard&&) = delete;
+
+		const EpochDomain* m_domain;
+		int m_slot;
+	};
+
+	template <class T>
+	void retire(const T* obj);
+	void retire(void* obj, void (*deleter)(void*));
+	void reclaim();
+
+	// GETTERS
+	int pendingCount() const;
+
+private:
+
+	// No copying from EpochDomain
+	EpochDomain(const EpochDomain&) = delete;
+	void operator=(const EpochDomain&) = delete;
+
+	/// Epoch pinned by the reader holding the slot, 0 while it is free.
+	/// Padded to a cache line so readers on different cores don't share one.
+	struct Slot
+	{
+		std::atomic<std::uint64_t> epoch;
+		char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+	};
+
+	struct Retired
+	{
+		void* obj;
+		void (*deleter)(void*);
+		std::uint64_t epoch;
+	};
+
+	void reclaimLocked();
+
+	mutable Slot m_slots[kSlots];
+	std::atomic<std::uint64_t> m_epoch;
+
+	mutable std::mutex m_retiredMutex;
+	std::vector<Retired> m_retired;
+};
+
+
+/*!
+ *  @brief       Deletes obj once every reader that could still see it has left its Guard.
+ *               obj must already be unreachable for new readers.
+ */
+template <class T>
+void EpochDomain::retire(const T* obj)
+{
+	if (obj == nullptr) {
+		return;
+	}
+	retire(const_cast<T*>(obj), [](void* ptr) { delete static_cast<T*>(ptr); });
+}
+
+
+#endif
@@ -0,0 +1,799 @@
+#ifndef INDEX_LINKED_QUEUE_H
+#define INDEX_LINKED_QUEUE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "song.h"
+#include "repeat_mode.h"
+#include "shuffle_rng.h"
+#include "parallel_shuffle.h"
+
+
+/// Queue state kept outside the records. Plain data, so MappedSongQueue keeps it in its file header.
+struct IndexLinkedState
+{
+	/// Free records are chained through their unshuffled next link
+	std::uint32_t freeList;
+	std::uint32_t subQueueTail;
+	std::uint32_t currSong;
+	std::int32_t size;
+	std::uint32_t shuffled;
+
+	/// Seed of the next shuffle, advanced by every shuffle
+	std::uint64_t shuffleSeed;
+};
+
+
+/// Queue logic shared by the storage modes that keep songs in numbered records linked by 32-bit indices,
+/// CompactSongQueue and MappedSongQueue. Storage derives from it and supplies the records through:
+///     Song& song(NodeIndex node)                        and a const overload
+///     NodeIndex& next(NodeIndex node, bool shuffled)    and a const overload, prev() alike
+///     IndexLinkedState& state()                         and a const overload
+///     NodeIndex addRecord(const Song& song)             one more record holding song, may move the others
+///     void clearRecords()                               drops every record but the sentinel
+/// Record 0 is a circular sentinel in both orders: its next is the first song and its prev the last one.
+/// Index based operations walk the list from the nearer end, and a shuffle relinks the shuffled order eagerly.
+template <class Storage>
+class IndexLinkedQueue
+{
+public:
+	using NodeIndex = std::uint32_t;
+
+	void addToQueue(const Song& song);
+	void addToSubQueue(const Song& song);
+	template <class... Args>
+	void emplaceToQueue(Args&&... args);
+	template <class... Args>
+	void emplaceToSubQueue(Args&&... args);
+	void addToQueue(std::unique_ptr<Song> song);
+	void addToSubQueue(std::unique_ptr<Song> song);
+	void removeFromQueue(const int& songIndex);
+	void moveSong(const int& oldSongIndex, const int& newSongIndex);
+	bool nextSong(RepeatMode repeatMode);
+	bool prevSong();
+
+	void clear();
+
+	// GETTERS
+	const Song* getSongAt(int songIndex) const;
+	bool isEmpty() const;
+	bool isShuffled() const;
+	int size() const;
+	std::uint64_t getShuffleSeed() const;
+
+	// SETTERS
+	void setCurrSong(const int& songIndex);
+	void setShuffled(const bool& shuffled);
+	void setShuffleSeed(std::uint64_t seed);
+
+	// OVERLOADS
+	operator std::vector<Song>() const;
+	friend std::ostream& operator<<(std::ostream& out, const IndexLinkedQueue& queue)
+	{
+		return queue.print(out);
+	}
+
+
+	class Iterator;
+
+	Iterator begin() const;
+	Iterator end() const;
+	Iterator rbegin() const;
+	Iterator rend() const;
+
+	/// Bidirectional iterator over the current order, whichever it is when each step is taken
+	class Iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = const Song*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Song*;
+		using reference = const Song*;
+
+		Iterator() noexcept;
+		Iterator(const IndexLinkedQueue& songQueue, NodeIndex node) noexcept;
+
+		Iterator& operator++();    // Prefix
+		Iterator operator++(int);  // Postfix
+
+		Iterator& operator--();    // Prefix
+		Iterator operator--(int);  // Postfix
+
+		bool operator==(const Iterator& iter) const;
+		bool operator!=(const Iterator& iter) const;
+		Song const * operator*() const;
+
+	private:
+		const IndexLinkedQueue* m_queue;
+		NodeIndex m_currNode;
+	};
+
+
+protected:
+	/// Record 0, never holds a song
+	static const NodeIndex kSentinel = 0;
+
+	IndexLinkedQueue() = default;
+	~IndexLinkedQueue() = default;
+
+private:
+
+	// No copying from IndexLinkedQueue
+	IndexLinkedQueue(const IndexLinkedQueue&) = delete;
+	void operator=(const IndexLinkedQueue&) = delete;
+
+	Storage& storage() { return static_cast<Storage&>(*this); }
+	const Storage& storage() const { return static_cast<const Storage&>(*this); }
+
+	void shuffle(const bool& keepPlayed);
+	NodeIndex wrapAround();
+
+	std::ostream& print(std::ostream& out) const;
+
+	NodeIndex newNode(const Song& song);
+	void deleteNode(NodeIndex node);
+	NodeIndex nodeAt(int songIndex, const bool& shuffled) const;
+	void insertAfter(NodeIndex pos, NodeIndex node, const bool& shuffled);
+	void unlink(NodeIndex node, const bool& shuffled);
+};
+
+
+template <class Storage>
+const typename IndexLinkedQueue<Storage>::NodeIndex IndexLinkedQueue<Storage>::kSentinel;
+
+
+/*!
+ *  @brief       Adds a song to the end of the Queue (same way Spotify handles it)
+ *  @param[in]   song   The song to be added to the queue
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::addToQueue(const Song& song)
+{
+	NodeIndex node = newNode(song);
+
+	insertAfter(storage().prev(kSentinel, false), node, false);
+	insertAfter(storage().prev(kSentinel, true), node, true);
+
+	storage().state().size += 1;
+}
+
+
+/*!
+ *  @brief   Same as addToQueue(*song), kept for callers that still hand songs over in a std::unique_ptr
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::addToQueue(std::unique_ptr<Song> song)
+{
+	addToQueue(*song);
+}
+
+
+/*!
+ *  @brief       Adds a song to the end of the sub queue, which plays in order after currSong
+ *  @param[in]   song   The song to be added to the sub queue
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::addToSubQueue(const Song& song)
+{
+	NodeIndex node = newNode(song);
+	IndexLinkedState& state = storage().state();
+
+	insertAfter(state.subQueueTail, node, false);
+	insertAfter(state.subQueueTail, node, true);
+	state.subQueueTail = node;
+
+	state.size += 1;
+}
+
+
+/*!
+ *  @brief   Same as addToSubQueue(*song), kept for callers that still hand songs over in a std::unique_ptr
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::addToSubQueue(std::unique_ptr<Song> song)
+{
+	addToSubQueue(*song);
+}
+
+
+/*!
+ *  @brief       Adds a song constructed from args to the end of the Queue
+ *  @param[in]   args   Forwarded to Song's constructor
+ */
+template <class Storage>
+template <class... Args>
+void IndexLinkedQueue<Storage>::emplaceToQueue(Args&&... args)
+{
+	addToQueue(Song(std::forward<Args>(args)...));
+}
+
+
+/*!
+ *  @brief       Adds a song constructed from args to the end of the sub queue
+ *  @param[in]   args   Forwarded to Song's constructor
+ */
+template <class Storage>
+template <class... Args>
+void IndexLinkedQueue<Storage>::emplaceToSubQueue(Args&&... args)
+{
+	addToSubQueue(Song(std::forward<Args>(args)...));
+}
+
+
+/*!
+ *  @brief       Removes a song at an index
+ *  @param[in]   songIndex  Index of song to delete
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::removeFromQueue(const int& songIndex)
+{
+	if (songIndex < 0 || songIndex >= size()) {
+		throw std::invalid_argument("songIndex out of bounds");
+	}
+
+	NodeIndex node = nodeAt(songIndex, isShuffled());
+	NodeIndex prev = storage().prev(node, isShuffled());
+	IndexLinkedState& state = storage().state();
+
+	if (node == state.subQueueTail) {
+		state.subQueueTail = prev;
+	}
+	if (node == state.currSong) {
+		state.currSong = prev;
+	}
+
+	unlink(node, false);
+	unlink(node, true);
+	deleteNode(node);
+
+	state.size -= 1;
+}
+
+
+/*!
+ *  @brief      Moves a song within the current order, the other order is left untouched
+ *
+ *  @param[in]  songIndex     The index of where the song currently is
+ *  @param[in]  newSongIndex  The index to move the song to
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::moveSong(const int& songIndex, const int& newSongIndex)
+{
+	if (songIndex == newSongIndex) {
+		return;
+	}
+	if (songIndex < 0 || songIndex >= size()) {
+		throw std::invalid_argument("oldSongIndex out of bounds");
+	}
+	if (newSongIndex < 0 || newSongIndex >= size()) {
+		throw std::invalid_argument("newSongIndex out of bounds");
+	}
+
+	NodeIndex songNode = nodeAt(songIndex, isShuffled());
+	IndexLinkedState& state = storage().state();
+
+	if (songNode == state.currSong) {
+		throw std::invalid_argument("Cannot move the currently playing song.");
+	}
+
+	if (songNode == state.subQueueTail) {
+		state.subQueueTail = storage().prev(songNode, isShuffled());
+	}
+
+	// Find the new predecessor before unlinking, while indices still match the list
+	NodeIndex pos;
+	if (songIndex < newSongIndex) {
+		pos = nodeAt(newSongIndex, isShuffled());
+	}
+	else {
+		pos = newSongIndex == 0 ? kSentinel : nodeAt(newSongIndex - 1, isShuffled());
+	}
+
+	unlink(songNode, isShuffled());
+	insertAfter(pos, songNode, isShuffled());
+}
+
+
+/*!
+ *  @brief   First song of the next cycle when repeating the whole queue.
+ *           Shuffled, the next cycle is a new shuffle led by the song that ended this one,
+ *           so it is not played twice in a row.
+ */
+template <class Storage>
+typename IndexLinkedQueue<Storage>::NodeIndex IndexLinkedQueue<Storage>::wrapAround()
+{
+	if (!isShuffled() || size() == 1) {
+		return storage().next(kSentinel, isShuffled());
+	}
+
+	// Every song has been played, so nothing can be left in the sub queue
+	IndexLinkedState& state = storage().state();
+	state.subQueueTail = state.currSong;
+	shuffle(false);
+	return storage().next(state.currSong, true);
+}
+
+
+/*!
+ *  @brief   Moves currSong to next song if available
+ *
+ *  @param[in]   repeatMode  Enum for what RepeatMode is set to within the Player.
+ *                           once keeps playing currSong, on wraps around to the start of the queue.
+ *
+ *  @return  True if moved forward successfully. Only returns false when currSong is the last in queue and repeat is off
+ */
+template <class Storage>
+bool IndexLinkedQueue<Storage>::nextSong(const RepeatMode repeatMode)
+{
+	IndexLinkedState& state = storage().state();
+	if (state.currSong == kSentinel) {
+		return false;
+	}
+	if (repeatMode == RepeatMode::once) {
+		return true;
+	}
+
+	NodeIndex next = storage().next(state.currSong, isShuffled());
+	if (next == kSentinel) {
+		if (repeatMode != RepeatMode::on) {
+			return false;
+		}
+		next = wrapAround();
+	}
+
+	if (state.subQueueTail == state.currSong) {
+		state.subQueueTail = next;
+	}
+	state.currSong = next;
+	return true;
+}
+
+
+/*!
+ *  @brief   Moves currSong to previous if available
+ *  @return  True if moved back successfully. Only returns false when currSong is the first in queue
+ */
+template <class Storage>
+bool IndexLinkedQueue<Storage>::prevSong()
+{
+	IndexLinkedState& state = storage().state();
+	if (state.currSong == kSentinel) {
+		return false;
+	}
+
+	NodeIndex prev = storage().prev(state.currSong, isShuffled());
+	if (prev == kSentinel) {
+		return false;
+	}
+
+	if (state.subQueueTail == state.currSong) {
+		state.subQueueTail = prev;
+	}
+	state.currSong = prev;
+	return true;
+}
+
+
+/*!
+ *  @brief   Removes all items from the queue, the storage keeps its capacity for reuse
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::clear()
+{
+	storage().clearRecords();
+	for (int shuffled = 0; shuffled < 2; ++shuffled) {
+		storage().next(kSentinel, shuffled != 0) = kSentinel;
+		storage().prev(kSentinel, shuffled != 0) = kSentinel;
+	}
+
+	IndexLinkedState& state = storage().state();
+	state.freeList = kSentinel;
+	state.subQueueTail = kSentinel;
+	state.currSong = kSentinel;
+	state.size = 0;
+}
+
+
+/*!
+ *  @brief   Should only be used when only one item needs to be accessed.
+ *  @return  Returns pointer to Song at songIndex, or nullptr if songIndex is out of range
+ */
+template <class Storage>
+Song const * IndexLinkedQueue<Storage>::getSongAt(int songIndex) const
+{
+	if (songIndex < 0 || songIndex >= size()) {
+		return nullptr;
+	}
+
+	return &storage().song(nodeAt(songIndex, isShuffled()));
+}
+
+
+template <class Storage>
+bool IndexLinkedQueue<Storage>::isEmpty() const
+{
+	return size() == 0;
+}
+
+template <class Storage>
+bool IndexLinkedQueue<Storage>::isShuffled() const
+{
+	return storage().state().shuffled != 0;
+}
+
+template <class Storage>
+int IndexLinkedQueue<Storage>::size() const
+{
+	return storage().state().size;
+}
+
+
+/*!
+ *  @brief   Seed the next shuffle will use. Queues with the same songs and seed shuffle alike.
+ */
+template <class Storage>
+std::uint64_t IndexLinkedQueue<Storage>::getShuffleSeed() const
+{
+	return storage().state().shuffleSeed;
+}
+
+
+/*!
+ *  @brief       Jumps to the song at songIndex in the current order
+ *  @param[in]   songIndex  Index of the song to play
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::setCurrSong(const int& songIndex)
+{
+	if (songIndex < 0 || songIndex >= size()) {
+		throw std::invalid_argument("songIndex is out of bounds");
+	}
+
+	// Jumping onto or past the end of the sub queue consumes it
+	IndexLinkedState& state = storage().state();
+	bool consumed = state.subQueueTail == kSentinel || state.subQueueTail == state.currSong;
+	NodeIndex node = storage().next(kSentinel, isShuffled());
+	for (int i = 0; i < songIndex; ++i) {
+		consumed = consumed || node == state.subQueueTail;
+		node = storage().next(node, isShuffled());
+	}
+
+	if (consumed || node == state.subQueueTail) {
+		state.subQueueTail = node;
+	}
+	state.currSong = node;
+}
+
+template <class Storage>
+void IndexLinkedQueue<Storage>::setShuffled(const bool& shuffled)
+{
+	storage().state().shuffled = shuffled ? 1 : 0;
+	if (shuffled) {
+		shuffle(true);
+	}
+}
+
+
+/*!
+ *  @brief       Sets the seed of the next shuffle, the current shuffled order is kept
+ *  @param[in]   seed   Any value, each shuffle advances it so repeated shuffles differ
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::setShuffleSeed(std::uint64_t seed)
+{
+	storage().state().shuffleSeed = seed;
+}
+
+
+/*!
+ *  @brief       Rebuilds the shuffled order from the unshuffled one, in the same order SongQueue draws it:
+ *               the songs before currSong in random order, then currSong followed by the sub queue in order,
+ *               then every other song in random order.
+ *               Only the draw order is held in memory while it runs, 4 bytes per song.
+ *  @param[in]   keepPlayed   Whether the songs before currSong stay before it, otherwise they are still to come
+ */
+template <class Storage>
+void IndexLinkedQueue<Storage>::shuffle(const bool& keepPlayed)
+{
+	IndexLinkedState& state = storage().state();
+	ShuffleRng rng;
+	rng.seed(state.shuffleSeed);
+	ShuffleRng::splitMix(state.shuffleSeed);
+
+	if (isEmpty()) {
+		return;
+	}
+
+	const NodeIndex curr = state.currSong;
+	std::vector<NodeIndex> order;
+	order.reserve(size());
+	if (curr != kSentinel) {
+		order.push_back(curr);
+	}
+
+	// The sub queue only counts if it actually follows currSong in the unshuffled order
+	if (state.subQueueTail != kSentinel && state.subQueueTail != curr) {
+		for (NodeIndex node = storage().next(curr, false); node != state.subQueueTail; node = storage().next(node, false)) {
+			if (node == kSentinel) {
+				order.resize(curr != kSentinel ? 1 : 0);
+				state.subQueueTail = curr;
+				break;
+			}
+			order.push_back(node);
+		}
+		if (state.subQueueTail != curr) {
+			order.push_back(state.subQueueTail);
+		}
+	}
+	else {
+		state.subQueueTail = curr;
+	}
+
+	// currSong and the sub queue are one run in the unshuffled order, skip it whole.
+	// The songs before it have been played, they are moved ahead of it afterwards.
+	const std::size_t lead = order.size();
+	std::size_t played = 0;
+	bool passed = !keepPlayed || curr == kSentinel;
+	for (NodeIndex node = storage().next(kSentinel, false); node != kSentinel; node = storage().next(node, false)) {
+		if (lead != 0 && node == order[0]) {
+			for (std::size_t i = 1; i < lead; ++i) {
+				node = storage().next(node, false);
+			}
+			passed = true;
+			continue;
+		}
+		order.push_back(node);
+		played += passed ? 0 : 1;
+	}
+	std::rotate(order.begin(), order.begin() + lead, order.begin() + lead + played);
+
+	// Fisher-Yates over either side of the lead, split across threads for very large queues
+	auto shuffleRange = [&rng](NodeIndex* first, NodeIndex* last) {
+		const std::size_t count = static_cast<std::size_t>(last - first);
+		if (count >= ParallelShuffle::kThreshold) {
+			ParallelShuffle::shuffle(first, last, rng.next());
+			return;
+		}
+		for (std::size_t i = count; i > 1; --i) {
+			std::swap(first[i - 1], first[rng.below(static_cast<std::uint32_t>(i))]);
+		}
+	};
+	shuffleRange(order.data(), order.data() + played);
+	shuffleRange(order.data() + played + lead, order.data() + order.size());
+
+	// Every song writes its own prev and its predecessor's next, so blocks of the order relink independently
+	Storage& records = storage();
+	ParallelShuffle::forRange(order.size(), [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			const NodeIndex before = i == 0 ? kSentinel : order[i - 1];
+			records.next(before, true) = order[i];
+			records.prev(order[i], true) = before;
+		}
+	});
+	records.next(order.back(), true) = kSentinel;
+	records.prev(kSentinel, true) = order.back();
+}
+
+
+/*!
+ *  @brief   Takes a record off the free list, or adds one, and fills it with song
+ */
+template <class Storage>
+typename IndexLinkedQueue<Storage>::NodeIndex IndexLinkedQueue<Storage>::newNode(const Song& song)
+{
+	// Adding a record may move the state along with the records, so it is looked up again afterwards
+	NodeIndex node = storage().state().freeList;
+	if (node != kSentinel) {
+		storage().state().freeList = storage().next(node, false);
+		storage().song(node) = song;
+	}
+	else {
+		node = storage().addRecord(song);
+	}
+
+	for (int shuffled = 0; shuffled < 2; ++shuffled) {
+		storage().next(node, shuffled != 0) = kSentinel;
+		storage().prev(node, shuffled != 0) = kSentinel;
+	}
+	return node;
+}
+
+
+template <class Storage>
+void IndexLinkedQueue<Storage>::deleteNode(NodeIndex node)
+{
+	storage().next(node, false) = storage().state().freeList;
+	storage().state().freeList = node;
+}
+
+
+/*!
+ *  @brief   Walks to songIndex from whichever end of the order is closer, songIndex must be in range
+ */
+template <class Storage>
+typename IndexLinkedQueue<Storage>::NodeIndex IndexLinkedQueue<Storage>::nodeAt(int songIndex, const bool& shuffled) const
+{
+	NodeIndex node = kSentinel;
+	if (songIndex < size() / 2) {
+		for (int i = 0; i <= songIndex; ++i) {
+			node = storage().next(node, shuffled);
+		}
+	}
+	else {
+		for (int i = size(); i > songIndex; --i) {
+			node = storage().prev(node, shuffled);
+		}
+	}
+	return node;
+}
+
+
+template <class Storage>
+void IndexLinkedQueue<Storage>::insertAfter(NodeIndex pos, NodeIndex node, const bool& shuffled)
+{
+	NodeIndex next = storage().next(pos, shuffled);
+
+	storage().prev(node, shuffled) = pos;
+	storage().next(node, shuffled) = next;
+	storage().next(pos, shuffled) = node;
+	storage().prev(next, shuffled) = node;
+}
+
+
+template <class Storage>
+void IndexLinkedQueue<Storage>::unlink(NodeIndex node, const bool& shuffled)
+{
+	NodeIndex next = storage().next(node, shuffled);
+	NodeIndex prev = storage().prev(node, shuffled);
+
+	storage().next(prev, shuffled) = next;
+	storage().prev(next, shuffled) = prev;
+}
+
+
+template <class Storage>
+IndexLinkedQueue<Storage>::operator std::vector<Song>() const
+{
+	std::vector<Song> v;
+	v.reserve(size());
+
+	for (auto song : *this) {
+		v.push_back(*song);
+	}
+
+	return v;
+}
+
+
+/*!
+ *  @brief   Backs operator<<, outputs data as "Queue: [...]"
+ *  @return  Reference to ostream
+ */
+template <class Storage>
+std::ostream& IndexLinkedQueue<Storage>::print(std::ostream& out) const
+{
+	out << "Queue: [";
+
+	auto song = begin();
+	if (song != end()) {
+		out << (*song)->number;
+		++song;
+	}
+
+	for (; song != end(); ++song) {
+		out << ", " << (*song)->number;
+	}
+	out << "]";
+
+	const IndexLinkedState& state = storage().state();
+	if (state.currSong != kSentinel) {
+		out << " currSong: " << storage().song(state.currSong).number;
+	}
+	else {
+		out << " currSong: nullptr";
+	}
+
+	if (state.subQueueTail != kSentinel) {
+		out << " subQueueTail: " << storage().song(state.subQueueTail).number;
+	}
+	else {
+		out << " subQueueTail: nullptr";
+	}
+
+	return out;
+}
+
+
+// Iterator Implementation
+template <class Storage>
+IndexLinkedQueue<Storage>::Iterator::Iterator() noexcept :
+	m_queue(nullptr), m_currNode(kSentinel) { }
+
+template <class Storage>
+IndexLinkedQueue<Storage>::Iterator::Iterator(const IndexLinkedQueue& songQueue, NodeIndex node) noexcept :
+	m_queue(&songQueue), m_currNode(node) { }
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator IndexLinkedQueue<Storage>::begin() const
+{
+	return Iterator(*this, storage().next(kSentinel, isShuffled()));
+}
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator IndexLinkedQueue<Storage>::end() const
+{
+	return Iterator(*this, kSentinel);
+}
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator IndexLinkedQueue<Storage>::rbegin() const
+{
+	return Iterator(*this, storage().prev(kSentinel, isShuffled()));
+}
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator IndexLinkedQueue<Storage>::rend() const
+{
+	return Iterator(*this, kSentinel);
+}
+
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator& IndexLinkedQueue<Storage>::Iterator::operator++()
+{
+	m_currNode = m_queue->storage().next(m_currNode, m_queue->isShuffled());
+	return *this;
+}
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator IndexLinkedQueue<Storage>::Iterator::operator++(int)
+{
+	Iterator iter = *this;
+	++* this;
+	return iter;
+}
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator& IndexLinkedQueue<Storage>::Iterator::operator--()
+{
+	m_currNode = m_queue->storage().prev(m_currNode, m_queue->isShuffled());
+	return *this;
+}
+
+template <class Storage>
+typename IndexLinkedQueue<Storage>::Iterator IndexLinkedQueue<Storage>::Iterator::operator--(int)
+{
+	Iterator iter = *this;
+	--* this;
+	return iter;
+}
+
+template <class Storage>
+bool IndexLinkedQueue<Storage>::Iterator::operator==(const Iterator& iter) const
+{
+	return m_currNode == iter.m_currNode;
+}
+
+template <class Storage>
+bool IndexLinkedQueue<Storage>::Iterator::operator!=(const Iterator& iter) const
+{
+	return m_currNode != iter.m_currNode;
+}
+
+template <class Storage>
+Song const * IndexLinkedQueue<Storage>::Iterator::operator*() const
+{
+	return &m_queue->storage().song(m_currNode);
+}
+
+
+#endif
@@ -0,0 +1,256 @@
+#include <stdexcept>
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+/*!
+ *  @brief       Opens the file at path for reading and writing, creating it empty if it does not exist
+ */
+MappedFile::MappedFile(const std::string& path) :
+	m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr), m_data(nullptr), m_size(0)
+{
+	m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+		OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("cannot open " + path);
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size)) {
+		CloseHandle(m_file);
+		throw std::runtime_error("cannot read the size of " + path);
+	}
+	m_size = static_cast<std::size_t>(size.QuadPart);
+
+	try {
+		map();
+	}
+	catch (...) {
+		CloseHandle(m_file);
+		throw;
+	}
+}
+
+
+MappedFile::~MappedFile()
+{
+	unmap();
+	CloseHandle(m_file);
+}
+
+
+/*!
+ *  @brief       Grows or shrinks the file to size bytes and maps it again, data() moves
+ */
+void MappedFile::resize(std::size_t size)
+{
+	unmap();
+
+	LARGE_INTEGER end;
+	end.QuadPart = static_cast<LONGLONG>(size);
+	if (!SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file)) {
+		map();
+		throw std::runtime_error("cannot resize mapped file");
+	}
+
+	m_size = size;
+	map();
+}
+
+
+/*!
+ *  @brief   Writes dirty pages back to the file and waits for the disk
+ */
+void MappedFile::flush()
+{
+	if (m_data != nullptr) {
+		FlushViewOfFile(m_data, 0);
+		FlushFileBuffers(m_file);
+	}
+}
+
+
+/*!
+ *  @brief       Drops the pages in a range from the resident set, they are read back on next touch.
+ *  @param[in]   offset, length   Byte range, offset must be a multiple of pageSize()
+ *               Unlocking pages that were never locked removes them from the working set.
+ */
+void MappedFile::release(std::size_t offset, std::size_t length)
+{
+	if (m_data != nullptr && length != 0) {
+		VirtualUnlock(m_data + offset, length);
+	}
+}
+
+
+std::size_t MappedFile::pageSize()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+}
+
+
+void MappedFile::map()
+{
+	if (m_size == 0) {
+		return;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+	if (m_mapping == nullptr) {
+		throw std::runtime_error("cannot map file");
+	}
+	m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_size));
+	if (m_data == nullptr) {
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+		throw std::runtime_error("cannot map file");
+	}
+}
+
+
+void MappedFile::unmap()
+{
+	if (m_data != nullptr) {
+		UnmapViewOfFile(m_data);
+		m_data = nullptr;
+	}
+	if (m_mapping != nullptr) {
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+}
+
+#else
+
+/*!
+ *  @brief       Opens the file at path for reading and writing, creating it empty if it does not exist
+ */
+MappedFile::MappedFile(const std::string& path) :
+	m_file(-1), m_data(nullptr), m_size(0)
+{
+	m_file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (m_file < 0) {
+		throw std::runtime_error("cannot open " + path);
+	}
+
+	struct stat info;
+	if (fstat(m_file, &info) != 0) {
+		close(m_file);
+		throw std::runtime_error("cannot read the size of " + path);
+	}
+	m_size = static_cast<std::size_t>(info.st_size);
+
+	try {
+		map();
+	}
+	catch (...) {
+		close(m_file);
+		throw;
+	}
+}
+
+
+MappedFile::~MappedFile()
+{
+	unmap();
+	close(m_file);
+}
+
+
+/*!
+ *  @brief       Grows or shrinks the file to size bytes and maps it again, data() moves
+ */
+void MappedFile::resize(std::size_t size)
+{
+	unmap();
+
+	if (ftruncate(m_file, static_cast<off_t>(size)) != 0) {
+		map();
+		throw std::runtime_error("cannot resize mapped file");
+	}
+
+	m_size = size;
+	map();
+}
+
+
+/*!
+ *  @brief   Writes dirty pages back to the file and waits for the disk
+ */
+void MappedFile::flush()
+{
+	if (m_data != nullptr) {
+		msync(m_data, m_size, MS_SYNC);
+	}
+}
+
+
+/*!
+ *  @brief       Drops the pages in a range from the resident set, they are read back on next touch.
+ *  @param[in]   offset, length   Byte range, offset must be a multiple of pageSize()
+ *               The mapping is shared, so dirty pages stay in the page cache and nothing is lost.
+ */
+void MappedFile::release(std::size_t offset, std::size_t length)
+{
+	if (m_data != nullptr && length != 0) {
+		madvise(m_data + offset, length, MADV_DONTNEED);
+	}
+}
+
+
+std::size_t MappedFile::pageSize()
+{
+	return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+
+void MappedFile::map()
+{
+	if (m_size == 0) {
+		return;
+	}
+
+	void* data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+	if (data == MAP_FAILED) {
+		throw std::runtime_error("cannot map file");
+	}
+	m_data = static_cast<unsigned char*>(data);
+}
+
+
+void MappedFile::unmap()
+{
+	if (m_data != nullptr) {
+		munmap(m_data, m_size);
+		m_data = nullptr;
+	}
+}
+
+#endif
+
+
+unsigned char* MappedFile::data() const
+{
+	return m_data;
+}
+
+
+std::size_t MappedFile::size() const
+{
+	return m_size;
+}
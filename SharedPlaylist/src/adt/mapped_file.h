@@ -0,0 +1,48 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+
+/// Read/write shared mapping of a whole file, POSIX mmap or Win32 file mapping underneath.
+/// Pages are loaded on first touch and written back by the OS, so only the parts of the file in
+/// use count towards the process' resident memory, and release() can hand those back early.
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	void resize(std::size_t size);
+	void flush();
+	void release(std::size_t offset, std::size_t length);
+
+	// GETTERS
+	unsigned char* data() const;
+	std::size_t size() const;
+	static std::size_t pageSize();
+
+private:
+
+	// No copying from MappedFile
+	MappedFile(const MappedFile&) = delete;
+	void operator=(const MappedFile&) = delete;
+
+	void map();
+	void unmap();
+
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+
+	/// Start of the mapping, nullptr while the file is empty. Moves on every resize().
+	unsigned char* m_data;
+	std::size_t m_size;
+};
+
+
+#endif
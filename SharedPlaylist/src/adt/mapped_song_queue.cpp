@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "mapped_song_queue.h"
+
+
+/*!
+ *  @brief       Opens the queue stored at path, or starts an empty one there if the file is new or empty
+ *  @param[in]   path   File backing the queue, it keeps the queue after the object is gone
+ */
+MappedSongQueue::MappedSongQueue(const std::string& path) :
+	m_file(path), m_header(nullptr), m_records(nullptr)
+{
+	static_assert(std::is_trivially_copyable<Song>::value, "Songs are stored in the file as raw bytes");
+	static_assert(sizeof(Header) <= 64, "the header has to fit in front of the records");
+
+	open();
+}
+
+
+MappedSongQueue::~MappedSongQueue()
+{
+
+}
+
+
+/*!
+ *  @brief       Grows the file so count songs fit without remapping
+ */
+void MappedSongQueue::reserve(int count)
+{
+	if (count >= 0 && static_cast<NodeIndex>(count) >= m_header->capacity) {
+		grow(static_cast<NodeIndex>(count) + 1);
+	}
+}
+
+
+/*!
+ *  @brief   Writes every change made so far to disk, without it the OS writes them back in its own time
+ */
+void MappedSongQueue::flush()
+{
+	m_file.flush();
+}
+
+
+/*!
+ *  @brief       Drops every page from resident memory except the ones holding the header and the songs
+ *               from before songs ahead of currSong to after songs past it. Call it as playback moves on,
+ *               pages dropped are read back from the file if they are touched again.
+ *  @param[in]   before, after   Songs either side of currSong to keep, e.g. the window a client shows
+ */
+void MappedSongQueue::trim(int before, int after)
+{
+	const std::size_t page = MappedFile::pageSize();
+	std::vector<std::size_t> keep;
+
+	auto keepRecord = [&](NodeIndex node) {
+		std::size_t offset = recordsOffset() + static_cast<std::size_t>(node) * sizeof(Record);
+		keep.push_back(offset / page);
+		keep.push_back((offset + sizeof(Record) - 1) / page);
+	};
+
+	keep.push_back(0);
+	keepRecord(kSentinel);
+
+	NodeIndex curr = state().currSong;
+	if (curr != kSentinel) {
+		keepRecord(curr);
+
+		NodeIndex node = curr;
+		for (int i = 0; i < before && node != kSentinel; ++i) {
+			node = prev(node, isShuffled());
+			keepRecord(node);
+		}
+		node = curr;
+		for (int i = 0; i < after && node != kSentinel; ++i) {
+			node = next(node, isShuffled());
+			keepRecord(node);
+		}
+	}
+
+	std::sort(keep.begin(), keep.end());
+	keep.erase(std::unique(keep.begin(), keep.end()), keep.end());
+
+	// Release the gaps in between kept pages, then everything past the last one
+	const std::size_t pages = (m_file.size() + page - 1) / page;
+	std::size_t start = 0;
+	for (std::size_t kept : keep) {
+		if (kept > start) {
+			m_file.release(start * page, (kept - start) * page);
+		}
+		start = kept + 1;
+	}
+	if (pages > start) {
+		m_file.release(start * page, m_file.size() - start * page);
+	}
+}
+
+
+/*!
+ *  @brief   Bytes the backing file takes on disk, only the pages in use count towards memory
+ */
+std::size_t MappedSongQueue::fileSize() const
+{
+	return m_file.size();
+}
+
+
+/*!
+ *  @brief   Sets up a new file, or checks that an existing one holds a queue this version can read
+ */
+void MappedSongQueue::open()
+{
+	if (m_file.size() == 0) {
+		grow(kMinCapacity);
+
+		m_header->magic = kMagic;
+		m_header->version = kVersion;
+		m_header->recordSize = sizeof(Record);
+		m_header->state.shuffled = 0;
+		m_header->state.shuffleSeed = (std::uint64_t(std::random_device{}()) << 32) | std::random_device{}();
+		clear();
+		return;
+	}
+
+	if (m_file.size() < recordsOffset()) {
+		throw std::invalid_argument("file does not hold a MappedSongQueue");
+	}
+	attach();
+
+	const Header& header = *m_header;
+	if (header.magic != kMagic || header.recordSize != sizeof(Record)) {
+		throw std::invalid_argument("file does not hold a MappedSongQueue");
+	}
+	if (header.version != kVersion) {
+		throw std::invalid_argument("MappedSongQueue file has an unsupported format version");
+	}
+	if (m_file.size() < recordsOffset() + static_cast<std::size_t>(header.capacity) * sizeof(Record) ||
+		header.used == 0 || header.used > header.capacity || header.state.size < 0 ||
+		static_cast<NodeIndex>(header.state.size) >= header.used || header.state.freeList >= header.used ||
+		header.state.subQueueTail >= header.used || header.state.currSong >= header.used) {
+		throw std::invalid_argument("MappedSongQueue file is truncated or corrupt");
+	}
+}
+
+
+/*!
+ *  @brief   Points the header and records at the current mapping
+ */
+void MappedSongQueue::attach()
+{
+	m_header = reinterpret_cast<Header*>(m_file.data());
+	m_records = reinterpret_cast<Record*>(m_file.data() + recordsOffset());
+}
+
+
+/*!
+ *  @brief       Resizes the file to hold capacity records, which moves the mapping
+ */
+void MappedSongQueue::grow(NodeIndex capacity)
+{
+	m_file.resize(recordsOffset() + static_cast<std::size_t>(capacity) * sizeof(Record));
+	attach();
+	m_header->capacity = capacity;
+}
+
+
+std::size_t MappedSongQueue::recordsOffset()
+{
+	return 64;
+}
+
+
+
+
+/*!
+ *  @brief   Hands out the next unused record filled with song, growing the file when it is full.
+ *           Growing moves the mapping, so the header and every record move with it.
+ */
+MappedSongQueue::NodeIndex MappedSongQueue::addRecord(const Song& song)
+{
+	if (m_header->used == std::numeric_limits<NodeIndex>::max()) {
+		throw std::length_error("MappedSongQueue is limited to 2^32 - 1 songs");
+	}
+	if (m_header->used == m_header->capacity) {
+		const NodeIndex capacity = m_header->capacity;
+		grow(capacity > std::numeric_limits<NodeIndex>::max() / 2 ? std::numeric_limits<NodeIndex>::max() : capacity * 2);
+	}
+
+	NodeIndex node = m_header->used++;
+	m_records[node].song = song;
+	return node;
+}
+
+
+/*!
+ *  @brief   Hands every record but the sentinel back, the file keeps its size for reuse
+ */
+void MappedSongQueue::clearRecords()
+{
+	m_header->used = 1;
+}
@@ -0,0 +1,119 @@
+#ifndef MAPPED_QUEUE_H
+#define MAPPED_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "song.h"
+#include "index_linked_queue.h"
+#include "mapped_file.h"
+
+
+/// Storage mode for very large queues, with CompactSongQueue's layout kept in a memory mapped file.
+/// Each song is a fixed size record holding the song and its 32-bit links in both orders, and a
+/// header page holds the rest of the state, so reopening the file restores the queue exactly as it was.
+/// The OS pages records in as they are touched, trim() hands back every page outside the window
+/// around currSong, keeping resident memory flat however long the queue is.
+///
+/// Like CompactSongQueue, index based operations walk the list, and a shuffle reorders it eagerly.
+/// Reopening only checks the header, links are range checked as they are followed, so a damaged
+/// file throws when the damaged part is reached rather than reading past the mapping.
+/// Song pointers are invalidated whenever the file grows, iterators are not.
+class MappedSongQueue : public IndexLinkedQueue<MappedSongQueue>
+{
+public:
+	explicit MappedSongQueue(const std::string& path);
+	~MappedSongQueue();
+
+	void reserve(int count);
+	void flush();
+	void trim(int before, int after);
+
+	// GETTERS
+	std::size_t fileSize() const;
+
+private:
+	friend class IndexLinkedQueue<MappedSongQueue>;
+
+	// No copying from MappedSongQueue
+	MappedSongQueue(const MappedSongQueue&) = delete;
+	void operator=(const MappedSongQueue&) = delete;
+
+	/// "SPM" followed by the format version, bumped whenever the file layout changes
+	static const std::uint32_t kMagic = 0x004D5053u;
+	static const std::uint32_t kVersion = 2;
+	static const NodeIndex kMinCapacity = 1024;
+
+	/// Links indexed by the shuffled flag
+	struct Record
+	{
+		Song song;
+		NodeIndex next[2];
+		NodeIndex prev[2];
+	};
+
+	/// Everything but the records, stored in place at the start of the file
+	struct Header
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t recordSize;
+		/// Records the file has room for, and records handed out so far, both counting the sentinel
+		NodeIndex capacity;
+		NodeIndex used;
+
+		IndexLinkedState state;
+	};
+
+	Record& record(NodeIndex node);
+	const Record& record(NodeIndex node) const;
+	Song& song(NodeIndex node) { return record(node).song; }
+	const Song& song(NodeIndex node) const { return record(node).song; }
+	NodeIndex& next(NodeIndex node, bool shuffled) { return record(node).next[shuffled]; }
+	NodeIndex next(NodeIndex node, bool shuffled) const { return record(node).next[shuffled]; }
+	NodeIndex& prev(NodeIndex node, bool shuffled) { return record(node).prev[shuffled]; }
+	NodeIndex prev(NodeIndex node, bool shuffled) const { return record(node).prev[shuffled]; }
+	IndexLinkedState& state() { return m_header->state; }
+	const IndexLinkedState& state() const { return m_header->state; }
+
+	NodeIndex addRecord(const Song& song);
+	void clearRecords();
+
+	void open();
+	void attach();
+	void grow(NodeIndex capacity);
+	static std::size_t recordsOffset();
+
+
+	MappedFile m_file;
+
+	/// Point into m_file, refreshed by attach() whenever the mapping moves
+	Header* m_header;
+	Record* m_records;
+};
+
+
+/*!
+ *  @brief   Record node, checked against the records handed out since links come straight from the file
+ */
+inline MappedSongQueue::Record& MappedSongQueue::record(NodeIndex node)
+{
+	if (node >= m_header->used) {
+		throw std::invalid_argument("MappedSongQueue file is truncated or corrupt");
+	}
+	return m_records[node];
+}
+
+
+inline const MappedSongQueue::Record& MappedSongQueue::record(NodeIndex node) const
+{
+	if (node >= m_header->used) {
+		throw std::invalid_argument("MappedSongQueue file is truncated or corrupt");
+	}
+	return m_records[node];
+}
+
+
+#endif
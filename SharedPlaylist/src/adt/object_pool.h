@@ -0,0 +1,207 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+/// Slab allocator for objects of a single type.
+/// Objects are carved out of slabs and freed slots are reused through a free list,
+/// so once the pool has grown to its working size create() and destroy() never touch the global allocator.
+/// Slabs double from kFirstSlabSize up to SlabSize, so pools that stay small stay cheap.
+/// Slabs come from Allocator, rebound to the pool's slot type.
+template <class T, int SlabSize = 256, class Allocator = std::allocator<T>>
+class ObjectPool
+{
+public:
+	explicit ObjectPool(const Allocator& allocator = Allocator());
+	~ObjectPool();
+
+	template <class... Args>
+	T* create(Args&&... args);
+	void destroy(T* obj);
+
+	void releaseAll();
+	void reserve(int count);
+
+	// GETTERS
+	int capacity() const;
+	std::size_t memoryUsage() const;
+
+private:
+
+	// No copying from ObjectPool
+	ObjectPool(const ObjectPool&) = delete;
+	void operator=(const ObjectPool&) = delete;
+
+	static const int kFirstSlabSize = SlabSize < 16 ? SlabSize : 16;
+
+	union Slot
+	{
+		Slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+	using SlotTraits = std::allocator_traits<SlotAllocator>;
+
+	Slot* allocateSlot();
+	void addSlab();
+	static int slabSize(int slab);
+
+	SlotAllocator m_allocator;
+	/// Slab i holds slabSize(i) slots
+	std::vector<typename SlotTraits::pointer> m_slabs;
+	Slot* m_freeList;
+	int m_capacity;
+
+	/// Bump position, slots past it in m_slabs[m_slab] have never been handed out since the last releaseAll()
+	int m_slab;
+	int m_slot;
+};
+
+
+template <class T, int SlabSize, class Allocator>
+ObjectPool<T, SlabSize, Allocator>::ObjectPool(const Allocator& allocator) :
+	m_allocator(allocator), m_freeList(nullptr), m_capacity(0), m_slab(0), m_slot(0) { }
+
+
+/*!
+ *  @brief   Gives the slabs back to the allocator. Destructors are not run, as with releaseAll().
+ */
+template <class T, int SlabSize, class Allocator>
+ObjectPool<T, SlabSize, Allocator>::~ObjectPool()
+{
+	for (std::size_t slab = 0; slab < m_slabs.size(); ++slab) {
+		SlotTraits::deallocate(m_allocator, m_slabs[slab], slabSize(static_cast<int>(slab)));
+	}
+}
+
+
+/*!
+ *  @brief       Constructs a T in a pooled slot
+ *  @param[in]   args   Forwarded to the constructor of T
+ *  @return      Pointer to the new object, must be given back with destroy() or releaseAll()
+ */
+template <class T, int SlabSize, class Allocator>
+template <class... Args>
+T* ObjectPool<T, SlabSize, Allocator>::create(Args&&... args)
+{
+	Slot* slot = allocateSlot();
+	try {
+		return new (slot->storage) T(std::forward<Args>(args)...);
+	}
+	catch (...) {
+		slot->next = m_freeList;
+		m_freeList = slot;
+		throw;
+	}
+}
+
+
+/*!
+ *  @brief       Destroys obj and puts its slot on the free list
+ */
+template <class T, int SlabSize, class Allocator>
+void ObjectPool<T, SlabSize, Allocator>::destroy(T* obj)
+{
+	if (obj == nullptr) {
+		return;
+	}
+
+	obj->~T();
+	Slot* slot = reinterpret_cast<Slot*>(obj);
+	slot->next = m_freeList;
+	m_freeList = slot;
+}
+
+
+/*!
+ *  @brief   Gives every slot back to the pool at once, keeping the slabs for reuse.
+ *           Destructors are not run, so T should be trivially destructible or already destroyed.
+ */
+template <class T, int SlabSize, class Allocator>
+void ObjectPool<T, SlabSize, Allocator>::releaseAll()
+{
+	m_freeList = nullptr;
+	m_slab = 0;
+	m_slot = 0;
+}
+
+
+/*!
+ *  @brief       Grows the pool so it can hold at least count live objects without allocating
+ *  @param[in]   count   Number of objects to make room for
+ */
+template <class T, int SlabSize, class Allocator>
+void ObjectPool<T, SlabSize, Allocator>::reserve(int count)
+{
+	while (capacity() < count) {
+		addSlab();
+	}
+}
+
+
+template <class T, int SlabSize, class Allocator>
+int ObjectPool<T, SlabSize, Allocator>::capacity() const
+{
+	return m_capacity;
+}
+
+
+/*!
+ *  @brief   Bytes held by the pool, live or free
+ */
+template <class T, int SlabSize, class Allocator>
+std::size_t ObjectPool<T, SlabSize, Allocator>::memoryUsage() const
+{
+	return m_slabs.capacity() * sizeof(m_slabs[0]) + static_cast<std::size_t>(capacity()) * sizeof(Slot);
+}
+
+
+template <class T, int SlabSize, class Allocator>
+typename ObjectPool<T, SlabSize, Allocator>::Slot* ObjectPool<T, SlabSize, Allocator>::allocateSlot()
+{
+	if (m_freeList != nullptr) {
+		Slot* slot = m_freeList;
+		m_freeList = slot->next;
+		return slot;
+	}
+
+	if (m_slab < static_cast<int>(m_slabs.size()) && m_slot == slabSize(m_slab)) {
+		m_slab += 1;
+		m_slot = 0;
+	}
+	if (m_slab == static_cast<int>(m_slabs.size())) {
+		addSlab();
+	}
+
+	return &m_slabs[m_slab][m_slot++];
+}
+
+
+template <class T, int SlabSize, class Allocator>
+void ObjectPool<T, SlabSize, Allocator>::addSlab()
+{
+	const int size = slabSize(static_cast<int>(m_slabs.size()));
+	m_slabs.reserve(m_slabs.size() + 1);
+	m_slabs.push_back(SlotTraits::allocate(m_allocator, size));
+	m_capacity += size;
+}
+
+
+template <class T, int SlabSize, class Allocator>
+int ObjectPool<T, SlabSize, Allocator>::slabSize(int slab)
+{
+	int size = kFirstSlabSize;
+	for (; slab > 0 && size < SlabSize; --slab) {
+		size *= 2;
+	}
+	return size < SlabSize ? size : SlabSize;
+}
+
+
+#endif
@@ -0,0 +1,50 @@
+#include <atomic>
+#include <system_error>
+#include <thread>
+
+#include "parallel_shuffle.h"
+
+
+const std::size_t ParallelShuffle::kThreshold;
+const int ParallelShuffle::kBlocks;
+const int ParallelShuffle::kBucketBits;
+
+
+/*!
+ *  @brief   Threads a shuffle uses by default, one per hardware thread
+ */
+int ParallelShuffle::threadCount()
+{
+	const unsigned int hardware = std::thread::hardware_concurrency();
+	return hardware != 0 ? static_cast<int>(std::min(hardware, static_cast<unsigned int>(kBlocks))) : 1;
+}
+
+
+/*!
+ *  @brief       Runs task(0) to task(tasks - 1), handed out to up to threads threads including the calling one
+ *  @param[in]   threads   If the system can not start that many, the threads that did start do the rest
+ */
+void ParallelShuffle::run(int tasks, int threads, const std::function<void(int)>& task)
+{
+	std::atomic<int> nextTask(0);
+	auto worker = [&]() {
+		for (int i = nextTask.fetch_add(1); i < tasks; i = nextTask.fetch_add(1)) {
+			task(i);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < std::min(threads, tasks); ++i) {
+		try {
+			workers.emplace_back(worker);
+		}
+		catch (const std::system_error&) {
+			break;
+		}
+	}
+
+	worker();
+	for (std::thread& thread : workers) {
+		thread.join();
+	}
+}
@@ -0,0 +1,144 @@
+#ifndef PARALLEL_SHUFFLE_H
+#define PARALLEL_SHUFFLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "shuffle_rng.h"
+
+
+/// Shuffle for very large queues, split across threads.
+/// Every item draws a random bucket, the buckets are filled in order and each one is Fisher-Yates shuffled
+/// on its own, which gives a uniform permutation. Items and buckets are cut into a fixed number of blocks,
+/// each with its own PRNG stream derived from the seed, so the result depends only on the seed and the
+/// items, never on how many threads ran it, and queues with the same songs and seed still shuffle alike.
+class ParallelShuffle
+{
+public:
+	/// Queues shuffle at least this many songs this way, shorter ranges stay on the serial Fisher-Yates
+	static const std::size_t kThreshold = std::size_t(1) << 18;
+	/// Blocks of items and buckets, a unit of work for one thread
+	static const int kBlocks = 64;
+
+	template <class T>
+	static void shuffle(T* first, T* last, std::uint64_t seed, int threads = threadCount());
+
+	template <class Body>
+	static void forRange(std::size_t count, Body body, int threads = threadCount());
+
+	static int threadCount();
+	static void run(int tasks, int threads, const std::function<void(int)>& task);
+
+private:
+	/// log2(kBlocks), the bits one item's bucket takes from a draw
+	static const int kBucketBits = 6;
+
+	static ShuffleRng streamOf(std::uint64_t seed, int stream);
+	static std::size_t blockBegin(std::size_t count, int block);
+};
+
+
+/*!
+ *  @brief       Shuffles [first, last) uniformly at random
+ *  @param[in]   seed      The same seed shuffles the same items alike
+ *  @param[in]   threads   Threads to use, 1 runs everything on the calling thread
+ */
+template <class T>
+void ParallelShuffle::shuffle(T* first, T* last, std::uint64_t seed, int threads)
+{
+	const std::size_t count = static_cast<std::size_t>(last - first);
+	if (count < 2) {
+		return;
+	}
+
+	// Pass 1: every item draws its bucket, each block counts how many of its items went to each bucket.
+	// kBlocks is a power of two, so one 64-bit draw holds the buckets of ten items.
+	std::vector<std::uint8_t> bucketOf(count);
+	std::vector<std::size_t> offsets(kBlocks * kBlocks, 0);
+	run(kBlocks, threads, [&](int block) {
+		ShuffleRng rng = streamOf(seed, block);
+		std::size_t* counts = &offsets[block * kBlocks];
+		std::uint64_t bits = 0;
+		int bitsLeft = 0;
+		for (std::size_t i = blockBegin(count, block); i < blockBegin(count, block + 1); ++i) {
+			if (bitsLeft == 0) {
+				bits = rng.next();
+				bitsLeft = 64 / kBucketBits;
+			}
+			bucketOf[i] = static_cast<std::uint8_t>(bits & (kBlocks - 1));
+			bits >>= kBucketBits;
+			bitsLeft -= 1;
+			counts[bucketOf[i]] += 1;
+		}
+	});
+
+	// Where each block's share of each bucket starts, buckets in order and blocks in order within them
+	std::vector<std::size_t> bucketBegin(kBlocks + 1, 0);
+	std::size_t offset = 0;
+	for (int bucket = 0; bucket < kBlocks; ++bucket) {
+		bucketBegin[bucket] = offset;
+		for (int block = 0; block < kBlocks; ++block) {
+			const std::size_t blockCount = offsets[block * kBlocks + bucket];
+			offsets[block * kBlocks + bucket] = offset;
+			offset += blockCount;
+		}
+	}
+	bucketBegin[kBlocks] = count;
+
+	// Pass 2: items move to their bucket, keeping their order
+	std::vector<T> buckets(count);
+	run(kBlocks, threads, [&](int block) {
+		std::size_t* next = &offsets[block * kBlocks];
+		for (std::size_t i = blockBegin(count, block); i < blockBegin(count, block + 1); ++i) {
+			buckets[next[bucketOf[i]]++] = first[i];
+		}
+	});
+
+	// Pass 3: each bucket is shuffled on its own and copied back
+	run(kBlocks, threads, [&](int bucket) {
+		ShuffleRng rng = streamOf(seed, kBlocks + bucket);
+		T* items = buckets.data() + bucketBegin[bucket];
+		const std::size_t size = bucketBegin[bucket + 1] - bucketBegin[bucket];
+		for (std::size_t i = size; i > 1; --i) {
+			std::swap(items[i - 1], items[rng.below(static_cast<std::uint32_t>(i))]);
+		}
+		std::copy(items, items + size, first + bucketBegin[bucket]);
+	});
+}
+
+
+/*!
+ *  @brief       Calls body(begin, end) over consecutive blocks covering [0, count), on several threads
+ *               once count reaches kThreshold. The blocks can run in any order and at the same time.
+ */
+template <class Body>
+void ParallelShuffle::forRange(std::size_t count, Body body, int threads)
+{
+	if (count < kThreshold || threads <= 1) {
+		body(std::size_t(0), count);
+		return;
+	}
+
+	run(kBlocks, threads, [&](int block) {
+		body(blockBegin(count, block), blockBegin(count, block + 1));
+	});
+}
+
+
+inline ShuffleRng ParallelShuffle::streamOf(std::uint64_t seed, int stream)
+{
+	std::uint64_t state = seed ^ (static_cast<std::uint64_t>(stream) * 0xD1B54A32D192ED03ull);
+	return ShuffleRng(ShuffleRng::splitMix(state));
+}
+
+
+inline std::size_t ParallelShuffle::blockBegin(std::size_t count, int block)
+{
+	return count / kBlocks * block + std::min(count % kBlocks, static_cast<std::size_t>(block));
+}
+
+
+#endif
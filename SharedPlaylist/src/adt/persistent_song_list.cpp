@@ -0,0 +1,264 @@
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "persistent_song_list.h"
+#include "shuffle_rng.h"
+
+
+struct PersistentSongList::Node
+{
+	Node(const Song& song, NodePtr left, NodePtr right) :
+		song(song), left(std::move(left)), right(std::move(right)),
+		size(1 + treeSize(this->left) + treeSize(this->right)) { }
+
+	Song song;
+	NodePtr left;
+	NodePtr right;
+	int size;
+};
+
+
+PersistentSongList::PersistentSongList() { }
+
+
+/*!
+ *  @brief       Builds a balanced list of songs in O(n)
+ */
+PersistentSongList::PersistentSongList(const std::vector<Song>& songs) :
+	m_root(build(songs, 0, static_cast<int>(songs.size()))) { }
+
+
+PersistentSongList::PersistentSongList(NodePtr root) :
+	m_root(std::move(root)) { }
+
+
+/*!
+ *  @brief       New list with song inserted before songIndex, this list is unchanged
+ *  @param[in]   songIndex   Position of the new song, size() appends
+ */
+PersistentSongList PersistentSongList::inserted(int songIndex, const Song& song) const
+{
+	return inserted(songIndex, PersistentSongList(makeNode(song, nullptr, nullptr)));
+}
+
+
+/*!
+ *  @brief       New list with every song of songs inserted in order before songIndex
+ */
+PersistentSongList PersistentSongList::inserted(int songIndex, const PersistentSongList& songs) const
+{
+	if (songIndex < 0 || songIndex > size()) {
+		throw std::invalid_argument("songIndex out of bounds");
+	}
+
+	NodePtr left;
+	NodePtr right;
+	split(m_root, songIndex, left, right);
+	return PersistentSongList(merge(merge(left, songs.m_root), right));
+}
+
+
+/*!
+ *  @brief       New list without the song at songIndex, this list is unchanged
+ */
+PersistentSongList PersistentSongList::erased(int songIndex) const
+{
+	if (songIndex < 0 || songIndex >= size()) {
+		throw std::invalid_argument("songIndex out of bounds");
+	}
+
+	NodePtr left;
+	NodePtr rest;
+	NodePtr middle;
+	NodePtr right;
+	split(m_root, songIndex, left, rest);
+	split(rest, 1, middle, right);
+	return PersistentSongList(merge(left, right));
+}
+
+
+PersistentSongList PersistentSongList::appended(const Song& song) const
+{
+	return inserted(size(), song);
+}
+
+
+/*!
+ *  @return  Returns pointer to Song at songIndex, or nullptr if songIndex is out of range
+ */
+Song const * PersistentSongList::getSongAt(int songIndex) const
+{
+	if (songIndex < 0 || songIndex >= size()) {
+		return nullptr;
+	}
+
+	const Node* node = m_root.get();
+	while (true) {
+		int leftSize = treeSize(node->left);
+		if (songIndex < leftSize) {
+			node = node->left.get();
+		}
+		else if (songIndex == leftSize) {
+			return &node->song;
+		}
+		else {
+			songIndex -= leftSize + 1;
+			node = node->right.get();
+		}
+	}
+}
+
+
+bool PersistentSongList::isEmpty() const
+{
+	return m_root == nullptr;
+}
+
+int PersistentSongList::size() const
+{
+	return treeSize(m_root);
+}
+
+
+PersistentSongList::operator std::vector<Song>() const
+{
+	std::vector<Song> v;
+	v.reserve(size());
+
+	for (auto song : *this) {
+		v.push_back(*song);
+	}
+
+	return v;
+}
+
+
+int PersistentSongList::treeSize(const NodePtr& node)
+{
+	return node != nullptr ? node->size : 0;
+}
+
+
+PersistentSongList::NodePtr PersistentSongList::makeNode(const Song& song, NodePtr left, NodePtr right)
+{
+	return std::make_shared<const Node>(song, std::move(left), std::move(right));
+}
+
+
+PersistentSongList::NodePtr PersistentSongList::build(const std::vector<Song>& songs, int first, int last)
+{
+	if (first == last) {
+		return nullptr;
+	}
+
+	int middle = first + (last - first) / 2;
+	return makeNode(songs[middle], build(songs, first, middle), build(songs, middle + 1, last));
+}
+
+
+/*!
+ *  @brief   Concatenates two trees by copying the path along which they are joined.
+ *           Each side becomes the root with probability proportional to its size, which keeps
+ *           the expected depth logarithmic without per node priorities.
+ */
+PersistentSongList::NodePtr PersistentSongList::merge(const NodePtr& left, const NodePtr& right)
+{
+	if (left == nullptr) {
+		return right;
+	}
+	if (right == nullptr) {
+		return left;
+	}
+
+	// Only needs to be unpredictable enough to keep the tree balanced, not reproducible
+	thread_local std::uint64_t state = 0;
+
+	std::uint64_t total = static_cast<std::uint64_t>(left->size + right->size);
+	if (((ShuffleRng::splitMix(state) >> 32) * total >> 32) < static_cast<std::uint64_t>(left->size)) {
+		return makeNode(left->song, left->left, merge(left->right, right));
+	}
+	return makeNode(right->song, merge(left, right->left), right->right);
+}
+
+
+/*!
+ *  @brief   Splits root into its first count songs and the rest, copying the path the split runs along
+ */
+void PersistentSongList::split(const NodePtr& root, int count, NodePtr& left, NodePtr& right)
+{
+	if (root == nullptr) {
+		left = nullptr;
+		right = nullptr;
+		return;
+	}
+
+	int leftSize = treeSize(root->left);
+	if (count <= leftSize) {
+		NodePtr rest;
+		split(root->left, count, left, rest);
+		right = makeNode(root->song, rest, root->right);
+	}
+	else {
+		NodePtr rest;
+		split(root->right, count - leftSize - 1, rest, right);
+		left = makeNode(root->song, root->left, rest);
+	}
+}
+
+
+// Iterator Implementation
+PersistentSongList::Iterator::Iterator() noexcept { }
+
+PersistentSongList::Iterator::Iterator(const Node* root)
+{
+	pushLeft(root);
+}
+
+PersistentSongList::Iterator PersistentSongList::begin() const
+{
+	return PersistentSongList::Iterator(m_root.get());
+}
+
+PersistentSongList::Iterator PersistentSongList::end() const
+{
+	return PersistentSongList::Iterator();
+}
+
+
+void PersistentSongList::Iterator::pushLeft(const Node* node)
+{
+	for (; node != nullptr; node = node->left.get()) {
+		m_path.push_back(node);
+	}
+}
+
+
+PersistentSongList::Iterator& PersistentSongList::Iterator::operator++()
+{
+	const Node* node = m_path.back();
+	m_path.pop_back();
+	pushLeft(node->right.get());
+	return *this;
+}
+
+PersistentSongList::Iterator PersistentSongList::Iterator::operator++(int)
+{
+	Iterator iter = *this;
+	++* this;
+	return iter;
+}
+
+bool PersistentSongList::Iterator::operator!=(const Iterator& iter) const
+{
+	if (m_path.empty() || iter.m_path.empty()) {
+		return m_path.empty() != iter.m_path.empty();
+	}
+	return m_path.back() != iter.m_path.back();
+}
+
+
+Song const * PersistentSongList::Iterator::operator*() const
+{
+	return &m_path.back()->song;
+}
@@ -0,0 +1,77 @@
+#ifndef PERSISTENT_SONG_LIST_H
+#define PERSISTENT_SONG_LIST_H
+
+#include <memory>
+#include <vector>
+
+#include "song.h"
+
+
+/// Immutable sequence of songs with structural sharing.
+/// Copies are O(1) and share every node. Edits return a new list in O(log n) expected,
+/// copying only the path they touch, so older versions stay valid and cheap to keep.
+/// Backed by an implicit treap that merges by subtree size instead of stored priorities,
+/// which keeps it balanced even when the same subtree is shared by many versions.
+class PersistentSongList
+{
+private:
+	struct Node;
+	using NodePtr = std::shared_ptr<const Node>;
+
+public:
+	PersistentSongList();
+	explicit PersistentSongList(const std::vector<Song>& songs);
+
+	PersistentSongList inserted(int songIndex, const Song& song) const;
+	PersistentSongList inserted(int songIndex, const PersistentSongList& songs) const;
+	PersistentSongList erased(int songIndex) const;
+	PersistentSongList appended(const Song& song) const;
+
+	// GETTERS
+	const Song* getSongAt(int songIndex) const;
+	bool isEmpty() const;
+	int size() const;
+
+	// OVERLOADS
+	operator std::vector<Song>() const;
+
+
+	class Iterator;
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	class Iterator
+	{
+	public:
+		Iterator() noexcept;
+		explicit Iterator(const Node* root);
+
+		Iterator& operator++();    // Prefix
+		Iterator operator++(int);  // Postfix
+
+		bool operator!=(const Iterator& iter) const;
+		Song const * operator*() const;
+
+	private:
+		void pushLeft(const Node* node);
+
+		/// Path from the root to the current node, minus the nodes already passed on the right
+		std::vector<const Node*> m_path;
+	};
+
+
+private:
+	explicit PersistentSongList(NodePtr root);
+
+	static int treeSize(const NodePtr& node);
+	static NodePtr makeNode(const Song& song, NodePtr left, NodePtr right);
+	static NodePtr build(const std::vector<Song>& songs, int first, int last);
+	static NodePtr merge(const NodePtr& left, const NodePtr& right);
+	static void split(const NodePtr& root, int count, NodePtr& left, NodePtr& right);
+
+	NodePtr m_root;
+};
+
+
+#endif
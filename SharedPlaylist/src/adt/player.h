@@ -1,7 +1,10 @@
 #ifndef PLAYER_H
 #define PLAYER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "repeat_mode.h"
 #include "song_queue.h"
@@ -13,10 +16,15 @@ public:
 	Player();
 	~Player();
 
+	void save(std::vector<unsigned char>& out) const;
+	std::size_t load(const unsigned char* data, std::size_t size);
+
 	// GETTERS
+	SongQueue* getQueue();
 	SongQueue const* getQueue() const;
 	const RepeatMode& getRepeatMode() const;
 	const bool& getShuffle() const;
+	std::size_t memoryUsage() const;
 
 	// SETTERS
 	void setRepeatMode(const RepeatMode& repeatMode);
@@ -24,6 +32,10 @@ public:
 
 
 private:
+	/// "SPP" followed by the format version, the queue's own format is versioned separately
+	static const std::uint32_t kSaveMagic = 0x00505053u;
+	static const std::uint8_t kSaveVersion = 1;
+
 	std::unique_ptr<SongQueue> m_queue;
 
 	RepeatMode m_repMode;
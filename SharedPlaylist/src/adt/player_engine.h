@@ -0,0 +1,143 @@
+#ifndef PLAYER_ENGINE_H
+#define PLAYER_ENGINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "player.h"
+#include "song.h"
+#include "timer_wheel.h"
+
+
+/// Event loop that plays many sessions on one thread. Each playing session has a timer on a TimerWheel
+/// set to the end of its track, when it fires the engine moves the queue on with nextSong() and tells the
+/// listener, so no session needs a thread or a blocking wait of its own.
+/// Everything but post(), stop() and run() belongs to the loop thread: the thread inside run(), or whichever
+/// thread calls poll() when the engine is driven by hand. Other threads reach sessions through post().
+class PlayerEngine
+{
+public:
+	using SessionId = std::uint64_t;
+	using Clock = TimerWheel::Clock;
+	/// How long a song plays for
+	using TrackLength = std::function<Clock::duration(const Song&)>;
+
+	enum class EventType { trackStarted, queueEnded };
+
+	struct Event
+	{
+		SessionId session;
+		EventType type;
+		/// The song that started, nullptr for queueEnded
+		const Song* song;
+	};
+	/// Called on the loop thread, it must not block. It may use the engine, but not poll() it.
+	using Listener = std::function<void(const Event&)>;
+	using Task = std::function<void(PlayerEngine&)>;
+
+	/// Track boundaries are accurate to one tick
+	static const std::chrono::milliseconds kTick;
+
+	PlayerEngine(TrackLength trackLength, Listener listener, Clock::time_point start = Clock::now());
+	~PlayerEngine();
+
+	bool create(SessionId id);
+	bool destroy(SessionId id);
+	template <class Use>
+	bool use(SessionId id, Use use);
+
+	bool play(SessionId id);
+	bool pause(SessionId id);
+	bool skip(SessionId id);
+
+	void poll(Clock::time_point now);
+	void post(Task task);
+	void run();
+	void stop();
+
+	// GETTERS
+	bool contains(SessionId id) const;
+	bool isPlaying(SessionId id) const;
+	int size() const;
+	int playingCount() const;
+	Clock::time_point now() const;
+
+
+private:
+
+	// No copying from PlayerEngine
+	PlayerEngine(const PlayerEngine&) = delete;
+	void operator=(const PlayerEngine&) = delete;
+
+	/// Its timer is scheduled exactly while it is playing
+	struct Session : TimerWheel::Timer
+	{
+		SessionId id;
+		Player player;
+		/// Whether a track has been started, and the number of that song
+		bool hasTrack;
+		int trackNumber;
+		/// When the track ends while playing, and how much of it is left while paused
+		Clock::time_point ends;
+		Clock::duration remaining;
+	};
+
+	Session* find(SessionId id);
+	const Session* find(SessionId id) const;
+
+	void trackEnded(Session& session);
+	bool advance(Session& session, RepeatMode repeatMode, Clock::time_point at);
+	void startTrack(Session& session, Clock::time_point at);
+	void followQueue(Session& session);
+	void runTasks();
+	void emit(SessionId id, EventType type, const Song* song);
+
+
+	TrackLength m_trackLength;
+	Listener m_listener;
+	TimerWheel m_wheel;
+	Clock::time_point m_now;
+	std::unordered_map<SessionId, std::unique_ptr<Session>> m_sessions;
+
+	// Shared with other threads
+	std::mutex m_mutex;
+	std::condition_variable m_wakeUp;
+	std::vector<Task> m_tasks;
+	bool m_stopping;
+};
+
+
+/*!
+ *  @brief       Runs use with the session's Player. If use moves playback to another song while the session
+ *               is playing, that song starts from the beginning.
+ *  @param[in]   id    Session to use
+ *  @param[in]   use   Called with Player&, must not keep the reference
+ *  @return      False if there is no session with that id
+ */
+template <class Use>
+bool PlayerEngine::use(SessionId id, Use use)
+{
+	Session* session = find(id);
+	if (session == nullptr) {
+		return false;
+	}
+
+	try {
+		use(session->player);
+	}
+	catch (...) {
+		followQueue(*session);
+		throw;
+	}
+	followQueue(*session);
+	return true;
+}
+
+
+#endif
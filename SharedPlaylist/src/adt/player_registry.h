@@ -0,0 +1,117 @@
+#ifndef PLAYER_REGISTRY_H
+#define PLAYER_REGISTRY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "player.h"
+
+
+/// Owns the Player of every live session in the process, keyed by session id.
+/// Sessions are spread over kShards independently locked shards, so threads working on different
+/// sessions rarely contend. Idle sessions can be evicted into Player's saved form (about 4 bytes
+/// per song) and are restored transparently the next time they are used.
+class PlayerRegistry
+{
+public:
+	using SessionId = std::uint64_t;
+	using Clock = std::chrono::steady_clock;
+
+	static const int kShards = 64;
+
+	PlayerRegistry();
+	~PlayerRegistry();
+
+	bool create(SessionId id);
+	bool destroy(SessionId id);
+	template <class Use>
+	bool use(SessionId id, Use use);
+
+	bool evict(SessionId id);
+	int evictIdle(Clock::duration idleFor);
+
+	// GETTERS
+	bool contains(SessionId id) const;
+	bool isResident(SessionId id) const;
+	int size() const;
+	int residentCount() const;
+	std::size_t memoryUsage() const;
+	std::size_t memoryUsage(SessionId id) const;
+
+
+private:
+
+	// No copying from PlayerRegistry
+	PlayerRegistry(const PlayerRegistry&) = delete;
+	void operator=(const PlayerRegistry&) = delete;
+
+	/// Either player is set, or the session is evicted and saved holds it
+	struct Session
+	{
+		std::unique_ptr<Player> player;
+		std::vector<unsigned char> saved;
+		Clock::time_point lastUsed;
+		std::size_t memory;
+	};
+
+	/// Followed by a cache line of padding so locking one shard doesn't slow down its neighbours.
+	/// Padded rather than aligned, plain new doesn't honour extended alignment before C++17.
+	struct Shard
+	{
+		mutable std::mutex mutex;
+		std::unordered_map<SessionId, Session> sessions;
+		std::size_t memory;
+		int resident;
+		char padding[64];
+	};
+
+	Shard& shardOf(SessionId id);
+	const Shard& shardOf(SessionId id) const;
+
+	static Player& restore(Shard& shard, Session& session);
+	static void evict(Shard& shard, Session& session);
+	static void account(Shard& shard, Session& session);
+
+
+	Shard m_shards[kShards];
+};
+
+
+/*!
+ *  @brief       Runs use with the session's Player under its shard's lock, restoring it first if it was evicted
+ *  @param[in]   id    Session to use
+ *  @param[in]   use   Called with Player&, must not keep the reference
+ *  @return      False if there is no session with that id
+ */
+template <class Use>
+bool PlayerRegistry::use(SessionId id, Use use)
+{
+	Shard& shard = shardOf(id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto found = shard.sessions.find(id);
+	if (found == shard.sessions.end()) {
+		return false;
+	}
+
+	Session& session = found->second;
+	Player& player = restore(shard, session);
+	session.lastUsed = Clock::now();
+	try {
+		use(player);
+	}
+	catch (...) {
+		account(shard, session);
+		throw;
+	}
+	account(shard, session);
+	return true;
+}
+
+
+#endif
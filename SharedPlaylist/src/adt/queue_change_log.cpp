@@ -0,0 +1,85 @@
+#include <stdexcept>
+
+#include "queue_change_log.h"
+
+
+QueueChangeLog::QueueChangeLog(int capacity) :
+	m_capacity(capacity), m_count(0), m_version(0), m_oldest(0)
+{
+	if (capacity <= 0) {
+		throw std::invalid_argument("capacity must be positive");
+	}
+}
+
+
+/*!
+ *  @brief   Appends a change and bumps the version, overwriting the oldest change once full.
+ *           A cursor change only bumps the version, clients get the position with every delta.
+ */
+void QueueChangeLog::record(ChangeType type, int index, int toIndex, const Song& song)
+{
+	if (type != ChangeType::cursor) {
+		Change change = { m_version, type, index, toIndex, song };
+
+		if (static_cast<int>(m_ring.size()) < m_capacity) {
+			m_ring.push_back(change);
+		}
+		else {
+			Change& oldest = m_ring[m_count % m_capacity];
+			m_oldest = oldest.version + 1;
+			oldest = change;
+		}
+		m_count += 1;
+	}
+	m_version += 1;
+}
+
+
+/*!
+ *  @brief       Copies the changes made after version, in order. O(number of changes since version).
+ *  @param[in]   version   A version previously returned by getVersion()
+ *  @param[out]  changes   Replaced with the changes from version to getVersion()
+ *  @return      False if version is older than the history kept
+ */
+bool QueueChangeLog::changesSince(std::uint64_t version, std::vector<Change>& changes) const
+{
+	if (version > m_version) {
+		throw std::invalid_argument("version is newer than the log");
+	}
+	if (version < m_oldest) {
+		return false;
+	}
+
+	// Versions only grow along the ring, so walk back from the newest change to the first one made at version
+	std::uint64_t first = m_count;
+	while (first > m_count - m_ring.size() && m_ring[(first - 1) % m_capacity].version >= version) {
+		first -= 1;
+	}
+
+	changes.clear();
+	changes.reserve(static_cast<std::size_t>(m_count - first));
+	for (std::uint64_t n = first; n < m_count; ++n) {
+		changes.push_back(m_ring[n % m_capacity]);
+	}
+	return true;
+}
+
+
+std::uint64_t QueueChangeLog::getVersion() const
+{
+	return m_version;
+}
+
+int QueueChangeLog::capacity() const
+{
+	return m_capacity;
+}
+
+
+/*!
+ *  @brief   Bytes held by the ring, which grows up to capacity changes
+ */
+std::size_t QueueChangeLog::memoryUsage() const
+{
+	return m_ring.capacity() * sizeof(Change);
+}
@@ -0,0 +1,58 @@
+#ifndef QUEUE_CHANGE_LOG_H
+#define QUEUE_CHANGE_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "song.h"
+
+
+/// Bounded history of edits to a queue's current order, one version per edit.
+/// Changes are positional so a client holding the order at some version can replay them
+/// to catch up. Only the last capacity changes are kept, older versions have to refetch.
+/// Cursor changes only bump the version, so playback moving along never pushes edits out.
+class QueueChangeLog
+{
+public:
+	enum class ChangeType : unsigned char
+	{
+		insert,  // song inserted at index
+		remove,  // song at index removed
+		move,    // song at index moved to toIndex
+		cursor,  // currSong or the sub queue moved, carries no data and is not kept
+		clear,   // every song removed
+		reset    // whole order replaced (shuffle toggled), clients must refetch
+	};
+
+	struct Change
+	{
+		std::uint64_t version;  // version the change was made at
+		ChangeType type;
+		int index;
+		int toIndex;
+		Song song;
+	};
+
+	explicit QueueChangeLog(int capacity = 256);
+
+	void record(ChangeType type, int index = 0, int toIndex = 0, const Song& song = Song(0));
+	bool changesSince(std::uint64_t version, std::vector<Change>& changes) const;
+
+	// GETTERS
+	std::uint64_t getVersion() const;
+	int capacity() const;
+	std::size_t memoryUsage() const;
+
+private:
+	/// The n-th change recorded lives at m_ring[n % m_capacity]
+	std::vector<Change> m_ring;
+	int m_capacity;
+	std::uint64_t m_count;
+	std::uint64_t m_version;
+	/// Oldest version every later change is still kept for
+	std::uint64_t m_oldest;
+};
+
+
+#endif
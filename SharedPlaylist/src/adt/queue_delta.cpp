@@ -0,0 +1,156 @@
+#include <stdexcept>
+
+#include "queue_delta.h"
+
+
+/*!
+ *  @brief       Serializes changes, which must not contain a reset
+ *  @param[in]   fromVersion, toVersion   Versions the changes lead from and to
+ *  @param[in]   currIndex, subQueueSize  Playback position at toVersion, currIndex is -1 when nothing plays
+ *  @param[out]  out   The encoded delta is appended to it
+ */
+void QueueDelta::encode(std::uint64_t fromVersion, std::uint64_t toVersion,
+	const std::vector<QueueChangeLog::Change>& changes, int currIndex, int subQueueSize,
+	std::vector<unsigned char>& out)
+{
+	using ChangeType = QueueChangeLog::ChangeType;
+
+	putVarint(fromVersion, out);
+	putVarint(toVersion, out);
+
+	std::uint64_t count = 0;
+	for (const QueueChangeLog::Change& change : changes) {
+		count += change.type != ChangeType::cursor ? 1 : 0;
+	}
+	putVarint(count, out);
+
+	for (const QueueChangeLog::Change& change : changes) {
+		switch (change.type) {
+		case ChangeType::insert: {
+			std::uint32_t number = static_cast<std::uint32_t>(change.song.number);
+			out.push_back(static_cast<unsigned char>(change.type));
+			putVarint(change.index, out);
+			putVarint((number << 1) ^ (change.song.number < 0 ? 0xFFFFFFFFu : 0u), out);
+			break;
+		}
+		case ChangeType::remove:
+			out.push_back(static_cast<unsigned char>(change.type));
+			putVarint(change.index, out);
+			break;
+		case ChangeType::move:
+			out.push_back(static_cast<unsigned char>(change.type));
+			putVarint(change.index, out);
+			putVarint(change.toIndex, out);
+			break;
+		case ChangeType::clear:
+			out.push_back(static_cast<unsigned char>(change.type));
+			break;
+		case ChangeType::cursor:
+			break;
+		case ChangeType::reset:
+			throw std::invalid_argument("a reset can't be sent as a delta");
+		}
+	}
+
+	putVarint(static_cast<std::uint64_t>(currIndex + 1), out);
+	putVarint(static_cast<std::uint64_t>(subQueueSize), out);
+}
+
+
+/*!
+ *  @brief           Replays a delta onto a client's copy of the queue
+ *  @param[in]       delta     Bytes produced by encode()
+ *  @param[in]       version   Version the client's copy is at, must match the delta's fromVersion
+ *  @param[in,out]   songs, currIndex, subQueueSize   The client's copy of the order and position
+ *  @return          The version the copy is at afterwards
+ */
+std::uint64_t QueueDelta::apply(const std::vector<unsigned char>& delta, std::uint64_t version,
+	std::vector<Song>& songs, int& currIndex, int& subQueueSize)
+{
+	using ChangeType = QueueChangeLog::ChangeType;
+
+	std::size_t pos = 0;
+	if (getVarint(delta, pos) != version) {
+		throw std::invalid_argument("delta does not start at version");
+	}
+	std::uint64_t toVersion = getVarint(delta, pos);
+
+	for (std::uint64_t count = getVarint(delta, pos); count > 0; --count) {
+		if (pos >= delta.size()) {
+			throw std::invalid_argument("delta is truncated");
+		}
+
+		int index;
+		switch (static_cast<ChangeType>(delta[pos++])) {
+		case ChangeType::insert: {
+			index = getIndex(delta, pos, static_cast<int>(songs.size()));
+			std::uint32_t zigzag = static_cast<std::uint32_t>(getVarint(delta, pos));
+			int number = static_cast<int>((zigzag >> 1) ^ (0u - (zigzag & 1u)));
+			songs.insert(songs.begin() + index, Song(number));
+			break;
+		}
+		case ChangeType::remove:
+			index = getIndex(delta, pos, static_cast<int>(songs.size()) - 1);
+			songs.erase(songs.begin() + index);
+			break;
+		case ChangeType::move: {
+			index = getIndex(delta, pos, static_cast<int>(songs.size()) - 1);
+			int toIndex = getIndex(delta, pos, static_cast<int>(songs.size()) - 1);
+			Song song = songs[index];
+			songs.erase(songs.begin() + index);
+			songs.insert(songs.begin() + toIndex, song);
+			break;
+		}
+		case ChangeType::clear:
+			songs.clear();
+			break;
+		default:
+			throw std::invalid_argument("unknown change in delta");
+		}
+	}
+
+	currIndex = static_cast<int>(getVarint(delta, pos)) - 1;
+	subQueueSize = static_cast<int>(getVarint(delta, pos));
+	return toVersion;
+}
+
+
+void QueueDelta::putVarint(std::uint64_t value, std::vector<unsigned char>& out)
+{
+	while (value >= 0x80) {
+		out.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<unsigned char>(value));
+}
+
+
+std::uint64_t QueueDelta::getVarint(const std::vector<unsigned char>& in, std::size_t& pos)
+{
+	std::uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (pos >= in.size()) {
+			throw std::invalid_argument("delta is truncated");
+		}
+
+		unsigned char byte = in[pos++];
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+	throw std::invalid_argument("varint is too long");
+}
+
+
+/*!
+ *  @brief   Reads an index and checks it against [0, limit]
+ */
+int QueueDelta::getIndex(const std::vector<unsigned char>& in, std::size_t& pos, int limit)
+{
+	std::uint64_t index = getVarint(in, pos);
+	if (index > static_cast<std::uint64_t>(limit) || limit < 0) {
+		throw std::invalid_argument("index in delta out of bounds");
+	}
+	return static_cast<int>(index);
+}
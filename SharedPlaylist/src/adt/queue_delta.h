@@ -0,0 +1,33 @@
+#ifndef QUEUE_DELTA_H
+#define QUEUE_DELTA_H
+
+#include <cstdint>
+#include <vector>
+
+#include "song.h"
+#include "queue_change_log.h"
+
+
+/// Wire format for the changes between two queue versions.
+/// Everything is a LEB128 varint, a single move in a 1000 song queue encodes in about 10 bytes:
+///     fromVersion toVersion count { type fields... } currIndex+1 subQueueSize
+/// insert carries index and the zigzagged song number, remove an index, move both indices.
+/// Cursor changes are folded into the trailing position, which every delta carries.
+class QueueDelta
+{
+public:
+	static void encode(std::uint64_t fromVersion, std::uint64_t toVersion,
+		const std::vector<QueueChangeLog::Change>& changes, int currIndex, int subQueueSize,
+		std::vector<unsigned char>& out);
+
+	static std::uint64_t apply(const std::vector<unsigned char>& delta, std::uint64_t version,
+		std::vector<Song>& songs, int& currIndex, int& subQueueSize);
+
+private:
+	static void putVarint(std::uint64_t value, std::vector<unsigned char>& out);
+	static std::uint64_t getVarint(const std::vector<unsigned char>& in, std::size_t& pos);
+	static int getIndex(const std::vector<unsigned char>& in, std::size_t& pos, int limit);
+};
+
+
+#endif
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "queue_metrics.h"
+
+
+const int QueueMetrics::kOpCount;
+const int QueueMetrics::kLatencyBuckets;
+
+
+namespace
+{
+	/// One thread's counters. Only the owning thread writes them, so plain load and store
+	/// pairs are enough, they are atomic only so snapshot() can read them from another thread.
+	struct ThreadCounters
+	{
+		std::atomic<std::uint64_t> calls[QueueMetrics::kOpCount];
+		std::atomic<std::uint64_t> nodes[QueueMetrics::kOpCount];
+		std::atomic<std::uint64_t> nanos[QueueMetrics::kOpCount];
+		std::atomic<std::uint64_t> latency[QueueMetrics::kOpCount][QueueMetrics::kLatencyBuckets];
+	};
+
+
+	void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+
+	void addTo(QueueMetrics::Snapshot& totals, const ThreadCounters& counters)
+	{
+		for (int op = 0; op < QueueMetrics::kOpCount; ++op) {
+			QueueMetrics::OpStats& stats = totals.ops[op];
+			stats.calls += counters.calls[op].load(std::memory_order_relaxed);
+			stats.nodesTraversed += counters.nodes[op].load(std::memory_order_relaxed);
+			stats.totalNanos += counters.nanos[op].load(std::memory_order_relaxed);
+			for (int bucket = 0; bucket < QueueMetrics::kLatencyBuckets; ++bucket) {
+				stats.latency[bucket] += counters.latency[op][bucket].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<ThreadCounters*> live;
+		/// Totals of threads that have exited
+		QueueMetrics::Snapshot retired;
+		/// Totals at the last reset(), subtracted from every snapshot
+		QueueMetrics::Snapshot baseline;
+	};
+
+
+	/// Never destroyed, threads still running during static destruction may exit and fold their counters in
+	Registry& registry()
+	{
+		static Registry* registry = new Registry();
+		return *registry;
+	}
+
+
+	/// Registers the thread's counters on first use and folds them into the retired totals when it exits
+	class ThreadSlot
+	{
+	public:
+		ThreadSlot() :
+			counters(new ThreadCounters())
+		{
+			Registry& reg = registry();
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			reg.live.push_back(counters);
+		}
+
+		~ThreadSlot()
+		{
+			Registry& reg = registry();
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			addTo(reg.retired, *counters);
+			reg.live.erase(std::find(reg.live.begin(), reg.live.end(), counters));
+			delete counters;
+		}
+
+		ThreadCounters* const counters;
+	};
+
+
+	ThreadCounters& localCounters()
+	{
+		thread_local ThreadSlot slot;
+		return *slot.counters;
+	}
+
+
+	int bucketOf(std::uint64_t nanos)
+	{
+		int bucket = 0;
+		for (; nanos != 0 && bucket < QueueMetrics::kLatencyBuckets - 1; nanos >>= 1) {
+			bucket += 1;
+		}
+		return bucket;
+	}
+}
+
+
+/*!
+ *  @brief       Charges one call of op to the calling thread
+ *  @param[in]   op      Operation that finished
+ *  @param[in]   nanos   How long it took
+ *  @param[in]   nodes   Nodes it walked
+ */
+void QueueMetrics::record(Op op, std::uint64_t nanos, std::uint64_t nodes)
+{
+	ThreadCounters& counters = localCounters();
+	const int index = static_cast<int>(op);
+
+	bump(counters.calls[index], 1);
+	bump(counters.nodes[index], nodes);
+	bump(counters.nanos[index], nanos);
+	bump(counters.latency[index][bucketOf(nanos)], 1);
+}
+
+
+/*!
+ *  @brief   Totals of every thread since the last reset(). Cheap enough to call from a metrics scraper,
+ *           it only takes a lock to list the threads and never stops them from recording.
+ */
+QueueMetrics::Snapshot QueueMetrics::snapshot()
+{
+	Snapshot totals;
+	std::memset(&totals, 0, sizeof(totals));
+
+	Registry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+
+	for (const ThreadCounters* counters : reg.live) {
+		addTo(totals, *counters);
+	}
+
+	for (int op = 0; op < kOpCount; ++op) {
+		OpStats& stats = totals.ops[op];
+		const OpStats& retired = reg.retired.ops[op];
+		const OpStats& baseline = reg.baseline.ops[op];
+
+		stats.calls += retired.calls - baseline.calls;
+		stats.nodesTraversed += retired.nodesTraversed - baseline.nodesTraversed;
+		stats.totalNanos += retired.totalNanos - baseline.totalNanos;
+		for (int bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+			stats.latency[bucket] += retired.latency[bucket] - baseline.latency[bucket];
+		}
+	}
+	return totals;
+}
+
+
+/*!
+ *  @brief   Starts counting from zero again. Counters are never cleared, later snapshots
+ *           subtract the totals seen here, so threads recording meanwhile lose nothing.
+ */
+void QueueMetrics::reset()
+{
+	Snapshot totals = snapshot();
+
+	Registry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+
+	for (int op = 0; op < kOpCount; ++op) {
+		OpStats& baseline = reg.baseline.ops[op];
+		baseline.calls += totals.ops[op].calls;
+		baseline.nodesTraversed += totals.ops[op].nodesTraversed;
+		baseline.totalNanos += totals.ops[op].totalNanos;
+		for (int bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+			baseline.latency[bucket] += totals.ops[op].latency[bucket];
+		}
+	}
+}
+
+
+const char* QueueMetrics::name(Op op)
+{
+	static const char* const names[kOpCount] = {
+		"SongQueue::addToQueue",
+		"SongQueue::addToSubQueue",
+		"SongQueue::addRangeToQueue",
+		"SongQueue::addRangeToSubQueue",
+		"SongQueue::removeFromQueue",
+		"SongQueue::removeSong",
+		"SongQueue::removeAllOccurrences",
+		"SongQueue::moveSong",
+		"SongQueue::nextSong",
+		"SongQueue::prevSong",
+		"SongQueue::setCurrSong",
+		"SongQueue::setShuffled",
+		"SongQueue::getSongAt",
+		"SongQueue::findSong",
+		"SongQueue::jumpTo",
+		"SongQueue::peekNext",
+		"SongQueue::view",
+		"SongQueue::snapshot",
+		"SongQueue::getDelta",
+		"SongQueue::save",
+		"SongQueue::load",
+		"Player::setShuffle",
+		"Player::save",
+		"Player::load"
+	};
+	return names[static_cast<int>(op)];
+}
+
+
+/*!
+ *  @brief       Writes the snapshot in the Prometheus text format, one histogram and one counter per metric.
+ *               Operations that were never called are left out.
+ *  @param[out]  out   Stream the metrics are written to
+ */
+void QueueMetrics::Snapshot::exportText(std::ostream& out) const
+{
+	out << "# TYPE shared_playlist_op_calls_total counter\n";
+	for (int op = 0; op < kOpCount; ++op) {
+		if (ops[op].calls != 0) {
+			out << "shared_playlist_op_calls_total{op=\"" << name(static_cast<Op>(op)) << "\"} " << ops[op].calls << '\n';
+		}
+	}
+
+	out << "# TYPE shared_playlist_op_nodes_traversed_total counter\n";
+	for (int op = 0; op < kOpCount; ++op) {
+		if (ops[op].calls != 0) {
+			out << "shared_playlist_op_nodes_traversed_total{op=\"" << name(static_cast<Op>(op)) << "\"} " << ops[op].nodesTraversed << '\n';
+		}
+	}
+
+	out << "# TYPE shared_playlist_op_latency_ns histogram\n";
+	for (int op = 0; op < kOpCount; ++op) {
+		const OpStats& stats = ops[op];
+		if (stats.calls == 0) {
+			continue;
+		}
+
+		// Prometheus buckets are cumulative with inclusive bounds, bucket b ends at 2^b - 1
+		const char* opName = name(static_cast<Op>(op));
+		std::uint64_t cumulative = 0;
+		for (int bucket = 0; bucket < kLatencyBuckets - 1; ++bucket) {
+			cumulative += stats.latency[bucket];
+			out << "shared_playlist_op_latency_ns_bucket{op=\"" << opName << "\",le=\"" << ((std::uint64_t(1) << bucket) - 1) << "\"} " << cumulative << '\n';
+		}
+		out << "shared_playlist_op_latency_ns_bucket{op=\"" << opName << "\",le=\"+Inf\"} " << stats.calls << '\n';
+		out << "shared_playlist_op_latency_ns_sum{op=\"" << opName << "\"} " << stats.totalNanos << '\n';
+		out << "shared_playlist_op_latency_ns_count{op=\"" << opName << "\"} " << stats.calls << '\n';
+	}
+}
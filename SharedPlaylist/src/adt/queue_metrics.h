@@ -0,0 +1,148 @@
+#ifndef QUEUE_METRICS_H
+#define QUEUE_METRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+
+/// Optional instrumentation for SongQueue and Player, compiled in by defining SHAREDPLAYLIST_METRICS.
+/// Each instrumented operation records a call, the nodes its index walks stepped through and its latency
+/// in a log2 histogram. Counters are kept per thread so recording never contends, snapshot() sums them.
+/// Without the macro the QUEUE_METRICS_* hooks expand to nothing and every snapshot reads zero.
+class QueueMetrics
+{
+public:
+	enum class Op : std::uint8_t
+	{
+		addToQueue,
+		addToSubQueue,
+		addRangeToQueue,
+		addRangeToSubQueue,
+		removeFromQueue,
+		removeSong,
+		removeAllOccurrences,
+		moveSong,
+		nextSong,
+		prevSong,
+		setCurrSong,
+		setShuffled,
+		getSongAt,
+		findSong,
+		jumpTo,
+		peekNext,
+		view,
+		snapshot,
+		getDelta,
+		save,
+		load,
+		playerSetShuffle,
+		playerSave,
+		playerLoad,
+		count
+	};
+
+	static const int kOpCount = static_cast<int>(Op::count);
+
+	/// Bucket b holds latencies of b significant bits, [2^(b-1), 2^b) ns, the last one everything slower
+	static const int kLatencyBuckets = 32;
+
+	struct OpStats
+	{
+		std::uint64_t calls;
+		/// Treap and list nodes stepped through, including those of nested operations
+		std::uint64_t nodesTraversed;
+		std::uint64_t totalNanos;
+		std::uint64_t latency[kLatencyBuckets];
+	};
+
+	struct Snapshot
+	{
+		OpStats ops[kOpCount];
+
+		const OpStats& operator[](Op op) const;
+		void exportText(std::ostream& out) const;
+	};
+
+	static bool enabled();
+	static Snapshot snapshot();
+	static void reset();
+	static const char* name(Op op);
+
+	static void record(Op op, std::uint64_t nanos, std::uint64_t nodes);
+	static void traversed(int nodes);
+
+
+	/// Times the enclosing operation and charges it the nodes walked while it was in scope
+	class Scope
+	{
+	public:
+		explicit Scope(Op op);
+		~Scope();
+
+	private:
+		Scope(const Scope&) = delete;
+		void operator=(const Scope&) = delete;
+
+		Op m_op;
+		std::uint64_t m_nodesAtStart;
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+private:
+	/// Nodes walked by this thread so far, scopes charge the difference
+	static std::uint64_t& walked();
+};
+
+
+#ifdef SHAREDPLAYLIST_METRICS
+#define QUEUE_METRICS_SCOPE(op) QueueMetrics::Scope queueMetricsScope(QueueMetrics::Op::op)
+#define QUEUE_METRICS_TRAVERSED(nodes) QueueMetrics::traversed(nodes)
+#else
+#define QUEUE_METRICS_SCOPE(op) ((void)0)
+#define QUEUE_METRICS_TRAVERSED(nodes) ((void)0)
+#endif
+
+
+inline const QueueMetrics::OpStats& QueueMetrics::Snapshot::operator[](Op op) const
+{
+	return ops[static_cast<int>(op)];
+}
+
+
+inline bool QueueMetrics::enabled()
+{
+#ifdef SHAREDPLAYLIST_METRICS
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+inline std::uint64_t& QueueMetrics::walked()
+{
+	thread_local std::uint64_t nodes = 0;
+	return nodes;
+}
+
+
+inline void QueueMetrics::traversed(int nodes)
+{
+	walked() += static_cast<std::uint64_t>(nodes);
+}
+
+
+inline QueueMetrics::Scope::Scope(Op op) :
+	m_op(op), m_nodesAtStart(walked()), m_start(std::chrono::steady_clock::now()) { }
+
+
+inline QueueMetrics::Scope::~Scope()
+{
+	const auto elapsed = std::chrono::steady_clock::now() - m_start;
+	record(m_op, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+		walked() - m_nodesAtStart);
+}
+
+
+#endif
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <utility>
+
+#include "queue_snapshot.h"
+
+
+QueueSnapshot::QueueSnapshot() :
+	m_currIndex(-1), m_subQueueSize(0), m_shuffled(false), m_version(0) { }
+
+
+QueueSnapshot::QueueSnapshot(PersistentSongList songs, int currIndex, int subQueueSize, bool shuffled, std::uint64_t version) :
+	m_songs(std::move(songs)), m_currIndex(currIndex), m_subQueueSize(subQueueSize), m_shuffled(shuffled), m_version(version) { }
+
+
+/*!
+ *  @return  Returns pointer to Song at songIndex, or nullptr if songIndex is out of range
+ */
+Song const * QueueSnapshot::getSongAt(int songIndex) const
+{
+	return m_songs.getSongAt(songIndex);
+}
+
+
+/*!
+ *  @return  Returns pointer to the playing Song, or nullptr if nothing is playing
+ */
+Song const * QueueSnapshot::getCurrSong() const
+{
+	return getSongAt(m_currIndex);
+}
+
+
+int QueueSnapshot::getCurrIndex() const
+{
+	return m_currIndex;
+}
+
+
+/*!
+ *  @return  Number of songs queued to play next, they directly follow currSong
+ */
+int QueueSnapshot::getSubQueueSize() const
+{
+	return m_subQueueSize;
+}
+
+
+bool QueueSnapshot::isEmpty() const
+{
+	return m_songs.isEmpty();
+}
+
+bool QueueSnapshot::isShuffled() const
+{
+	return m_shuffled;
+}
+
+int QueueSnapshot::size() const
+{
+	return m_songs.size();
+}
+
+std::uint64_t QueueSnapshot::getVersion() const
+{
+	return m_version;
+}
+
+
+QueueSnapshot::operator std::vector<Song>() const
+{
+	return m_songs;
+}
+
+
+/*!
+ *  @brief   Overrides insertion operator to ostream, outputs data as "Queue: [...]"
+ *  @return  Reference to ostream
+ */
+std::ostream& operator<<(std::ostream& out, const QueueSnapshot& snapshot)
+{
+	out << "Queue: [";
+	auto song = snapshot.begin();
+	if (song != snapshot.end()) {
+		out << (*song)->number;
+		++song;
+	}
+
+	for (; song != snapshot.end(); ++song) {
+		out << ", " << (*song)->number;
+	}
+	out << "]";
+
+	if (snapshot.getCurrSong() != nullptr) {
+		out << " currSong: " << snapshot.getCurrSong()->number;
+	}
+	else {
+		out << " currSong: nullptr";
+	}
+	out << " subQueueSize: " << snapshot.m_subQueueSize;
+
+	return out;
+}
+
+
+QueueSnapshot::Iterator QueueSnapshot::begin() const
+{
+	return m_songs.begin();
+}
+
+QueueSnapshot::Iterator QueueSnapshot::end() const
+{
+	return m_songs.end();
+}
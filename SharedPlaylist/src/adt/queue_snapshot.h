@@ -0,0 +1,56 @@
+#ifndef QUEUE_SNAPSHOT_H
+#define QUEUE_SNAPSHOT_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include "song.h"
+#include "persistent_song_list.h"
+
+
+/// Immutable copy of a SongQueue's current order, as returned by SongQueue::snapshot().
+/// Holds the songs in the order they play along with where playback and the sub queue are,
+/// so it can be read from any number of threads while the queue it came from keeps changing.
+/// Songs are shared with the queue and with other snapshots, copying a snapshot is O(1).
+class QueueSnapshot
+{
+public:
+	QueueSnapshot();
+	QueueSnapshot(PersistentSongList songs, int currIndex, int subQueueSize, bool shuffled, std::uint64_t version);
+
+	// GETTERS
+	const Song* getSongAt(int songIndex) const;
+	const Song* getCurrSong() const;
+	int getCurrIndex() const;
+	int getSubQueueSize() const;
+	bool isEmpty() const;
+	bool isShuffled() const;
+	int size() const;
+	std::uint64_t getVersion() const;
+
+	// OVERLOADS
+	operator std::vector<Song>() const;
+	friend std::ostream& operator<<(std::ostream& out, const QueueSnapshot& snapshot);
+
+
+	using Iterator = PersistentSongList::Iterator;
+
+	Iterator begin() const;
+	Iterator end() const;
+
+
+private:
+	PersistentSongList m_songs;
+
+	/// -1 when nothing is playing, the sub queue then starts at the front
+	int m_currIndex;
+	int m_subQueueSize;
+	bool m_shuffled;
+
+	/// SongQueue::getVersion() when the snapshot was taken, deltas for clients start from it
+	std::uint64_t m_version;
+};
+
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SHARED_PLAYER_H
+#define SHARED_PLAYER_H
+
+#include <atomic>
+
+#include "repeat_mode.h"
+#include "shared_song_queue.h"
+
+
+/// Player for a shared session, every member can be used from any thread.
+/// Listeners read the queue through getQueue().read() without blocking the host or guests editing it.
+class SharedPlayer
+{
+public:
+	SharedPlayer();
+	~SharedPlayer();
+
+	bool nextSong();
+	bool prevSong();
+
+	// GETTERS
+	SharedSongQueue& getQueue();
+	const SharedSongQueue& getQueue() const;
+	RepeatMode getRepeatMode() const;
+	bool getShuffle() const;
+
+	// SETTERS
+	void setRepeatMode(const RepeatMode& repeatMode);
+	void setShuffle(const bool& shuffle);
+
+
+private:
+	SharedSongQueue m_queue;
+
+	std::atomic<RepeatMode> m_repMode;
+};
+
+
+#endif
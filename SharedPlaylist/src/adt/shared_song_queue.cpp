@@ -0,0 +1,202 @@
+#include "shared_song_queue.h"
+
+
+SharedSongQueue::SharedSongQueue() :
+	m_snapshot(new QueueSnapshot()) { }
+
+
+SharedSongQueue::~SharedSongQueue()
+{
+	delete m_snapshot.load();
+}
+
+
+/*!
+ *  @brief       Adds a song to the end of the Queue (same way Spotify handles it)
+ *  @param[in]   song   The song to be added to the queue
+ */
+void SharedSongQueue::addToQueue(const Song& song)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.addToQueue(song);
+	publish();
+}
+
+
+/*!
+ *  @brief   Same as addToQueue(*song), kept for callers that still hand songs over in a std::unique_ptr
+ */
+void SharedSongQueue::addToQueue(std::unique_ptr<Song> song)
+{
+	addToQueue(*song);
+}
+
+
+/*!
+ *  @brief       Adds a song to the end of the sub queue, which plays in order after currSong
+ *  @param[in]   song   The song to be added to the sub queue
+ */
+void SharedSongQueue::addToSubQueue(const Song& song)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.addToSubQueue(song);
+	publish();
+}
+
+
+/*!
+ *  @brief   Same as addToSubQueue(*song), kept for callers that still hand songs over in a std::unique_ptr
+ */
+void SharedSongQueue::addToSubQueue(std::unique_ptr<Song> song)
+{
+	addToSubQueue(*song);
+}
+
+
+void SharedSongQueue::removeFromQueue(const int& songIndex)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.removeFromQueue(songIndex);
+	publish();
+}
+
+
+void SharedSongQueue::moveSong(const int& oldSongIndex, const int& newSongIndex)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.moveSong(oldSongIndex, newSongIndex);
+	publish();
+}
+
+
+/*!
+ *  @return  True if moved forward successfully, nothing is published otherwise
+ */
+bool SharedSongQueue::nextSong(RepeatMode repeatMode)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	if (!m_queue.nextSong(repeatMode)) {
+		return false;
+	}
+	publish();
+	return true;
+}
+
+
+/*!
+ *  @return  True if moved back successfully, nothing is published otherwise
+ */
+bool SharedSongQueue::prevSong()
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	if (!m_queue.prevSong()) {
+		return false;
+	}
+	publish();
+	return true;
+}
+
+
+void SharedSongQueue::clear()
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.clear();
+	publish();
+}
+
+
+/*!
+ *  @brief   Pins the current snapshot without blocking on writers
+ */
+SharedSongQueue::Reader SharedSongQueue::read() const
+{
+	return Reader(m_epochs, m_snapshot);
+}
+
+
+/*!
+ *  @brief   Changes since the version of a snapshot a client holds, see SongQueue::getDelta.
+ *           Takes the write lock, the change log is not published to readers.
+ */
+bool SharedSongQueue::getDelta(std::uint64_t version, std::vector<unsigned char>& delta) const
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	return m_queue.getDelta(version, delta);
+}
+
+
+bool SharedSongQueue::isEmpty() const
+{
+	return read()->isEmpty();
+}
+
+bool SharedSongQueue::isShuffled() const
+{
+	return read()->isShuffled();
+}
+
+int SharedSongQueue::size() const
+{
+	return read()->size();
+}
+
+
+void SharedSongQueue::setCurrSong(const int& songIndex)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.setCurrSong(songIndex);
+	publish();
+}
+
+
+/*!
+ *  @brief       Shuffles or unshuffles the queue and publishes the new order.
+ *               Shuffling draws the whole order for the snapshot, O(n log n) while the lock is held.
+ */
+void SharedSongQueue::setShuffled(const bool& shuffled)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.setShuffled(shuffled);
+	publish();
+}
+
+
+/*!
+ *  @brief   Seeds the next shuffle, see SongQueue::setShuffleSeed. The published order is unchanged.
+ */
+void SharedSongQueue::setShuffleSeed(std::uint64_t seed)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	m_queue.setShuffleSeed(seed);
+}
+
+
+SharedSongQueue::operator std::vector<Song>() const
+{
+	return *read();
+}
+
+
+/*!
+ *  @brief   Swaps in a snapshot of m_queue and retires the previous one, m_writeMutex must be held
+ */
+void SharedSongQueue::publish()
+{
+	const QueueSnapshot* snapshot = new QueueSnapshot(m_queue.snapshot());
+	m_epochs.retire(m_snapshot.exchange(snapshot));
+}
+
+
+// Reader Implementation
+SharedSongQueue::Reader::Reader(const EpochDomain& epochs, const std::atomic<const QueueSnapshot*>& snapshot) :
+	m_guard(epochs), m_snapshot(snapshot.load()) { }
+
+const QueueSnapshot& SharedSongQueue::Reader::operator*() const
+{
+	return *m_snapshot;
+}
+
+const QueueSnapshot* SharedSongQueue::Reader::operator->() const
+{
+	return m_snapshot;
+}
@@ -0,0 +1,135 @@
+#ifndef SHARED_QUEUE_H
+#define SHARED_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <mutex>
+#include <vector>
+
+#include "song.h"
+#include "repeat_mode.h"
+#include "song_queue.h"
+#include "queue_snapshot.h"
+#include "epoch_domain.h"
+
+
+/// SongQueue that any number of threads can read while others edit it.
+/// Edits are serialized by a mutex and each one publishes a new immutable QueueSnapshot.
+/// Readers never take the lock: read() pins the snapshot that is current at that moment,
+/// and superseded snapshots are freed through an EpochDomain once their last reader is done.
+///
+/// A snapshot holds the whole current order, so SongQueue's lazy shuffle does not carry over: the first publish
+/// after a shuffle (setShuffled(true), or nextSong() wrapping around with RepeatMode::on) draws every song,
+/// O(n log n) under the lock. Edits after that publish in O(log n), shuffled or not.
+class SharedSongQueue
+{
+public:
+	SharedSongQueue();
+	~SharedSongQueue();
+
+	// Writers
+	void addToQueue(const Song& song);
+	void addToSubQueue(const Song& song);
+	template <class... Args>
+	void emplaceToQueue(Args&&... args);
+	template <class... Args>
+	void emplaceToSubQueue(Args&&... args);
+	void addToQueue(std::unique_ptr<Song> song);
+	void addToSubQueue(std::unique_ptr<Song> song);
+	void removeFromQueue(const int& songIndex);
+	void moveSong(const int& oldSongIndex, const int& newSongIndex);
+	bool nextSong(RepeatMode repeatMode);
+	bool prevSong();
+	void clear();
+
+	template <class Edit>
+	void edit(Edit edit);
+
+	// Readers
+	class Reader;
+	Reader read() const;
+
+	// GETTERS
+	bool getDelta(std::uint64_t version, std::vector<unsigned char>& delta) const;
+	bool isEmpty() const;
+	bool isShuffled() const;
+	int size() const;
+
+	// SETTERS
+	void setCurrSong(const int& songIndex);
+	void setShuffled(const bool& shuffled);
+	void setShuffleSeed(std::uint64_t seed);
+
+	// OVERLOADS
+	operator std::vector<Song>() const;
+
+
+	/// A pinned snapshot, it stays valid and unchanged for as long as the Reader lives
+	class Reader
+	{
+	public:
+		Reader(const EpochDomain& epochs, const std::atomic<const QueueSnapshot*>& snapshot);
+
+		const QueueSnapshot& operator*() const;
+		const QueueSnapshot* operator->() const;
+
+	private:
+		EpochDomain::Guard m_guard;
+		const QueueSnapshot* m_snapshot;
+	};
+
+
+private:
+
+	// No copying from SharedSongQueue
+	SharedSongQueue(const SharedSongQueue&) = delete;
+	void operator=(const SharedSongQueue&) = delete;
+
+	void publish();
+
+	SongQueue m_queue;
+	mutable std::mutex m_writeMutex;
+
+	std::atomic<const QueueSnapshot*> m_snapshot;
+	EpochDomain m_epochs;
+};
+
+
+/*!
+ *  @brief       Runs several edits under one lock and publishes a single snapshot for all of them
+ *  @param[in]   edit   Called with the underlying SongQueue&, must not keep the reference
+ */
+template <class Edit>
+void SharedSongQueue::edit(Edit edit)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	edit(m_queue);
+	publish();
+}
+
+
+/*!
+ *  @brief       Adds a song constructed from args to the end of the Queue
+ *  @param[in]   args   Forwarded to Song's constructor
+ */
+template <class... Args>
+void SharedSongQueue::emplaceToQueue(Args&&... args)
+{
+	addToQueue(Song(std::forward<Args>(args)...));
+}
+
+
+/*!
+ *  @brief       Adds a song constructed from args to the end of the sub queue
+ *  @param[in]   args   Forwarded to Song's constructor
+ */
+template <class... Args>
+void SharedSongQueue::emplaceToSubQueue(Args&&... args)
+{
+	addToSubQueue(Song(std::forward<Args>(args)...));
+}
+
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef SHUFFLE_RNG_H
+#define SHUFFLE_RNG_H
+
+#include <cstdint>
+
+
+/// xoshiro256** generator used for every shuffle draw.
+/// Small (32 bytes of state), fast and fully determined by its 64-bit seed, so two replicas
+/// seeded alike draw the same shuffled order from the same queue.
+class ShuffleRng
+{
+public:
+	explicit ShuffleRng(std::uint64_t seed = 0);
+
+	void seed(std::uint64_t seed);
+	std::uint64_t next();
+	std::uint32_t below(std::uint32_t bound);
+
+	void getState(std::uint64_t state[4]) const;
+	void setState(const std::uint64_t state[4]);
+
+	static std::uint64_t splitMix(std::uint64_t& state);
+
+private:
+	static std::uint64_t rotl(std::uint64_t x, int k);
+
+	std::uint64_t m_state[4];
+};
+
+
+inline ShuffleRng::ShuffleRng(std::uint64_t seed)
+{
+	this->seed(seed);
+}
+
+
+/*!
+ *  @brief       Resets the generator, the state is expanded from seed with splitmix64
+ */
+inline void ShuffleRng::seed(std::uint64_t seed)
+{
+	for (std::uint64_t& word : m_state) {
+		word = splitMix(seed);
+	}
+}
+
+
+inline std::uint64_t ShuffleRng::next()
+{
+	const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+	const std::uint64_t t = m_state[1] << 17;
+
+	m_state[2] ^= m_state[0];
+	m_state[3] ^= m_state[1];
+	m_state[1] ^= m_state[2];
+	m_state[0] ^= m_state[3];
+	m_state[2] ^= t;
+	m_state[3] = rotl(m_state[3], 45);
+
+	return result;
+}
+
+
+/*!
+ *  @brief       Unbiased integer in [0, bound) using Lemire's multiply and reject method
+ *  @param[in]   bound   Exclusive upper bound, must be greater than 0
+ */
+inline std::uint32_t ShuffleRng::below(std::uint32_t bound)
+{
+	std::uint64_t product = (next() >> 32) * bound;
+	std::uint32_t low = static_cast<std::uint32_t>(product);
+
+	if (low < bound) {
+		const std::uint32_t threshold = (0u - bound) % bound;
+		while (low < threshold) {
+			product = (next() >> 32) * bound;
+			low = static_cast<std::uint32_t>(product);
+		}
+	}
+	return static_cast<std::uint32_t>(product >> 32);
+}
+
+
+/*!
+ *  @brief       Copies out the generator's position in its stream, setState() resumes from it
+ */
+inline void ShuffleRng::getState(std::uint64_t state[4]) const
+{
+	for (int i = 0; i < 4; ++i) {
+		state[i] = m_state[i];
+	}
+}
+
+
+inline void ShuffleRng::setState(const std::uint64_t state[4])
+{
+	for (int i = 0; i < 4; ++i) {
+		m_state[i] = state[i];
+	}
+}
+
+
+/*!
+ *  @brief       One splitmix64 step, advances state and returns the mixed value
+ */
+inline std::uint64_t ShuffleRng::splitMix(std::uint64_t& state)
+{
+	std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+
+inline std::uint64_t ShuffleRng::rotl(std::uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+
+#endif
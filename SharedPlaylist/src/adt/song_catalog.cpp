@@ -0,0 +1,91 @@
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#include "song_catalog.h"
+
+
+const int SongCatalog::kChunkBits;
+const int SongCatalog::kChunkSize;
+const int SongCatalog::kMaxChunks;
+
+
+SongCatalog::SongCatalog() :
+	m_size(0)
+{
+	for (std::atomic<Song*>& chunk : m_chunks) {
+		chunk.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+
+SongCatalog::~SongCatalog()
+{
+	static_assert(std::is_trivially_destructible<Song>::value, "~SongCatalog() skips Song destructors");
+
+	for (std::atomic<Song*>& chunk : m_chunks) {
+		::operator delete(chunk.load(std::memory_order_relaxed));
+	}
+}
+
+
+/*!
+ *  @brief   The catalog every queue in the process shares
+ */
+SongCatalog& SongCatalog::instance()
+{
+	static SongCatalog catalog;
+	return catalog;
+}
+
+
+/*!
+ *  @brief       Id of song, adding it to the catalog the first time it is seen
+ *  @param[in]   song   Song to look up, copied into the catalog if it is new
+ *  @return      The same id for every song with the same number
+ */
+SongCatalog::TrackId SongCatalog::intern(const Song& song)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+
+	auto found = m_ids.find(song.number);
+	if (found != m_ids.end()) {
+		return found->second;
+	}
+
+	const int id = m_size.load(std::memory_order_relaxed);
+	const int chunk = id >> kChunkBits;
+	if (chunk == kMaxChunks) {
+		throw std::length_error("SongCatalog is full");
+	}
+
+	Song* songs = m_chunks[chunk].load(std::memory_order_relaxed);
+	if (songs == nullptr) {
+		songs = static_cast<Song*>(::operator new(sizeof(Song) * kChunkSize));
+		m_chunks[chunk].store(songs, std::memory_order_release);
+	}
+
+	m_ids.emplace(song.number, static_cast<TrackId>(id));
+	new (&songs[id & (kChunkSize - 1)]) Song(song);
+	m_size.store(id + 1, std::memory_order_release);
+	return static_cast<TrackId>(id);
+}
+
+
+int SongCatalog::size() const
+{
+	return m_size.load(std::memory_order_acquire);
+}
+
+
+/*!
+ *  @brief   Bytes held by the catalog, including the id lookup table
+ */
+std::size_t SongCatalog::memoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+
+	const int chunks = (size() + kChunkSize - 1) >> kChunkBits;
+	return sizeof(*this) + static_cast<std::size_t>(chunks) * kChunkSize * sizeof(Song) +
+		m_ids.bucket_count() * sizeof(void*) + m_ids.size() * (sizeof(std::pair<const int, TrackId>) + 2 * sizeof(void*));
+}
@@ -0,0 +1,65 @@
+#ifndef SONG_CATALOG_H
+#define SONG_CATALOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "song.h"
+
+
+/// Process-wide interning table for songs. Each distinct song is stored once and named by a dense
+/// 32-bit TrackId, so a track queued in many sessions costs every queue only its id.
+/// Songs are identified by their number and are never removed, ids and Song pointers stay valid
+/// for the life of the catalog. get() is wait-free, intern() takes a lock the first time a song is seen.
+class SongCatalog
+{
+public:
+	using TrackId = std::uint32_t;
+
+	/// Songs are stored in chunks that never move, kMaxChunks * kChunkSize songs in total
+	static const int kChunkBits = 12;
+	static const int kChunkSize = 1 << kChunkBits;
+	static const int kMaxChunks = 1 << 16;
+
+	SongCatalog();
+	~SongCatalog();
+
+	static SongCatalog& instance();
+
+	TrackId intern(const Song& song);
+	const Song& get(TrackId id) const;
+
+	// GETTERS
+	int size() const;
+	std::size_t memoryUsage() const;
+
+private:
+
+	// No copying from SongCatalog
+	SongCatalog(const SongCatalog&) = delete;
+	void operator=(const SongCatalog&) = delete;
+
+	/// Published with release once allocated, readers only ever load them
+	std::atomic<Song*> m_chunks[kMaxChunks];
+	std::atomic<int> m_size;
+
+	/// Guards m_ids and adding songs
+	mutable std::mutex m_writeMutex;
+	std::unordered_map<int, TrackId> m_ids;
+};
+
+
+/*!
+ *  @brief       Song interned as id, without locking. The id has to come from intern() on this catalog,
+ *               reading it from a queue or snapshot the interning thread published is enough.
+ */
+inline const Song& SongCatalog::get(TrackId id) const
+{
+	return m_chunks[id >> kChunkBits].load(std::memory_order_acquire)[id & (kChunkSize - 1)];
+}
+
+
+#endif
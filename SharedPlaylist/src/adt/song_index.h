@@ -0,0 +1,197 @@
+#ifndef SONG_INDEX_H
+#define SONG_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/// Hash map from song number to a T*, SongQueue uses it to reach a song's nodes without walking the queue.
+/// Open addressing with linear probing, erase() shifts the probe run back instead of leaving tombstones.
+/// The slots live in one vector that doubles once it is 3/4 full, so inserting is an allocation only
+/// when the table grows. A null value marks an empty slot, so null can not be stored.
+template <class T>
+class SongIndex
+{
+public:
+	SongIndex();
+
+	T* find(int number) const;
+	void set(int number, T* value);
+	void erase(int number);
+
+	void clear();
+	void reserve(int count);
+
+	// GETTERS
+	int size() const;
+	std::size_t memoryUsage() const;
+
+private:
+	struct Slot
+	{
+		int number;
+		T* value;
+	};
+
+	std::size_t homeOf(int number) const;
+	std::size_t slotOf(int number) const;
+	void rehash(std::size_t slotCount);
+
+	/// Empty or a power of two in size
+	std::vector<Slot> m_slots;
+	/// 64 - log2(slot count), the home slot is the top bits of a Fibonacci hash
+	int m_shift;
+	int m_size;
+};
+
+
+template <class T>
+SongIndex<T>::SongIndex() :
+	m_shift(64), m_size(0) { }
+
+
+/*!
+ *  @brief       Value stored for number, nullptr if there is none
+ */
+template <class T>
+T* SongIndex<T>::find(int number) const
+{
+	if (m_slots.empty()) {
+		return nullptr;
+	}
+	return m_slots[slotOf(number)].value;
+}
+
+
+/*!
+ *  @brief       Stores value for number, replacing the value it had
+ *  @param[in]   value   Must not be nullptr, use erase() to remove a number
+ */
+template <class T>
+void SongIndex<T>::set(int number, T* value)
+{
+	if ((static_cast<std::size_t>(m_size) + 1) * 4 > m_slots.size() * 3) {
+		rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+	}
+
+	Slot& slot = m_slots[slotOf(number)];
+	if (slot.value == nullptr) {
+		m_size += 1;
+	}
+	slot.number = number;
+	slot.value = value;
+}
+
+
+template <class T>
+void SongIndex<T>::erase(int number)
+{
+	if (m_slots.empty()) {
+		return;
+	}
+
+	std::size_t hole = slotOf(number);
+	if (m_slots[hole].value == nullptr) {
+		return;
+	}
+	m_size -= 1;
+
+	// Pull later entries of the probe run into the hole unless that would put them before their home slot
+	const std::size_t mask = m_slots.size() - 1;
+	for (std::size_t next = (hole + 1) & mask; m_slots[next].value != nullptr; next = (next + 1) & mask) {
+		const std::size_t probeLength = (next - homeOf(m_slots[next].number)) & mask;
+		if (probeLength >= ((next - hole) & mask)) {
+			m_slots[hole] = m_slots[next];
+			hole = next;
+		}
+	}
+	m_slots[hole].value = nullptr;
+}
+
+
+/*!
+ *  @brief   Empties the index, keeping its slots for reuse
+ */
+template <class T>
+void SongIndex<T>::clear()
+{
+	for (Slot& slot : m_slots) {
+		slot.value = nullptr;
+	}
+	m_size = 0;
+}
+
+
+/*!
+ *  @brief       Grows the table so count numbers fit without rehashing
+ */
+template <class T>
+void SongIndex<T>::reserve(int count)
+{
+	std::size_t slotCount = m_slots.empty() ? 16 : m_slots.size();
+	while (static_cast<std::size_t>(count) * 4 > slotCount * 3) {
+		slotCount *= 2;
+	}
+	if (slotCount != m_slots.size()) {
+		rehash(slotCount);
+	}
+}
+
+
+template <class T>
+int SongIndex<T>::size() const
+{
+	return m_size;
+}
+
+
+template <class T>
+std::size_t SongIndex<T>::memoryUsage() const
+{
+	return m_slots.capacity() * sizeof(Slot);
+}
+
+
+template <class T>
+std::size_t SongIndex<T>::homeOf(int number) const
+{
+	return static_cast<std::size_t>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(number)) * 0x9E3779B97F4A7C15ull) >> m_shift);
+}
+
+
+/*!
+ *  @brief   Slot holding number, or the empty slot where it would go
+ */
+template <class T>
+std::size_t SongIndex<T>::slotOf(int number) const
+{
+	const std::size_t mask = m_slots.size() - 1;
+	std::size_t slot = homeOf(number);
+	while (m_slots[slot].value != nullptr && m_slots[slot].number != number) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+
+template <class T>
+void SongIndex<T>::rehash(std::size_t slotCount)
+{
+	std::vector<Slot> old(slotCount, Slot{ 0, nullptr });
+	old.swap(m_slots);
+
+	m_shift = 64;
+	for (std::size_t count = slotCount; count > 1; count >>= 1) {
+		m_shift -= 1;
+	}
+
+	for (const Slot& slot : old) {
+		if (slot.value != nullptr) {
+			m_slots[slotOf(slot.number)] = slot;
+		}
+	}
+}
+
+
+#endif
@@ -5,449 +5,761 @@
 
 #include "song_queue.h"
 #include "repeat_mode.h"
+#include "queue_delta.h"
+#include "binary_io.h"
+#include "queue_metrics.h"
 #include <algorithm>
 
 
-SongQueue::SongQueue() : 
-	m_head(new QueueNode()), m_tail(m_head), m_subQueueTail(nullptr), m_currSong(nullptr), 
-	m_size(0), m_shuffled(false) { }
+const int SongQueue::kMaxLookahead;
 
 
-SongQueue::~SongQueue()
+SongQueue::BasicSongQueue() : 
+	TreapQueue(std::allocator<Song>()), m_catalog(SongCatalog::instance()),
+	m_persistentValid(false), m_cursorNode(nullptr), m_cursorIndex(0), m_cursorVersion(0),
+	m_lookaheadFrom(nullptr), m_lookaheadAtEnd(false) { }
+
+
+SongQueue::~BasicSongQueue() { }
+
+
+/*!
+ *  @brief   Same as addToQueue(*song), kept for callers that still hand songs over in a std::unique_ptr
+ */
+void SongQueue::addToQueue(std::unique_ptr<Song> song)
 {
-	clear();
-	delete m_head;
+	addToQueue(*song);
 }
 
 
 /*!
- *  @brief       Adds a song to the end of the Queue (same way Spotify handles it)
- *  @param[in]   song   The song to be added to the queue
+ *  @brief   Same as addToSubQueue(*song), kept for callers that still hand songs over in a std::unique_ptr
  */
-void SongQueue::addToQueue(std::unique_ptr<Song> song)
+void SongQueue::addToSubQueue(std::unique_ptr<Song> song)
 {
-	if (isEmpty()) {
-		m_tail = new QueueNode();
+	addToSubQueue(*song);
+}
 
-		QueueNode* newNode = new QueueNode(std::move(song));
-		newNode->setPrev(m_head);
-		newNode->setNext(m_tail);
-		m_head->setNext(newNode);
 
-		m_tail->setPrev(m_head->getNext(isShuffled()));
-		m_subQueueTail = m_head->getNext(isShuffled());
+/*!
+ *  @brief   The count songs from first on in the current order
+ */
+PersistentSongList SongQueue::persistentOf(const QueueNode* first, int count) const
+{
+	std::vector<Song> songs;
+	songs.reserve(count);
+	for (; count > 0; --count, first = first->getNext(isShuffled())) {
+		songs.push_back(songOf(first));
 	}
-	else {
-		QueueNode* newNode = new QueueNode(std::move(song));
-		QueueNode* tmp;
-
-		// Add to end of queue of both shuffled and unshuffled.
-
-		bool shuffled = false;
-		for (int i = 0; i < 2; ++i) {
-			tmp = m_tail->getPrev(shuffled);
-			tmp->setNext(shuffled, newNode);
-			newNode->setPrev(shuffled, tmp);
-			newNode->setNext(shuffled, m_tail);
-			m_tail->setPrev(shuffled, newNode);
-			
-			shuffled = !shuffled;
-		}
+	return PersistentSongList(songs);
+}
+
+
+void SongQueue::onAppended(QueueNode* first, int count, bool allDrawn)
+{
+	if (m_lookaheadAtEnd) {
+		clearLookahead();
+	}
+	if (m_persistentValid && !isShuffled()) {
+		m_persistent = count == 1 ? m_persistent.appended(songOf(first)) : m_persistent.inserted(m_persistent.size(), persistentOf(first, count));
 	}
 
-	m_size += 1;
+	recordAppended(count, allDrawn);
 }
 
 
-void SongQueue::addToSubQueue(std::unique_ptr<Song> song) 
+void SongQueue::onInserted(QueueNode* first, int count)
 {
-	if (isEmpty()) {
-		m_tail = new QueueNode();
+	int songIndex = indexOf(first, isShuffled());
+	if (m_persistentValid) {
+		m_persistent = count == 1 ? m_persistent.inserted(songIndex, songOf(first)) : m_persistent.inserted(songIndex, persistentOf(first, count));
+	}
+	for (; count > 0; --count, first = first->getNext(isShuffled())) {
+		m_changes.record(QueueChangeLog::ChangeType::insert, songIndex++, 0, songOf(first));
+	}
+}
 
-		QueueNode* newNode = new QueueNode(std::move(song));
-		newNode->setPrev(m_head);
-		newNode->setNext(m_tail);
-		m_head->setNext(newNode);
 
-		m_tail->setPrev(m_head->getNext(isShuffled()));
-		m_subQueueTail = m_head->getNext(isShuffled());
+/*!
+ *  @brief   Logs count songs just appended to the unshuffled order.
+ *           While shuffled they are drawn straight away if every song after the played ones already was, a later draw
+ *           would put them in the same random order at the end, and this keeps the logged order complete.
+ *           Otherwise no client can hold the complete order yet and there is nothing to log.
+ */
+void SongQueue::recordAppended(int count, bool allDrawn)
+{
+	if (isShuffled()) {
+		if (!allDrawn) {
+			return;
+		}
+		placeAll();
 	}
-	else {
-		QueueNode* newNode = new QueueNode(std::move(song));
-		QueueNode* tmp = m_subQueueTail->getNext(isShuffled());
 
-		// update nodes pointing to newNode
-		m_subQueueTail->setNext(newNode);
-		if (tmp != nullptr) {
-			tmp->setPrev(newNode);
-		}
+	QueueNode* node = m_tail;
+	for (int i = 0; i < count; ++i) {
+		node = node->getPrev(isShuffled());
+	}
+	for (int i = count; i > 0; --i) {
+		m_changes.record(QueueChangeLog::ChangeType::insert, m_size - i, 0, songOf(node));
+		node = node->getNext(isShuffled());
+	}
+}
 
-		// update newNode pointers
-		newNode->setNext(tmp);
-		newNode->setPrev(m_subQueueTail);
-		m_subQueueTail = m_subQueueTail->getNext(isShuffled());
+
+void SongQueue::onRemoved(int songIndex)
+{
+	if (m_persistentValid) {
+		m_persistent = m_persistent.erased(songIndex);
 	}
+	m_changes.record(QueueChangeLog::ChangeType::remove, songIndex);
+}
+
 
-	m_size += 1;
+void SongQueue::onMoved(int songIndex, int newSongIndex, const QueueNode* node)
+{
+	if (m_persistentValid) {
+		m_persistent = m_persistent.erased(songIndex).inserted(newSongIndex, songOf(node));
+	}
+	m_changes.record(QueueChangeLog::ChangeType::move, songIndex, newSongIndex);
 }
 
 
 /*!
- *  @brief       Removes a song at an index
- *  @param[in]   songIndex  Index of song to delete
- *
+ *  @brief   Slides the lookahead window along when currSong steps onto its first song
  */
-void SongQueue::removeFromQueue(const int& songIndex)
+void SongQueue::onCursorMove(const QueueNode* node)
 {
-	if (songIndex < 0 || songIndex >= m_size) {
-		throw std::invalid_argument("songIndex out of bounds");
+	if (m_lookaheadFrom == m_currSong && !m_lookahead.empty() && m_lookahead.front() == node) {
+		m_lookahead.erase(m_lookahead.begin());
+		m_lookaheadFrom = node;
 	}
+	m_changes.record(QueueChangeLog::ChangeType::cursor);
+}
+
+
+/*!
+ *  @brief   The current order is about to be replaced, the persistent copy is rebuilt on demand
+ */
+void SongQueue::onReset()
+{
+	m_persistentValid = false;
+	m_persistent = PersistentSongList();
+	m_changes.record(QueueChangeLog::ChangeType::reset);
+	clearLookahead();
+}
 
-	if (m_size == 1) {
-		delete m_head->getNext(isShuffled());
-		delete m_tail;
 
-		m_currSong = nullptr;
-		m_subQueueTail = nullptr;
+void SongQueue::onCleared()
+{
+	m_index.clear();
+	clearLookahead();
+	m_persistent = PersistentSongList();
+	m_changes.record(QueueChangeLog::ChangeType::clear);
+}
 
-		m_tail = m_head;
 
-		m_size = 0;
+/*!
+ *  @brief   Keeps the persistent copy in step with a song just drawn into the shuffled order
+ */
+void SongQueue::onPlaced(const QueueNode* node, const bool& front) const
+{
+	if (!m_persistentValid) {
 		return;
 	}
+	m_persistent = front ? m_persistent.inserted(0, songOf(node)) : m_persistent.appended(songOf(node));
+}
 
-	int i = 0;
-	QueueNode* currNode = m_head->getNext(isShuffled());
-	while (i++ != songIndex) {
-		currNode = currNode->getNext(isShuffled());
-		if (currNode == nullptr) {
-			throw std::invalid_argument("Internal logic error, null node found before expected.");
-		}
+
+/*!
+ *  @brief       Removes the first occurrence of a song in the current order, found through the index
+ *  @param[in]   songNumber   Number of the song to remove
+ *  @return      false if the song is not in the queue
+ */
+bool SongQueue::removeSong(int songNumber)
+{
+	QUEUE_METRICS_SCOPE(removeSong);
+
+	int songIndex;
+	QueueNode* node = firstOccurrence(songNumber, songIndex);
+	if (node == nullptr) {
+		return false;
 	}
 
-	bool toggle = false;
+	removeNode(node, songIndex);
+	return true;
+}
 
-	for (int i = 0; i < 2; ++i, toggle = !toggle) {
 
-		currNode->getPrev(isShuffled())->setNext(isShuffled(), currNode->getNext(isShuffled()));
-		currNode->getNext(isShuffled())->setPrev(isShuffled(), currNode->getPrev(isShuffled()));
+/*!
+ *  @brief       Removes every occurrence of a song
+ *  @param[in]   songNumber   Number of the song to remove
+ *  @return      Number of songs removed
+ */
+int SongQueue::removeAllOccurrences(int songNumber)
+{
+	QUEUE_METRICS_SCOPE(removeAllOccurrences);
 
-		if (currNode == m_subQueueTail) {
-			m_subQueueTail = currNode->getPrev(isShuffled());
-		}
-		if (currNode == m_currSong) {
-			if (m_currSong->getPrev(isShuffled()) == m_head) {
-				m_currSong = nullptr;
-			}
-			else {
-				m_currSong = m_currSong->getPrev(isShuffled());
-			}
-		}
+	drawPlayed(songNumber);
 
+	int removed = 0;
+	for (QueueNode* node = m_index.find(songNumber); node != nullptr; removed += 1) {
+		QueueNode* next = node->sameNext;
+		removeNode(node, isShuffled() && !isPlaced(node) ? -1 : indexOf(node, isShuffled()));
+		node = next;
 	}
+	return removed;
+}
 
-	delete currNode;
 
-	m_size -= 1;
+/*!
+ *  @brief       Grows the node pool and the index so count songs fit without allocating
+ *  @param[in]   count   Total number of songs to make room for
+ */
+void SongQueue::reserve(int count)
+{
+	TreapQueue::reserve(count);
+	m_index.reserve(count);
 }
 
 
 /*!
- *  @brief      Adds a song to the end of the Queue (same way Spotify handles it)
- *
- *  @param[in]  songIndex     The index of where the song currently is
- *  @param[in]  newSongIndex  The index to move the song to
- *
+ *  @brief       Appends the queue's state to out in a compact, versioned little-endian format:
+ *               the songs in unshuffled order, currSong and the sub queue tail as unshuffled
+ *               indices, the shuffle seed and generator state, then the shuffled order drawn so far
+ *               as a permutation of unshuffled indices. Songs not drawn yet stay undrawn on load,
+ *               except the ones played before the shuffle, the format has no place for them.
+ *  @param[out]  out   Buffer the saved queue is appended to
  */
-void SongQueue::moveSong(const int& songIndex, const int& newSongIndex)
+void SongQueue::save(std::vector<unsigned char>& out) const
 {
-	
-	if (songIndex == newSongIndex) {
-		return;
+	QUEUE_METRICS_SCOPE(save);
+
+	if (isShuffled()) {
+		while (placePrev()) { }
+	}
+	const int drawn = isShuffled() ? treeSize(m_root[true], true) : 0;
+	out.reserve(out.size() + 26 + 4 * static_cast<std::size_t>(m_size) + (isShuffled() ? 36 + 4 * static_cast<std::size_t>(drawn) : 0));
+
+	BinaryWriter writer(out);
+	writer.putU32(kSaveMagic);
+	writer.putU8(kSaveVersion);
+	writer.putU8(isShuffled() ? 1 : 0);
+
+	writer.putU32(static_cast<std::uint32_t>(m_size));
+	for (QueueNode* node = m_head->getNext(false); node != m_tail; node = node->getNext(false)) {
+		writer.putI32(songOf(node).number);
 	}
-	if (songIndex < 0 || songIndex >= m_size) {
-		throw std::invalid_argument("oldSongIndex out of bounds");
+	writer.putI32(m_currSong != nullptr ? indexOf(m_currSong, false) : -1);
+	writer.putI32(m_subQueue.getTail() != nullptr ? indexOf(m_subQueue.getTail(), false) : -1);
+	writer.putU64(m_shuffle.seed);
+
+	if (isShuffled()) {
+		std::uint64_t state[4];
+		m_shuffle.rng.getState(state);
+		for (std::uint64_t word : state) {
+			writer.putU64(word);
+		}
+
+		// indexOf() per node climbs the treap and misses cache on every level, so each node's
+		// unshuffled index is parked in its pending count for the walk and put back afterwards
+		std::vector<int> pending;
+		pending.reserve(m_size);
+		int index = 0;
+		for (QueueNode* node = m_head->getNext(false); node != m_tail; node = node->getNext(false)) {
+			pending.push_back(node->pending);
+			node->pending = index++;
+		}
+
+		writer.putU32(static_cast<std::uint32_t>(drawn));
+		for (QueueNode* node = m_head->getNext(true); node != m_tail; node = node->getNext(true)) {
+			writer.putU32(static_cast<std::uint32_t>(node->pending));
+		}
+
+		index = 0;
+		for (QueueNode* node = m_head->getNext(false); node != m_tail; node = node->getNext(false)) {
+			node->pending = pending[index++];
+		}
 	}
-	if (newSongIndex < 0 || newSongIndex >= m_size) {
-		throw std::invalid_argument("newSongIndex out of bounds");
+}
+
+
+/*!
+ *  @brief       Replaces the queue with one written by save(), in a single O(n) pass.
+ *               The input is fully checked before the queue is touched, so a bad buffer leaves it as it was.
+ *               Clients holding a version have to fetch a new snapshot afterwards.
+ *  @param[in]   data, size   Buffer holding a saved queue, may continue past its end
+ *  @return      Number of bytes read from data
+ */
+std::size_t SongQueue::load(const unsigned char* data, std::size_t size)
+{
+	QUEUE_METRICS_SCOPE(load);
+
+	BinaryReader reader(data, size);
+	if (reader.getU32() != kSaveMagic) {
+		throw std::invalid_argument("data does not hold a saved SongQueue");
 	}
+	if (reader.getU8() != kSaveVersion) {
+		throw std::invalid_argument("saved SongQueue has an unsupported format version");
+	}
+	const bool shuffled = reader.getU8() != 0;
 
-	int i = 0;
-	int maxIndex = songIndex < newSongIndex ? newSongIndex : songIndex;
+	const std::uint32_t count = reader.getU32();
+	reader.require(4 * static_cast<std::size_t>(count));
+	std::vector<int> numbers(count);
+	for (int& number : numbers) {
+		number = reader.getI32();
+	}
 
-	QueueNode* songNode = nullptr;
-	QueueNode* newSongNode = nullptr;
+	const int currIndex = reader.getI32();
+	const int subQueueIndex = reader.getI32();
+	if (currIndex < -1 || currIndex >= static_cast<std::int64_t>(count) ||
+		subQueueIndex < -1 || subQueueIndex >= static_cast<std::int64_t>(count)) {
+		throw std::invalid_argument("saved SongQueue position is out of bounds");
+	}
+	const std::uint64_t shuffleSeed = reader.getU64();
 
-	QueueNode* currNode = m_head->getNext(isShuffled());
-	while (i <= maxIndex) {
-		if (currNode == nullptr) {
-			throw std::invalid_argument("Internal logic error, null node found before expected.");
+	std::uint64_t state[4] = {};
+	std::vector<std::uint32_t> drawn;
+	if (shuffled) {
+		for (std::uint64_t& word : state) {
+			word = reader.getU64();
 		}
-		if (i == songIndex) {
-			songNode = currNode;
+
+		const std::uint32_t drawnCount = reader.getU32();
+		if (drawnCount > count) {
+			throw std::invalid_argument("saved SongQueue shuffled order is too long");
 		}
-		else if (i == newSongIndex) {
-			newSongNode = currNode;
+		reader.require(4 * static_cast<std::size_t>(drawnCount));
+
+		std::vector<bool> seen(count, false);
+		drawn.resize(drawnCount);
+		for (std::uint32_t& index : drawn) {
+			index = reader.getU32();
+			if (index >= count || seen[index]) {
+				throw std::invalid_argument("saved SongQueue shuffled order is not a permutation");
+			}
+			seen[index] = true;
 		}
 
-		currNode = currNode->getNext(isShuffled());
-		i += 1;
+		// While shuffled, the position always lies in the drawn part of the order
+		if ((currIndex >= 0 && !seen[currIndex]) || (subQueueIndex >= 0 && !seen[subQueueIndex])) {
+			throw std::invalid_argument("saved SongQueue position is not in the shuffled order");
+		}
 	}
 
-	assert(songNode != nullptr);
-	assert(newSongNode != nullptr);
+	// Everything is checked, the queue is only changed from here on
+	clear();
+	reserve(static_cast<int>(count));
+
+	// A fresh generation, so only the nodes marked below count as drawn
+	m_shuffle.gen += 1;
 
-	if (songNode == m_currSong) {
-		throw std::invalid_argument("Cannot move the currently playing song.");
+	std::vector<QueueNode*> nodes;
+	nodes.reserve(count);
+	for (int number : numbers) {
+		nodes.push_back(newNode(Song(number)));
 	}
 
-	if (songNode == m_subQueueTail) {
-		m_subQueueTail = songNode->getPrev(isShuffled());
+	std::vector<QueueNode*> drawnNodes;
+	drawnNodes.reserve(drawn.size());
+	for (std::uint32_t index : drawn) {
+		setPlaced(nodes[index]);
+		drawnNodes.push_back(nodes[index]);
 	}
 
-	songNode->getPrev(isShuffled())->setNext(isShuffled(), songNode->getNext(isShuffled()));
-	songNode->getNext(isShuffled())->setPrev(isShuffled(), songNode->getPrev(isShuffled()));
+	// Both orders are linked and their treaps built straight from the saved permutations
+	m_root[false] = buildChain(nodes, false, m_head, m_tail);
+	m_root[true] = buildChain(drawnNodes, true, m_head, m_tail);
+
+	m_currSong = currIndex >= 0 ? nodes[currIndex] : nullptr;
+	m_subQueue.setTail(subQueueIndex >= 0 ? nodes[subQueueIndex] : nullptr);
+	m_size = static_cast<int>(count);
+	m_shuffle.shuffled = shuffled;
+	m_shuffle.seed = shuffleSeed;
+	if (shuffled) {
+		m_shuffle.rng.setState(state);
+	}
 
-	// move forward
-	if (songIndex < newSongIndex) {
-		songNode->setNext(isShuffled(), newSongNode->getNext(isShuffled()));
-		songNode->setPrev(isShuffled(), newSongNode);
+	m_persistentValid = false;
+	m_persistent = PersistentSongList();
+	m_changes.record(QueueChangeLog::ChangeType::reset);
 
-		newSongNode->getNext(isShuffled())->setPrev(isShuffled(), songNode);
-		newSongNode->setNext(isShuffled(), songNode);
+	return reader.position();
+}
+
+/*!
+ *  @brief       Position of the first occurrence of a song in the current order, found through the index.
+ *               While shuffled, a song that has not been drawn yet is found by drawing up to it.
+ *  @param[in]   songNumber   Number of the song to look for
+ *  @return      Index of the song, or -1 if it is not in the queue
+ */
+int SongQueue::findSong(int songNumber) const
+{
+	QUEUE_METRICS_SCOPE(findSong);
+
+	int songIndex;
+	if (firstOccurrence(songNumber, songIndex) == nullptr || songIndex >= 0) {
+		return songIndex;
 	}
-	// move backward
-	else {
-		songNode->setNext(isShuffled(), newSongNode);
-		songNode->setPrev(isShuffled(), newSongNode->getPrev(isShuffled()));
 
-		newSongNode->getPrev(isShuffled())->setNext(isShuffled(),songNode);
-		newSongNode->setPrev(isShuffled(), songNode);
+	// Drawing in order rather than picking the song out keeps the shuffle fair
+	while (placeNext()) {
+		QueueNode* last = m_tail->getPrev(true);
+		if (songOf(last).number == songNumber) {
+			return indexOf(last, true);
+		}
 	}
+	throw std::invalid_argument("Internal logic error, indexed song was never drawn.");
+}
 
+
+bool SongQueue::contains(int songNumber) const
+{
+	return m_index.find(songNumber) != nullptr;
 }
 
 
 /*!
- *  @brief   Moves currSong to next song if available
- *
- *  @param[in]   repeatMode  Enum for what RepeatMode is set to within the Player
- *
- *  @return  True if moved back successfully. Only returns false when currSong is the first in queue
+ *  @brief       The songs nextSong() would play next, read outward from currSong in O(count) without moving it.
+ *               Reads come from a lookahead window that later calls reuse until an edit touches it.
+ *  @param[in]   count        Number of songs wanted
+ *  @param[in]   repeatMode   Same as for nextSong(). With on, a shuffled queue only draws its next cycle when
+ *                            playback wraps, so the songs stop at the end of the current cycle.
+ *  @return      Up to count songs, fewer once the queue runs out, none if there is no currSong
  */
-bool SongQueue::nextSong(const RepeatMode repeatMode)
+std::vector<const Song*> SongQueue::peekNext(int count, RepeatMode repeatMode) const
 {
-	if (m_currSong == nullptr) {
-		return false;
+	QUEUE_METRICS_SCOPE(peekNext);
+
+	if (count < 0) {
+		throw std::invalid_argument("count must not be negative");
 	}
-	if (m_currSong->getNext(isShuffled()) != m_tail) {
-		m_currSong = m_currSong->getNext(isShuffled());
-		return true;
+
+	std::vector<const Song*> songs;
+	if (m_currSong == nullptr || count == 0) {
+		return songs;
+	}
+	songs.reserve(count);
+
+	if (repeatMode == RepeatMode::once) {
+		songs.assign(count, &songOf(m_currSong));
+		return songs;
+	}
+
+	fillLookahead(std::min(count, kMaxLookahead));
+	for (int i = 0; i < count && i < static_cast<int>(m_lookahead.size()); ++i) {
+		songs.push_back(&songOf(m_lookahead[i]));
 	}
-	return false;
+
+	if (!m_lookaheadAtEnd && static_cast<int>(songs.size()) < count) {
+		// Past the window, drawing more of the shuffled order must not clear it
+		m_lookaheadFrom = nullptr;
+		const QueueNode* node = m_lookahead.empty() ? m_currSong : m_lookahead.back();
+		while (static_cast<int>(songs.size()) < count) {
+			node = nextOf(node, isShuffled());
+			if (node == m_tail) {
+				break;
+			}
+			songs.push_back(&songOf(node));
+		}
+		m_lookaheadFrom = m_currSong;
+	}
+
+	if (repeatMode == RepeatMode::on && (!isShuffled() || m_size == 1)) {
+		const QueueNode* node = m_head;
+		while (static_cast<int>(songs.size()) < count) {
+			node = node->getNext(false);
+			if (node == m_tail) {
+				node = m_head->getNext(false);
+			}
+			songs.push_back(&songOf(node));
+		}
+	}
+	return songs;
 }
 
 
 /*!
- *  @brief   Moves currSong to previous if available
- *  @return  True if moved back successfully. Only returns false when currSong is the first in queue
+ *  @brief       The songs before currSong, nearest first, in O(count) without moving it
+ *  @param[in]   count   Number of songs wanted
+ *  @return      Up to count songs, fewer at the start of the queue, none if there is no currSong
  */
-bool SongQueue::prevSong()
+std::vector<const Song*> SongQueue::peekPrev(int count) const
 {
+	if (count < 0) {
+		throw std::invalid_argument("count must not be negative");
+	}
+
+	std::vector<const Song*> songs;
 	if (m_currSong == nullptr) {
-		return false;
+		return songs;
 	}
-	if (m_currSong->getPrev(isShuffled()) != nullptr) {
-		m_currSong = m_currSong->getPrev(isShuffled());
-		return true;
+
+	const QueueNode* node = prevOf(m_currSong, isShuffled());
+	for (; node != m_head && static_cast<int>(songs.size()) < count; node = prevOf(node, isShuffled())) {
+		songs.push_back(&songOf(node));
 	}
-	return false;
+	return songs;
 }
 
 
 /*!
- *  @brief   Removes all items from the queue
+ *  @brief   Draws the songs played before the shuffle if the song is one of them, giving every
+ *           occurrence clients can see a position in the shuffled order
  */
-void SongQueue::clear() 
+void SongQueue::drawPlayed(int songNumber) const
 {
-	while (!isEmpty()) {
-		removeFromQueue(0);
+	if (undrawnBefore() == 0) {
+		return;
+	}
+
+	for (QueueNode* node = m_index.find(songNumber); node != nullptr; node = node->sameNext) {
+		if (!isPlaced(node) && (m_shuffle.from == m_tail || treeIndex(node, false) < treeIndex(m_shuffle.from, false))) {
+			while (placePrev()) { }
+			return;
+		}
 	}
 }
 
+
 /*!
- *  @brief   Should only be used when only one item needs to be accessed.
- *  @return  Returns pointer to Song at songIndex, or nullptr if songIndex is out of range
+ *  @brief        Earliest node of a song in the current order
+ *                Played songs not drawn yet all come first, so if one is the song they are all drawn.
+ *  @param[out]   songIndex   Its position, or -1 if it is a song that has not been drawn yet
+ *                            (in which case no occurrence has been drawn)
+ *  @return       nullptr if the song is not in the queue
  */
-Song const * SongQueue::getSongAt(int songIndex) const
+SongQueue::QueueNode* SongQueue::firstOccurrence(int songNumber, int& songIndex) const
 {
-	if (songIndex < 0 || songIndex >= m_size) {
-		return nullptr;
-	}
+	QueueNode* first = nullptr;
+	songIndex = -1;
 
-	auto song = begin();
-	for (int i = 0; song != end(); ++i, ++song) {
-		if (i == songIndex) {
-			return (*song);
+	drawPlayed(songNumber);
+
+	for (QueueNode* node = m_index.find(songNumber); node != nullptr; node = node->sameNext) {
+		if (isShuffled() && !isPlaced(node)) {
+			if (songIndex < 0) {
+				first = node;
+			}
+			continue;
 		}
-	}
 
-	return nullptr;
+		int nodeIndex = indexOf(node, isShuffled());
+		if (songIndex < 0 || nodeIndex < songIndex) {
+			first = node;
+			songIndex = nodeIndex;
+		}
+	}
+	return first;
 }
 
 
 /*!
- *  @brief   Checks if queue contains no songs
- *  @return  True if queue contains no songs, false otherwise
+ *  @brief   Bytes held by the queue's storage, including pooled slots not currently in use.
+ *           Songs live in the shared SongCatalog and are not counted.
  */
-bool SongQueue::isEmpty() const 
+std::size_t SongQueue::memoryUsage() const
 {
-	return m_head == m_tail;
+	return sizeof(*this) + m_nodePool.memoryUsage() + m_index.memoryUsage() + m_changes.memoryUsage() + m_lookahead.capacity() * sizeof(m_lookahead[0]);
 }
 
-bool SongQueue::isShuffled() const
+
+/*!
+ *  @brief   Captures the current order and playback position in a snapshot that is safe to share between threads.
+ *           O(1) while the persistent copy is in sync. The first call, and the first after a shuffle,
+ *           draws any songs still pending and builds the copy in O(n).
+ */
+QueueSnapshot SongQueue::snapshot() const
 {
-	return m_shuffled;
+	QUEUE_METRICS_SCOPE(snapshot);
+
+	if (isShuffled()) {
+		placeAll();
+	}
+	if (!m_persistentValid) {
+		m_persistent = PersistentSongList(std::vector<Song>(*this));
+		m_persistentValid = true;
+	}
+
+	int currIndex;
+	int subQueueSize;
+	position(currIndex, subQueueSize);
+
+	return QueueSnapshot(m_persistent, currIndex, subQueueSize, isShuffled(), getVersion());
 }
 
-int SongQueue::size() const
+
+/*!
+ *  @brief   Incremented by every edit to the current order or playback position
+ */
+std::uint64_t SongQueue::getVersion() const
 {
-	return m_size;
+	return m_changes.getVersion();
 }
 
 
-void SongQueue::setCurrSong(const int& songIndex)
+/*!
+ *  @brief       Encodes the edits made since version, see QueueDelta for the format. O(edits + log n).
+ *  @param[in]   version   Version of a snapshot the client holds
+ *  @param[out]  delta     Replaced with the encoded delta
+ *  @return      False if the client has to fetch a new snapshot instead: version is older than the
+ *               history kept, or the order was reshuffled since
+ */
+bool SongQueue::getDelta(std::uint64_t version, std::vector<unsigned char>& delta) const
 {
-	if (songIndex < 0 || songIndex >= m_size) {
-		throw std::invalid_argument("songIndex is out of bounds");
-	}
+	QUEUE_METRICS_SCOPE(getDelta);
 
-	QueueNode* currNode = m_head->getNext(isShuffled());
-	for (int i = 0; i < songIndex; i++) {
-		currNode = currNode->getNext(isShuffled());
+	std::vector<QueueChangeLog::Change> changes;
+	if (!m_changes.changesSince(version, changes)) {
+		return false;
 	}
-	m_currSong = currNode;
+	for (const QueueChangeLog::Change& change : changes) {
+		if (change.type == QueueChangeLog::ChangeType::reset) {
+			return false;
+		}
+	}
+
+	int currIndex;
+	int subQueueSize;
+	position(currIndex, subQueueSize);
+
+	delta.clear();
+	QueueDelta::encode(version, getVersion(), changes, currIndex, subQueueSize, delta);
+	return true;
 }
 
-void SongQueue::setShuffled(const bool& shuffled)
+
+/*!
+ *  @brief   Index of currSong in the current order (-1 if none) and the number of songs in the sub queue
+ */
+void SongQueue::position(int& currIndex, int& subQueueSize) const
 {
-	m_shuffled = shuffled;
-	if (m_shuffled) {
-		shuffle();
+	currIndex = m_currSong != nullptr ? indexOf(m_currSong, isShuffled()) : -1;
+	subQueueSize = 0;
+	if (m_subQueue.getTail() != nullptr && m_subQueue.getTail() != m_currSong) {
+		subQueueSize = std::max(0, indexOf(m_subQueue.getTail(), isShuffled()) - currIndex);
 	}
 }
 
-void SongQueue::shuffle()
+
+/*!
+ *  @brief       Makes the first occurrence of a song the current song, found through the index.
+ *               While shuffled, a song that has not been drawn yet is drawn right away and the rest stay shuffled.
+ *  @param[in]   songNumber   Number of the song to play
+ *  @return      false if the song is not in the queue
+ */
+bool SongQueue::jumpTo(int songNumber)
 {
-	if (isEmpty()) {
-		return;
+	QUEUE_METRICS_SCOPE(jumpTo);
+
+	int songIndex;
+	QueueNode* node = firstOccurrence(songNumber, songIndex);
+	if (node == nullptr) {
+		return false;
 	}
 
-	int indicator = 0;
-	std::vector<QueueNode*> beforeCurrSong;
-	std::vector<QueueNode*> subQueue;
-	std::vector<QueueNode*> afterSubQueue;
+	if (songIndex < 0) {
+		place(node, false);
+		songIndex = indexOf(node, true);
+	}
+	setCurrNode(node, songIndex);
+	return true;
+}
 
-	// Populate the above vectors.
-	// They will be shuffled seperately (subQueue will maintain order though)
-	for (QueueNode* node = m_head->getNext(false); node != m_tail; node = node->getNext(false)) {
-		if (node == m_currSong) {
-			indicator = 1;
-			if (m_subQueueTail == nullptr || node == m_subQueueTail) {
-				indicator = 2;
-			}
-			// don't add currSong to any vectors
-			continue;
-		}
 
-		switch(indicator) {
-		case 0:
-			beforeCurrSong.push_back(node);
-			break;
-		case 1:
-			subQueue.push_back(node);
-			break;
-		case 2:
-			afterSubQueue.push_back(node);
-			break;
-		}
+/*!
+ *  @brief   Makes the lookahead window start at currSong and hold at least count nodes, unless the queue ends first
+ */
+void SongQueue::fillLookahead(int count) const
+{
+	if (m_lookaheadFrom != m_currSong) {
+		clearLookahead();
+	}
 
-		if (node == m_subQueueTail) {
-			indicator = 2;
+	// Drawing more of the shuffled order links nodes in, which must not clear the window being filled
+	m_lookaheadFrom = nullptr;
+	const QueueNode* node = m_lookahead.empty() ? m_currSong : m_lookahead.back();
+	while (!m_lookaheadAtEnd && static_cast<int>(m_lookahead.size()) < count) {
+		node = nextOf(node, isShuffled());
+		if (node == m_tail) {
+			m_lookaheadAtEnd = true;
+		}
+		else {
+			m_lookahead.push_back(node);
 		}
 	}
+	m_lookaheadFrom = m_currSong;
+}
 
-	std::random_shuffle(beforeCurrSong.begin(), beforeCurrSong.end());
-	std::random_shuffle(afterSubQueue.begin(), afterSubQueue.end());
-
-	// copy subQueue normal order to shuffled order
-	// this way subQueue maintains order
-	if (!subQueue.empty()) {
-		m_currSong->setNext(true, subQueue[0]);
-		subQueue[0]->setPrev(true, m_currSong);
 
-		for (auto s : subQueue) {
-			s->setNext(true, s->getNext(false));
-			s->setPrev(true, s->getNext(false));
-		}
+/*!
+ *  @brief       Clears the lookahead window if an edit at node, in the given order, changes it
+ *  @param[in]   insertion   Songs are inserted after node, otherwise node itself is removed
+ */
+void SongQueue::onEdit(const QueueNode* node, const bool& shuffled, bool insertion) const
+{
+	if (m_lookaheadFrom == nullptr || shuffled != isShuffled()) {
+		return;
+	}
+	if (node == m_lookaheadFrom) {
+		clearLookahead();
+		return;
 	}
 
-	if (!beforeCurrSong.empty()) {
-		m_head->setNext(true, beforeCurrSong[0]);
-		beforeCurrSong[0]->setPrev(true, m_head);
+	auto found = std::find(m_lookahead.begin(), m_lookahead.end(), node);
+	if (found == m_lookahead.end()) {
+		return;
+	}
+	// Songs inserted after the last node land past the window, unless it had reached the end of the queue
+	if (insertion && found + 1 == m_lookahead.end() && !m_lookaheadAtEnd) {
+		return;
+	}
+	clearLookahead();
+}
 
-		if (m_currSong != nullptr) {
-			m_currSong->setPrev(true, beforeCurrSong[beforeCurrSong.size() - 1]);
-			beforeCurrSong[beforeCurrSong.size() - 1]->setNext(true, m_currSong);
-		}
-		else if (!afterSubQueue.empty()) {
-			afterSubQueue[0]->setPrev(true, beforeCurrSong[beforeCurrSong.size() - 1]);
-			afterSubQueue[0]->getPrev(true)->setNext(true, afterSubQueue[0]);
-			beforeCurrSong[beforeCurrSong.size() - 1]->setNext(true, afterSubQueue[0]);
-		}
-		else {
-			m_tail->setPrev(true, beforeCurrSong[beforeCurrSong.size() - 1]);
-			beforeCurrSong[beforeCurrSong.size() - 1]->setNext(true, m_tail);
-		}
 
-		for (int i = 0; i < beforeCurrSong.size(); ++i) {
-			if (i != 0) {
-				beforeCurrSong[i]->setPrev(true, beforeCurrSong[i - 1]);
-			}
-			if (i != beforeCurrSong.size() - 1) {
-				beforeCurrSong[i]->setNext(true, beforeCurrSong[i + 1]);
-			}
-		}
-	}
+void SongQueue::clearLookahead() const
+{
+	m_lookahead.clear();
+	m_lookaheadFrom = nullptr;
+	m_lookaheadAtEnd = false;
+}
 
-	if (!afterSubQueue.empty()) {
-		m_subQueueTail->setNext(true, afterSubQueue[0]);
-		afterSubQueue[0]->setPrev(true, m_subQueueTail);
 
-		m_tail->setPrev(true, afterSubQueue[afterSubQueue.size() - 1]);
-		afterSubQueue[afterSubQueue.size() - 1]->setNext(true, m_tail);
+/*!
+ *  @brief   Creates a pooled node holding song's track id, interning song if the catalog doesn't know it yet
+ */
+SongQueue::QueueNode* SongQueue::newNode(const Song& song)
+{
+	QueueNode* node = createNode(m_catalog.intern(song));
 
-		for (int i = 0; i < afterSubQueue.size(); ++i) {
-			if (i != 0) {
-				afterSubQueue[i]->setPrev(true, afterSubQueue[i - 1]);
-			}
-			if (i != afterSubQueue.size() - 1) {
-				afterSubQueue[i]->setNext(true, afterSubQueue[i + 1]);
-			}
-		}
+	QueueNode* newest = m_index.find(song.number);
+	node->sameNext = newest;
+	if (newest != nullptr) {
+		newest->samePrev = node;
 	}
+	m_index.set(song.number, node);
+
+	return node;
 }
 
 
-SongQueue::operator std::vector<Song>() const
+void SongQueue::deleteNode(QueueNode* node)
 {
-	std::vector<Song> v;
-
-	for (auto song : *this) {
-		v.push_back(*song);
+	if (node->samePrev != nullptr) {
+		node->samePrev->sameNext = node->sameNext;
+	}
+	else if (node->sameNext != nullptr) {
+		m_index.set(songOf(node).number, node->sameNext);
+	}
+	else {
+		m_index.erase(songOf(node).number);
+	}
+	if (node->sameNext != nullptr) {
+		node->sameNext->samePrev = node->samePrev;
 	}
 
-	return v;
+	destroyNode(node);
 }
 
 
@@ -460,8 +772,10 @@ std::ostream& operator<<(std::ostream& out, const SongQueue& queue)
 	out << "Queue: [";
 
 	auto song = queue.begin();
-	out << (*song)->number;
-	++song;
+	if (song != queue.end()) {
+		out << (*song)->number;
+		++song;
+	}
 
 	for (; song != queue.end(); ++song) {
 		out << ", " << (*song)->number;
@@ -469,14 +783,14 @@ std::ostream& operator<<(std::ostream& out, const SongQueue& queue)
 	out << "]";
 
 	if (queue.m_currSong != nullptr) {
-		out << " currSong: " << queue.m_currSong->data->number;
+		out << " currSong: " << queue.songOf(queue.m_currSong).number;
 	}
 	else {
 		out << " currSong: nullptr";
 	}
 	
-	if (queue.m_subQueueTail != nullptr) {
-		out << " subQueueTail: " << queue.m_subQueueTail->data->number;
+	if (queue.m_subQueue.getTail() != nullptr) {
+		out << " subQueueTail: " << queue.songOf(queue.m_subQueue.getTail()).number;
 	}
 	else {
 		out << " subQueueTail: nullptr";
@@ -486,137 +800,209 @@ std::ostream& operator<<(std::ostream& out, const SongQueue& queue)
 }
 
 
-// Iterator Implementation
-SongQueue::Iterator::Iterator(const SongQueue& songQueue, const SongQueue::QueueNode* node) noexcept :
-	m_queue(songQueue), m_currNode(node) { };
-
-SongQueue::Iterator SongQueue::begin() const
+/*!
+ *  @brief       Window of count songs starting at offset in the current order, without copying any of them
+ *  @param[in]   offset   Index of the first song, 0 to size()
+ *  @param[in]   count    Songs wanted, the window stops early at the end of the queue
+ */
+SongQueue::View SongQueue::view(int offset, int count) const
 {
-	if (isEmpty()) {
-		return SongQueue::Iterator(*this, m_head);
+	QUEUE_METRICS_SCOPE(view);
+
+	if (offset < 0 || offset > m_size) {
+		throw std::invalid_argument("offset out of bounds");
+	}
+	if (count < 0) {
+		throw std::invalid_argument("count must not be negative");
 	}
-	
-	return SongQueue::Iterator(*this, m_head->getNext(isShuffled()));
-}
 
-SongQueue::Iterator SongQueue::end() const
-{
-	return SongQueue::Iterator(*this, m_tail);
+	count = std::min(count, m_size - offset);
+	const QueueNode* first = count > 0 ? seek(offset) : nullptr;
+	return View(*this, first, offset, count);
 }
 
-SongQueue::Iterator SongQueue::rbegin() const
+
+/*!
+ *  @brief       Window around currSong: up to before songs ahead of it, currSong itself and up to after songs past it.
+ *               With nothing playing it holds the first after songs.
+ */
+SongQueue::View SongQueue::around(int before, int after) const
 {
-	if (isEmpty()) {
-		return SongQueue::Iterator(*this, m_tail);
+	QUEUE_METRICS_SCOPE(view);
+
+	if (before < 0 || after < 0) {
+		throw std::invalid_argument("before and after must not be negative");
+	}
+	if (m_currSong == nullptr) {
+		return view(0, after);
 	}
-	return SongQueue::Iterator(*this, m_tail->getPrev(isShuffled()));
-}
 
-SongQueue::Iterator SongQueue::rend() const
-{
-	return SongQueue::Iterator(*this, nullptr);
-}
+	int currIndex = indexOf(m_currSong, isShuffled());
+	before = std::min(before, currIndex);
 
+	const QueueNode* first = m_currSong;
+	for (int i = 0; i < before; ++i) {
+		first = prevOf(first, isShuffled());
+	}
 
+	m_cursorNode = first;
+	m_cursorIndex = currIndex - before;
+	m_cursorVersion = getVersion();
 
-SongQueue::Iterator& SongQueue::Iterator::operator=(const SongQueue::QueueNode* node)
-{
-	m_currNode = node;
-	return *this;
+	return View(*this, first, currIndex - before, before + 1 + std::min(after, m_size - 1 - currIndex));
 }
 
-SongQueue::Iterator& SongQueue::Iterator::operator++()
-{
-	if (m_currNode) {
-		m_currNode = m_currNode->getNext(m_queue.isShuffled());
+
+/*!
+ *  @brief   Node at songIndex in the current order, walking from the last view's start when it is close by
+ *           and falling back to a treap lookup otherwise. songIndex must be in range.
+ */
+const SongQueue::QueueNode* SongQueue::seek(int songIndex) const
+{
+	// Past this a walk is slower than the O(log n) lookup
+	const int maxWalk = 64;
+
+	const QueueNode* node = nullptr;
+	if (m_cursorNode != nullptr && m_cursorVersion == getVersion()) {
+		int distance = songIndex - m_cursorIndex;
+		if (distance >= 0 && distance <= maxWalk) {
+			node = m_cursorNode;
+			QUEUE_METRICS_TRAVERSED(distance);
+			for (; distance > 0; --distance) {
+				node = nextOf(node, isShuffled());
+			}
+		}
+		else if (distance < 0 && distance >= -maxWalk) {
+			node = m_cursorNode;
+			QUEUE_METRICS_TRAVERSED(-distance);
+			for (; distance < 0; ++distance) {
+				node = prevOf(node, isShuffled());
+			}
+		}
 	}
-	return *this;
+	if (node == nullptr) {
+		node = nodeAt(songIndex, isShuffled());
+	}
+
+	m_cursorNode = node;
+	m_cursorIndex = songIndex;
+	m_cursorVersion = getVersion();
+	return node;
 }
 
-SongQueue::Iterator SongQueue::Iterator::operator++(int)
+
+// View Implementation
+SongQueue::View::View(const SongQueue& songQueue, const QueueNode* first, int offset, int count) noexcept :
+	m_queue(&songQueue), m_first(first), m_offset(offset), m_count(count) { }
+
+SongQueue::View::Iterator SongQueue::View::begin() const
 {
-	Iterator iter = *this;
-	++* this;
-	return iter;
+	return Iterator(m_queue, m_first, m_count, false);
 }
 
-SongQueue::Iterator& SongQueue::Iterator::operator--()
+SongQueue::View::Iterator SongQueue::View::end() const
 {
-	if (m_currNode)
-		m_currNode = m_currNode->getPrev(m_queue.isShuffled());
-	return *this;
+	return Iterator(m_queue, nullptr, 0, false);
 }
 
-SongQueue::Iterator SongQueue::Iterator::operator--(int)
+SongQueue::View::Iterator SongQueue::View::rbegin() const
 {
-	Iterator iter = *this;
-	--* this;
-	return iter;
+	const QueueNode* last = m_first;
+	for (int i = 1; i < m_count; ++i) {
+		last = m_queue->nextOf(last, m_queue->isShuffled());
+	}
+	return Iterator(m_queue, last, m_count, true);
 }
 
-bool SongQueue::Iterator::operator!=(const Iterator& iter) const
+SongQueue::View::Iterator SongQueue::View::rend() const
 {
-	return m_currNode != iter.m_currNode;
+	return Iterator(m_queue, nullptr, 0, true);
 }
 
 
-Song const * SongQueue::Iterator::operator*() const
+/*!
+ *  @return  Index of the window's first song in the current order
+ */
+int SongQueue::View::getOffset() const
 {
-	return (m_currNode->data).get();
+	return m_offset;
 }
 
+bool SongQueue::View::isEmpty() const
+{
+	return m_count == 0;
+}
 
-// QueueNode Implementation
-SongQueue::QueueNode::QueueNode() :
-	next(nullptr), prev(nullptr), nextShuffled(nullptr), prevShuffled(nullptr) { };
+int SongQueue::View::size() const
+{
+	return m_count;
+}
 
 
-SongQueue::QueueNode::QueueNode(std::unique_ptr<Song> song) :
-	data(std::move(song)), next(nullptr), prev(nullptr), nextShuffled(nullptr), prevShuffled(nullptr) {};
+SongQueue::View::Iterator::Iterator(const SongQueue* songQueue, const QueueNode* node, int remaining, bool reverse) noexcept :
+	m_queue(songQueue), m_currNode(node), m_remaining(remaining), m_reverse(reverse) { }
 
+SongQueue::View::Iterator& SongQueue::View::Iterator::operator++()
+{
+	m_remaining -= 1;
+	if (m_remaining == 0) {
+		m_currNode = nullptr;
+	}
+	else if (m_reverse) {
+		m_currNode = m_queue->prevOf(m_currNode, m_queue->isShuffled());
+	}
+	else {
+		m_currNode = m_queue->nextOf(m_currNode, m_queue->isShuffled());
+	}
+	return *this;
+}
 
-void SongQueue::QueueNode::setNext(QueueNode* node)
+SongQueue::View::Iterator SongQueue::View::Iterator::operator++(int)
 {
-	next = node;
-	nextShuffled = node;
+	Iterator iter = *this;
+	++* this;
+	return iter;
 }
 
+bool SongQueue::View::Iterator::operator!=(const Iterator& iter) const
+{
+	return m_remaining != iter.m_remaining;
+}
 
-void SongQueue::QueueNode::setPrev(QueueNode* node)
+Song const * SongQueue::View::Iterator::operator*() const
 {
-	prev = node;
-	prevShuffled = node;
+	return &m_queue->songOf(m_currNode);
 }
 
 
-void SongQueue::QueueNode::setNext(const bool& shuffled, QueueNode* node)
+/*!
+ *  @brief   The songs in the order they were added, whether or not the queue is shuffled
+ */
+SongQueue::Order<false> SongQueue::unshuffledOrder() const
 {
-	if (shuffled) {
-		nextShuffled = node;
-	}
-	else {
-		next = node;
-	}
+	return Order<false>(*this);
 }
 
 
-void SongQueue::QueueNode::setPrev(const bool& shuffled, QueueNode* node)
+/*!
+ *  @brief   The shuffled order, drawing every song not yet drawn so its links are complete.
+ *           Only meaningful while the queue is shuffled, the links of an earlier shuffle go stale.
+ */
+SongQueue::Order<true> SongQueue::shuffledOrder() const
 {
-	if (shuffled) {
-		prevShuffled = node;
-	}
-	else {
-		prev = node;
+	if (!isShuffled()) {
+		throw std::invalid_argument("queue is not shuffled");
 	}
+	placeAll();
+	return Order<true>(*this);
 }
 
-SongQueue::QueueNode* SongQueue::QueueNode::getNext(const bool& shuffled) const
-{
-	return shuffled ? nextShuffled : next;
-}
 
+// SongQueueNode Implementation
+SongQueueNode::SongQueueNode() :
+	track(0), sameNext(nullptr), samePrev(nullptr) { }
+
+
+SongQueueNode::SongQueueNode(SongCatalog::TrackId track) :
+	track(track), sameNext(nullptr), samePrev(nullptr) { }
 
-SongQueue::QueueNode* SongQueue::QueueNode::getPrev(const bool& shuffled) const
-{
-	return shuffled ? prevShuffled : prev;
-}
\ No newline at end of file
@@ -1,119 +1,359 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "song.h"
 #include "repeat_mode.h"
+#include "basic_song_queue.h"
+#include "treap_queue.h"
+#include "song_catalog.h"
+#include "song_index.h"
+#include "queue_snapshot.h"
+#include "queue_change_log.h"
+#include "queue_metrics.h"
+
+
+/// Node of SongQueue: the engine's links, the song's track id and the chain of nodes holding the same song.
+/// Declared outside SongQueue so the engine it derives from can name it.
+class SongQueueNode : public TreapQueueNode<SongQueueNode, ShuffleOn>
+{
+public:
+	SongQueueNode();
+	SongQueueNode(SongCatalog::TrackId track);
 
+	/// Resolved through the queue's catalog, unused for the sentinels
+	SongCatalog::TrackId track;
+
+	/// Other nodes of the same song, the queue's index holds the one added last
+	SongQueueNode* sameNext;
+	SongQueueNode* samePrev;
+};
 
-class SongQueue
+
+/// The default configuration of BasicSongQueue: songs interned in the catalog and held by track id in pooled
+/// nodes, a lazily drawn shuffle, O(log n) indexing through a treap per order, the index by song number,
+/// snapshots and deltas for clients.
+/// Not thread-safe, not even between const readers: getSongAt(), findSong(), the iterators, view() and peekNext()
+/// draw the lazy shuffle and fill the view cursor and lookahead caches through mutable members. Threads share a
+/// queue through SharedSongQueue, or read snapshot()s, which are immutable.
+using SongQueue = BasicSongQueue<Song>;
+
+template <>
+class BasicSongQueue<Song, std::allocator<Song>, ShuffleOn, SubQueueOn> :
+	public TreapQueue<SongQueue, Song, SongQueueNode, std::allocator<Song>, ShuffleOn, SubQueueOn>
 {
+private:
+	using QueueNode = SongQueueNode;
+
 public:
-	SongQueue();
-	~SongQueue();
+	BasicSongQueue();
+	~BasicSongQueue();
+	using TreapQueue::addToQueue;
+	using TreapQueue::addToSubQueue;
 	void addToQueue(std::unique_ptr<Song> song);
 	void addToSubQueue(std::unique_ptr<Song> song);
-	void removeFromQueue(const int& songIndex);
-	void moveSong(const int& oldSongIndex, const int& newSongIndex);
-	bool nextSong(RepeatMode repeatMode);
-	bool prevSong();
 
-	void clear();
+	// By song number, through the index
+	bool removeSong(int songNumber);
+	int removeAllOccurrences(int songNumber);
+	bool jumpTo(int songNumber);
 
-	// GETTERS
-	const Song* getSongAt(int songIndex) const;
-	bool isEmpty() const;
-	bool isShuffled() const;
-	int size() const;
+	void reserve(int count);
 
-	// SETTERS
-	void setCurrSong(const int& songIndex);
-	void setShuffled(const bool& shuffled);
+	void save(std::vector<unsigned char>& out) const;
+	std::size_t load(const unsigned char* data, std::size_t size);
+
+	// GETTERS
+	int findSong(int songNumber) const;
+	bool contains(int songNumber) const;
+	std::vector<const Song*> peekNext(int count, RepeatMode repeatMode = RepeatMode::off) const;
+	std::vector<const Song*> peekPrev(int count) const;
+	std::size_t memoryUsage() const;
+	QueueSnapshot snapshot() const;
+	std::uint64_t getVersion() const;
+	bool getDelta(std::uint64_t version, std::vector<unsigned char>& delta) const;
 
 	// OVERLOADS
-	operator std::vector<Song>() const;
 	friend std::ostream& operator<<(std::ostream& out, const SongQueue& queue);
 
 
-	class Iterator;
-	class QueueNode;
+	class View;
+
+	View view(int offset, int count) const;
+	View around(int before, int after) const;
+
+
+	template <bool Shuffled>
+	class OrderIterator;
+	template <bool Shuffled>
+	class Order;
 
-	Iterator begin() const;
-	Iterator end() const;
-	Iterator rbegin() const;
-	Iterator rend() const;
+	Order<false> unshuffledOrder() const;
+	Order<true> shuffledOrder() const;
 
-	class Iterator
+	/// Iterator fixed to one order at compile time. It steps straight along that order's links
+	/// and resolves songs through the catalog, so it neither branches on the order nor holds the queue.
+	/// Invalidated by any edit to the queue, like Iterator.
+	template <bool Shuffled>
+	class OrderIterator
 	{
 	public:
-		// Iterator(const SongQueue& songQueue, const QueueNode* node);
-		Iterator(const SongQueue& songQueue, const SongQueue::QueueNode* node) noexcept;
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = const Song*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Song*;
+		using reference = const Song*;
 
-		Iterator& operator=(const QueueNode* node);
+		OrderIterator() noexcept;
 
-		Iterator& operator++();    // Prefix
-		Iterator operator++(int);  // Postfix
+		OrderIterator& operator++();    // Prefix
+		OrderIterator operator++(int);  // Postfix
 
-		Iterator& operator--();    // Prefix
-		Iterator operator--(int);  // Postfix
+		OrderIterator& operator--();    // Prefix
+		OrderIterator operator--(int);  // Postfix
 
-		bool operator!=(const Iterator& iter) const;
+		bool operator==(const OrderIterator& iter) const;
+		bool operator!=(const OrderIterator& iter) const;
 		Song const * operator*() const;
+		Song const * operator->() const;
 
 	private:
-		const SongQueue& m_queue;
+		friend class Order<Shuffled>;
+
+		OrderIterator(const SongCatalog& catalog, const QueueNode* node) noexcept;
+
+		const SongCatalog* m_catalog;
 		const QueueNode* m_currNode;
 	};
 
+	/// One order of the queue as a range. end() is the tail sentinel, so it can be stepped back from.
+	template <bool Shuffled>
+	class Order
+	{
+	public:
+		OrderIterator<Shuffled> begin() const;
+		OrderIterator<Shuffled> end() const;
 
-private:
+		// GETTERS
+		int size() const;
 
-	// No copying from SongQueue
-	SongQueue(const SongQueue&) = delete;
-	void operator=(const SongQueue&) = delete;
+	private:
+		friend SongQueue;
 
-	class QueueNode
+		Order(const SongQueue& songQueue) noexcept;
+
+		const SongQueue* m_queue;
+	};
+
+
+	/// Window of consecutive songs in the current order, read in place without copying.
+	/// Like Iterator it is invalidated by any edit to the queue.
+	class View
 	{
 	public:
-		QueueNode();
-		QueueNode(std::unique_ptr<Song> song);
+		class Iterator;
 
-		void setNext(QueueNode* node);
-		void setPrev(QueueNode* node);
+		Iterator begin() const;
+		Iterator end() const;
+		Iterator rbegin() const;
+		Iterator rend() const;
 
-		void setNext(const bool& shuffled, QueueNode* node);
-		void setPrev(const bool& shuffled, QueueNode* node);
+		// GETTERS
+		int getOffset() const;
+		bool isEmpty() const;
+		int size() const;
 
-		QueueNode* getNext(const bool& shuffled) const;
-		QueueNode* getPrev(const bool& shuffled) const;
+		class Iterator
+		{
+		public:
+			Iterator(const SongQueue* songQueue, const QueueNode* node, int remaining, bool reverse) noexcept;
 
-		std::unique_ptr<Song> data;
+			Iterator& operator++();    // Prefix
+			Iterator operator++(int);  // Postfix
 
+			bool operator!=(const Iterator& iter) const;
+			Song const * operator*() const;
+
+		private:
+			const SongQueue* m_queue;
+			const QueueNode* m_currNode;
+			/// Songs left including the current one, so the window never reads past its end
+			int m_remaining;
+			bool m_reverse;
+		};
 
 	private:
-		QueueNode* next;
-		QueueNode* prev;
-		QueueNode* nextShuffled;
-		QueueNode* prevShuffled;
+		friend SongQueue;
+
+		View(const SongQueue& songQueue, const QueueNode* first, int offset, int count) noexcept;
+
+		const SongQueue* m_queue;
+		const QueueNode* m_first;
+		int m_offset;
+		int m_count;
 	};
 
 
-	void shuffle();
+private:
+	friend TreapQueue;
 
+	// No copying from SongQueue
+	BasicSongQueue(const BasicSongQueue&) = delete;
+	void operator=(const BasicSongQueue&) = delete;
+
+	/// "SPQ" followed by the format version, bumped whenever the saved layout changes
+	static const std::uint32_t kSaveMagic = 0x00515053u;
+	static const std::uint8_t kSaveVersion = 1;
+
+	/// Longest window peekNext() keeps, it reads further songs without caching them
+	static const int kMaxLookahead = 64;
+
+	// TreapQueue hooks, keeping the index, the persistent copy, the change log and the lookahead in step
+	QueueNode* newNode(const Song& song);
+	void deleteNode(QueueNode* node);
+	const Song& songOf(const QueueNode* node) const { return m_catalog.get(node->track); }
+	void onAppended(QueueNode* first, int count, bool allDrawn);
+	void onInserted(QueueNode* first, int count);
+	void onRemoved(int songIndex);
+	void onMoved(int songIndex, int newSongIndex, const QueueNode* node);
+	void onCursorMove(const QueueNode* node);
+	void onReset();
+	void onCleared();
+	void onPlaced(const QueueNode* node, const bool& front) const;
+	void onEdit(const QueueNode* node, const bool& shuffled, bool insertion) const;
+
+	const QueueNode* seek(int songIndex) const;
+	void drawPlayed(int songNumber) const;
+	QueueNode* firstOccurrence(int songNumber, int& songIndex) const;
+
+	// Lookahead window for peekNext()
+	void fillLookahead(int count) const;
+	void clearLookahead() const;
+
+	PersistentSongList persistentOf(const QueueNode* first, int count) const;
+	void recordAppended(int count, bool allDrawn);
+	void position(int& currIndex, int& subQueueSize) const;
+
+
+	/// Holds the songs, nodes only keep their track id
+	SongCatalog& m_catalog;
+	/// Song number to the newest node of that song, for lookups by id
+	SongIndex<QueueNode> m_index;
+
+	/// Persistent copy of the current order that snapshots share. Only kept in sync once
+	/// snapshot() has been called, and rebuilt by the next snapshot() after a (re)shuffle.
+	mutable PersistentSongList m_persistent;
+	mutable bool m_persistentValid;
+
+	/// Edits to the current order since the queue was created, for client deltas
+	QueueChangeLog m_changes;
+
+	/// Last position a view started from, valid while m_cursorVersion matches getVersion()
+	mutable const QueueNode* m_cursorNode;
+	mutable int m_cursorIndex;
+	mutable std::uint64_t m_cursorVersion;
+
+	/// Nodes following m_lookaheadFrom in the current order, as far as peekNext() has read them.
+	/// Only edits next to or inside the window clear it, nextSong() slides it along.
+	mutable std::vector<const QueueNode*> m_lookahead;
+	mutable const QueueNode* m_lookaheadFrom;
+	/// The window stops at the end of the queue rather than where the last peekNext() stopped reading
+	mutable bool m_lookaheadAtEnd;
+};
 
-	/// Data will be nullptr so songs can be unshuffled and maintain previous order
-	QueueNode* m_head;
-	/// Data will be nullptr so songs can be unshuffled and maintain previous order
-	QueueNode* m_tail;
 
-	QueueNode* m_subQueueTail;
-	QueueNode* m_currSong;
+// OrderIterator Implementation
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled>::OrderIterator() noexcept :
+	m_catalog(nullptr), m_currNode(nullptr) { }
 
-	int m_size;
-	bool m_shuffled;
-};
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled>::OrderIterator(const SongCatalog& catalog, const QueueNode* node) noexcept :
+	m_catalog(&catalog), m_currNode(node) { }
+
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled>& SongQueue::OrderIterator<Shuffled>::operator++()
+{
+	m_currNode = m_currNode->links[Shuffled].next;
+	return *this;
+}
+
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled> SongQueue::OrderIterator<Shuffled>::operator++(int)
+{
+	OrderIterator iter = *this;
+	++* this;
+	return iter;
+}
+
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled>& SongQueue::OrderIterator<Shuffled>::operator--()
+{
+	m_currNode = m_currNode->links[Shuffled].prev;
+	return *this;
+}
+
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled> SongQueue::OrderIterator<Shuffled>::operator--(int)
+{
+	OrderIterator iter = *this;
+	--* this;
+	return iter;
+}
+
+template <bool Shuffled>
+bool SongQueue::OrderIterator<Shuffled>::operator==(const OrderIterator& iter) const
+{
+	return m_currNode == iter.m_currNode;
+}
+
+template <bool Shuffled>
+bool SongQueue::OrderIterator<Shuffled>::operator!=(const OrderIterator& iter) const
+{
+	return m_currNode != iter.m_currNode;
+}
+
+template <bool Shuffled>
+Song const * SongQueue::OrderIterator<Shuffled>::operator*() const
+{
+	return &m_catalog->get(m_currNode->track);
+}
+
+template <bool Shuffled>
+Song const * SongQueue::OrderIterator<Shuffled>::operator->() const
+{
+	return &m_catalog->get(m_currNode->track);
+}
+
+
+// Order Implementation
+template <bool Shuffled>
+SongQueue::Order<Shuffled>::Order(const SongQueue& songQueue) noexcept :
+	m_queue(&songQueue) { }
+
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled> SongQueue::Order<Shuffled>::begin() const
+{
+	return OrderIterator<Shuffled>(m_queue->m_catalog, m_queue->m_head->getNext(Shuffled));
+}
+
+template <bool Shuffled>
+SongQueue::OrderIterator<Shuffled> SongQueue::Order<Shuffled>::end() const
+{
+	return OrderIterator<Shuffled>(m_queue->m_catalog, m_queue->m_tail);
+}
+
+template <bool Shuffled>
+int SongQueue::Order<Shuffled>::size() const
+{
+	return m_queue->size();
+}
 
 
-#endif
\ No newline at end of file
+#endif
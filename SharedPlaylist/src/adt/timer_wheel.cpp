@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "timer_wheel.h"
+
+
+const int TimerWheel::kSlots;
+
+
+/*!
+ *  @param[in]   tick    Length of one slot, timers fire on the first tick at or after their expiry
+ *  @param[in]   start   Time of tick 0
+ */
+TimerWheel::TimerWheel(Clock::duration tick, Clock::time_point start) :
+	m_slots(kSlots), m_start(start), m_tick(tick), m_ticks(0), m_size(0)
+{
+	if (tick <= Clock::duration::zero()) {
+		throw std::invalid_argument("tick must be positive");
+	}
+
+	for (Timer& slot : m_slots) {
+		slot.m_prev = slot.m_next = &slot;
+	}
+}
+
+
+TimerWheel::~TimerWheel()
+{
+
+}
+
+
+/*!
+ *  @brief       Arms timer to fire at when, moving it if it is already scheduled
+ *  @param[in]   when   Times that already passed fire on the next tick
+ */
+void TimerWheel::schedule(Timer& timer, Clock::time_point when)
+{
+	cancel(timer);
+
+	std::int64_t expiry = m_ticks + 1;
+	if (when > m_start) {
+		// Rounded up, a timer never fires early
+		const Clock::duration since = when - m_start;
+		expiry = std::max(expiry, static_cast<std::int64_t>((since + m_tick - Clock::duration(1)) / m_tick));
+	}
+
+	timer.m_expiry = expiry;
+	link(m_slots[expiry % kSlots], timer);
+	m_size += 1;
+}
+
+
+/*!
+ *  @brief   Disarms timer, does nothing if it isn't scheduled
+ */
+void TimerWheel::cancel(Timer& timer)
+{
+	if (timer.isScheduled()) {
+		unlink(timer);
+		m_size -= 1;
+	}
+}
+
+
+/*!
+ *  @return  Time of the tick the wheel last advanced to
+ */
+TimerWheel::Clock::time_point TimerWheel::now() const
+{
+	return m_start + m_tick * m_ticks;
+}
+
+
+/*!
+ *  @return  Time advance() has to reach for the wheel to move on
+ */
+TimerWheel::Clock::time_point TimerWheel::nextTick() const
+{
+	return m_start + m_tick * (m_ticks + 1);
+}
+
+
+/*!
+ *  @return  Number of scheduled timers
+ */
+int TimerWheel::size() const
+{
+	return m_size;
+}
+
+
+void TimerWheel::link(Timer& slot, Timer& timer)
+{
+	timer.m_prev = slot.m_prev;
+	timer.m_next = &slot;
+	slot.m_prev->m_next = &timer;
+	slot.m_prev = &timer;
+}
+
+
+void TimerWheel::unlink(Timer& timer)
+{
+	timer.m_prev->m_next = timer.m_next;
+	timer.m_next->m_prev = timer.m_prev;
+	timer.m_prev = timer.m_next = nullptr;
+}
+
+
+/*!
+ *  @brief   Moves every timer in from to the end of to, leaving from empty
+ */
+void TimerWheel::splice(Timer& from, Timer& to)
+{
+	if (from.m_next == &from) {
+		return;
+	}
+
+	from.m_next->m_prev = to.m_prev;
+	to.m_prev->m_next = from.m_next;
+	from.m_prev->m_next = &to;
+	to.m_prev = from.m_prev;
+	from.m_prev = from.m_next = &from;
+}
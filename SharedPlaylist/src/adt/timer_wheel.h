@@ -0,0 +1,124 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+/// Hashed timing wheel: kSlots slots of one tick each, a timer waits in the slot its expiry tick maps to.
+/// Scheduling and cancelling are O(1) and never allocate, since timers are linked into the slots intrusively.
+/// Advancing one tick only looks at one slot, timers more than a revolution away stay in it until they are due.
+class TimerWheel
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static const int kSlots = 4096;
+
+	/// Embedded in whatever it times out. Must be cancelled before it is destroyed.
+	class Timer
+	{
+	public:
+		Timer() : m_prev(nullptr), m_next(nullptr), m_expiry(0) { }
+
+		bool isScheduled() const { return m_next != nullptr; }
+
+	private:
+		friend class TimerWheel;
+
+		// No copying from Timer, the wheel links to it
+		Timer(const Timer&) = delete;
+		void operator=(const Timer&) = delete;
+
+		Timer* m_prev;
+		Timer* m_next;
+		std::int64_t m_expiry;
+	};
+
+	TimerWheel(Clock::duration tick, Clock::time_point start);
+	~TimerWheel();
+
+	void schedule(Timer& timer, Clock::time_point when);
+	void cancel(Timer& timer);
+	template <class Fire>
+	void advance(Clock::time_point now, Fire fire);
+
+	// GETTERS
+	Clock::time_point now() const;
+	Clock::time_point nextTick() const;
+	int size() const;
+
+
+private:
+
+	// No copying from TimerWheel
+	TimerWheel(const TimerWheel&) = delete;
+	void operator=(const TimerWheel&) = delete;
+
+	static void link(Timer& slot, Timer& timer);
+	static void unlink(Timer& timer);
+	static void splice(Timer& from, Timer& to);
+
+
+	/// Circular lists, each slot is the sentinel of its own
+	std::vector<Timer> m_slots;
+	Clock::time_point m_start;
+	Clock::duration m_tick;
+	/// Ticks since m_start the wheel has advanced through
+	std::int64_t m_ticks;
+	int m_size;
+};
+
+
+/*!
+ *  @brief       Moves the wheel forward to now, calling fire(timer) for every timer that is due, in tick order.
+ *               A fired timer is no longer scheduled, fire can schedule it again or schedule and cancel others.
+ *  @param[in]   now    Times before the wheel's current tick are ignored
+ *  @param[in]   fire   Called with Timer&
+ */
+template <class Fire>
+void TimerWheel::advance(Clock::time_point now, Fire fire)
+{
+	if (now < m_start) {
+		return;
+	}
+
+	const std::int64_t target = (now - m_start) / m_tick;
+	while (m_ticks < target) {
+		if (m_size == 0) {
+			m_ticks = target;
+			break;
+		}
+
+		m_ticks += 1;
+		Timer& slot = m_slots[m_ticks % kSlots];
+
+		// Timers are taken off the slot first, so whatever fire does to the slot can't confuse the walk
+		Timer pending;
+		pending.m_prev = pending.m_next = &pending;
+		splice(slot, pending);
+		try {
+			while (pending.m_next != &pending) {
+				Timer& timer = *pending.m_next;
+				unlink(timer);
+				if (timer.m_expiry <= m_ticks) {
+					m_size -= 1;
+					fire(timer);
+				}
+				else {
+					link(slot, timer);
+				}
+			}
+		}
+		catch (...) {
+			// The rest of this tick runs on the next advance
+			splice(pending, slot);
+			m_ticks -= 1;
+			throw;
+		}
+	}
+}
+
+
+#endif
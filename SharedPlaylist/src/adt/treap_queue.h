@@ -0,0 +1,1754 @@
+#ifndef TREAP_QUEUE_H
+#define TREAP_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "repeat_mode.h"
+#include "object_pool.h"
+#include "shuffle_rng.h"
+#include "queue_metrics.h"
+
+
+/// Shuffle policies for TreapQueue. ShuffleOn keeps a shuffled order next to the order songs were added in,
+/// ShuffleOff drops the second set of links and the lazy draw state from every node, and the shuffle state
+/// from the queue. The queue only reaches either through NodeState and State, which ShuffleOff stubs out,
+/// so the shuffled branches fold away.
+struct ShuffleOn
+{
+	static const bool enabled = true;
+
+	/// Lazy shuffle state, only meaningful while drawGen matches the queue's shuffle generation.
+	/// pending counts the songs not yet drawn in this node's unshuffled subtree.
+	struct NodeState
+	{
+		NodeState() : drawGen(0), pending(0), placed(false) { }
+
+		bool isPlaced(unsigned int gen) const { return drawGen == gen && placed; }
+		int pendingOf(unsigned int gen, int size) const { return drawGen == gen ? pending : size; }
+		void setDraw(unsigned int gen, bool drawn, int undrawn)
+		{
+			drawGen = gen;
+			placed = drawn;
+			pending = undrawn;
+		}
+
+		unsigned int drawGen;
+		int pending;
+		bool placed;
+	};
+
+	template <class Node>
+	struct State
+	{
+		State() :
+			seed((std::uint64_t(std::random_device{}()) << 32) | std::random_device{}()),
+			from(nullptr), gen(0), shuffled(false) { }
+
+		bool isShuffled() const { return shuffled; }
+		unsigned int generation() const { return gen; }
+		Node* getFrom() const { return from; }
+		void setFrom(Node* node) const { from = node; }
+		std::uint32_t below(std::uint32_t bound) const { return rng.below(bound); }
+
+		/// Seed of the next shuffle. Each shuffle reseeds rng from it and then advances it,
+		/// so the shuffled order only depends on the seed, the queue and the edits made since.
+		std::uint64_t seed;
+		mutable ShuffleRng rng;
+		/// Songs not drawn yet that come before this node in the unshuffled order were played before the shuffle,
+		/// they make up the front of the shuffled order and are drawn back to front. nullptr once there are none,
+		/// the tail sentinel if the node it was set to is gone and no song has been added since.
+		mutable Node* from;
+		/// Bumped on every shuffle, which un-draws every song at once
+		unsigned int gen;
+		bool shuffled;
+	};
+};
+
+struct ShuffleOff
+{
+	static const bool enabled = false;
+
+	/// Every song counts as drawn
+	struct NodeState
+	{
+		bool isPlaced(unsigned int) const { return true; }
+		int pendingOf(unsigned int, int) const { return 0; }
+		void setDraw(unsigned int, bool, int) { }
+	};
+
+	template <class Node>
+	struct State
+	{
+		bool isShuffled() const { return false; }
+		unsigned int generation() const { return 0; }
+		Node* getFrom() const { return nullptr; }
+		void setFrom(Node*) const { }
+		std::uint32_t below(std::uint32_t) const { return 0; }
+	};
+};
+
+
+/// Sub queue policies for TreapQueue. SubQueueOff drops the sub queue tail and the bookkeeping
+/// that keeps it in place, addToSubQueue() does not compile for it.
+struct SubQueueOn
+{
+	static const bool enabled = true;
+
+	template <class Node>
+	struct State
+	{
+		State() : tail(nullptr) { }
+
+		Node* getTail() const { return tail; }
+		void setTail(Node* node) { tail = node; }
+
+		Node* tail;
+	};
+};
+
+struct SubQueueOff
+{
+	static const bool enabled = false;
+
+	template <class Node>
+	struct State
+	{
+		Node* getTail() const { return nullptr; }
+		void setTail(Node*) { }
+	};
+};
+
+
+/// Links a TreapQueue node keeps in every order it belongs to, the node type derives from it:
+///     struct MyNode : TreapQueueNode<MyNode, ShufflePolicy> { payload };
+/// For each order a node keeps its linked list neighbours, for O(1) stepping, and its place in an
+/// implicit treap keyed by position, for O(log n) index lookup, insertion and removal.
+template <class Node, class ShufflePolicy>
+class TreapQueueNode : public ShufflePolicy::NodeState
+{
+public:
+	/// Orders each node is linked into: the unshuffled one, and the shuffled one if the policy keeps it
+	static const int kOrders = ShufflePolicy::enabled ? 2 : 1;
+
+	struct OrderLinks
+	{
+		Node* next;
+		Node* prev;
+
+		Node* left;
+		Node* right;
+		Node* parent;
+		int size;  // number of nodes in the treap rooted here
+	};
+
+	TreapQueueNode();
+
+	void setNext(Node* node);
+	void setPrev(Node* node);
+
+	void setNext(const bool& shuffled, Node* node);
+	void setPrev(const bool& shuffled, Node* node);
+
+	Node* getNext(const bool& shuffled) const;
+	Node* getPrev(const bool& shuffled) const;
+
+	OrderLinks& linksOf(const bool& shuffled);
+	const OrderLinks& linksOf(const bool& shuffled) const;
+
+	/// Indexed by the shuffled flag: [0] unshuffled order, [1] shuffled order
+	OrderLinks links[kOrders];
+	unsigned int priority;
+};
+
+
+/// Queue engine shared by every BasicSongQueue: nodes carved from an ObjectPool, an order-statistic treap
+/// per order for O(log n) indexing, and a lazily drawn shuffle. Playback follows SongQueue: a sub queue
+/// plays in order after currSong, and a shuffle puts currSong and the sub queue first.
+///
+/// Derived is the queue built on it and names the engine a friend. It supplies the payload through:
+///     Node* newNode(const T& song)            a node from createNode() holding song, also called with T&&
+///     void deleteNode(Node* node)             releases the payload and hands node to destroyNode()
+///     const T& songOf(const Node* node) const
+/// and may hide any of the no-op hooks below to keep state of its own in sync with the orders.
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+class TreapQueue
+{
+public:
+	using value_type = T;
+	using allocator_type = Allocator;
+
+	void addToQueue(const T& song);
+	void addToQueue(T&& song);
+	void addToSubQueue(const T& song);
+	void addToSubQueue(T&& song);
+	template <class... Args>
+	void emplaceToQueue(Args&&... args);
+	template <class... Args>
+	void emplaceToSubQueue(Args&&... args);
+	template <class InputIt>
+	void addRangeToQueue(InputIt first, InputIt last);
+	template <class InputIt>
+	void addRangeToSubQueue(InputIt first, InputIt last);
+	void removeFromQueue(const int& songIndex);
+	void moveSong(const int& oldSongIndex, const int& newSongIndex);
+	bool nextSong(RepeatMode repeatMode);
+	bool prevSong();
+
+	void clear();
+	void reserve(int count);
+
+	// GETTERS
+	const T* getSongAt(int songIndex) const;
+	const T* getCurrSong() const;
+	bool isEmpty() const;
+	bool isShuffled() const;
+	int size() const;
+	std::uint64_t getShuffleSeed() const;
+
+	// SETTERS
+	void setCurrSong(const int& songIndex);
+	void setShuffled(const bool& shuffled);
+	void setShuffleSeed(std::uint64_t seed);
+
+	// OVERLOADS
+	operator std::vector<T>() const;
+
+
+	class Iterator;
+
+	Iterator begin() const;
+	Iterator end() const;
+	Iterator rbegin() const;
+	Iterator rend() const;
+
+	/// Bidirectional iterator over the current order, whichever it is when each step is taken.
+	/// Dereferencing gives the song's address, so it->member reads the song directly.
+	class Iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = const T*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T*;
+
+		Iterator() noexcept;
+
+		Iterator& operator++();    // Prefix
+		Iterator operator++(int);  // Postfix
+
+		Iterator& operator--();    // Prefix
+		Iterator operator--(int);  // Postfix
+
+		bool operator==(const Iterator& iter) const;
+		bool operator!=(const Iterator& iter) const;
+		T const * operator*() const;
+		T const * operator->() const;
+
+	private:
+		friend class TreapQueue;
+
+		Iterator(const TreapQueue& songQueue, const Node* node) noexcept;
+
+		const TreapQueue* m_queue;
+		const Node* m_currNode;
+	};
+
+
+protected:
+	using ShuffleTag = std::integral_constant<bool, ShufflePolicy::enabled>;
+
+	explicit TreapQueue(const Allocator& allocator);
+	~TreapQueue() = default;
+
+	Derived& derived() { return static_cast<Derived&>(*this); }
+	const Derived& derived() const { return static_cast<const Derived&>(*this); }
+
+	// Hooks Derived may hide, called after the engine has made the change unless noted otherwise.
+	// Appended songs only join the unshuffled order, allDrawn tells whether every song after the played
+	// ones had been drawn before them. The others report edits to the current order.
+	void onAppended(Node*, int, bool) { }
+	void onInserted(Node*, int) { }
+	void onRemoved(int) { }
+	void onMoved(int, int, const Node*) { }
+	void onCursorMove(const Node*) { }        // before currSong moves to the node
+	void onReset() { }                        // before the current order is replaced
+	void onCleared() { }
+	void onPlaced(const Node*, const bool&) const { }
+	void onEdit(const Node*, const bool&, bool) const { }  // before the order changes next to the node
+	void releaseNodes();
+
+	void shuffle(std::true_type, const bool& keepPlayed);
+	void shuffle(std::false_type, const bool& keepPlayed);
+	Node* wrapAround();
+
+	// Order-statistic treap, one per order. Sentinels never belong to a treap.
+	// These are const so the shuffled order can be drawn lazily from const readers,
+	// they only touch nodes and the mutable roots.
+	static int treeSize(const Node* node, const bool& shuffled);
+	Node*& rootOf(const bool& shuffled) const;
+	void update(Node* node, const bool& shuffled) const;
+	Node* merge(Node* left, Node* right, const bool& shuffled) const;
+	void split(Node* root, int count, const bool& shuffled, Node*& left, Node*& right) const;
+
+	Node* nodeAt(int songIndex, const bool& shuffled) const;
+	int indexOf(const Node* node, const bool& shuffled) const;
+	int treeIndex(const Node* node, const bool& shuffled) const;
+	void insertAfter(Node* pos, Node* node, const bool& shuffled) const;
+	void unlink(Node* node, const bool& shuffled);
+
+	// Lazy shuffle. The shuffled order holds the songs drawn so far, the rest are drawn on demand:
+	// songs played before the shuffle at its front, every other song at its end.
+	bool isPlaced(const Node* node) const;
+	int pendingOf(const Node* node) const;
+	int undrawnBefore() const;
+	Node* undrawnAt(int rank) const;
+	void setPlaced(Node* node) const;
+	void place(Node* node, const bool& front) const;
+	bool placeNext() const;
+	bool placePrev() const;
+	void placeAll() const;
+	Node* nextOf(const Node* node, const bool& shuffled) const;
+	Node* prevOf(const Node* node, const bool& shuffled) const;
+	Node* buildChain(const std::vector<Node*>& nodes, const bool& shuffled, Node* prev, Node* next);
+	void spliceAfter(Node* pos, const std::vector<Node*>& nodes, const bool& shuffled);
+
+	template <class... Args>
+	Node* createNode(Args&&... args);
+	void destroyNode(Node* node);
+	void addNodeToQueue(Node* node);
+	void addNodeToSubQueue(Node* node);
+	void removeNode(Node* node, int songIndex);
+	void setCurrNode(Node* node, int songIndex);
+
+	// Bulk insertion
+	template <class InputIt>
+	std::vector<Node*> newNodes(InputIt first, InputIt last);
+	template <class InputIt>
+	void reserveFor(std::vector<Node*>& nodes, InputIt first, InputIt last, std::input_iterator_tag);
+	template <class ForwardIt>
+	void reserveFor(std::vector<Node*>& nodes, ForwardIt first, ForwardIt last, std::forward_iterator_tag);
+	void addNodesToQueue(const std::vector<Node*>& nodes);
+	void addNodesToSubQueue(const std::vector<Node*>& nodes);
+
+	static const T& valueOf(const T& song) { return song; }
+	static const T& valueOf(const std::unique_ptr<T>& song) { return *song; }
+	const T& resolve(const Node* node) const { return derived().songOf(node); }
+
+
+	using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+
+	/// Nodes are carved from per-queue slabs, releaseNodes() hands them all back at once
+	ObjectPool<Node, 256, NodeAllocator> m_nodePool;
+
+	Node m_headNode;
+	Node m_tailNode;
+
+	/// Sentinel before the first song of every order
+	Node* m_head;
+	/// Sentinel after the last song of every order
+	Node* m_tail;
+
+	Node* m_currSong;
+	typename SubQueuePolicy::template State<Node> m_subQueue;
+
+	/// Treap roots, indexed by the shuffled flag
+	mutable Node* m_root[Node::kOrders];
+	unsigned int m_priorityState;
+
+	typename ShufflePolicy::template State<Node> m_shuffle;
+
+	int m_size;
+
+
+private:
+
+	// No copying from TreapQueue
+	TreapQueue(const TreapQueue&) = delete;
+	void operator=(const TreapQueue&) = delete;
+};
+
+
+// TreapQueueNode Implementation
+template <class Node, class ShufflePolicy>
+TreapQueueNode<Node, ShufflePolicy>::TreapQueueNode() :
+	links{}, priority(0) { }
+
+
+template <class Node, class ShufflePolicy>
+void TreapQueueNode<Node, ShufflePolicy>::setNext(Node* node)
+{
+	for (OrderLinks& order : links) {
+		order.next = node;
+	}
+}
+
+
+template <class Node, class ShufflePolicy>
+void TreapQueueNode<Node, ShufflePolicy>::setPrev(Node* node)
+{
+	for (OrderLinks& order : links) {
+		order.prev = node;
+	}
+}
+
+
+template <class Node, class ShufflePolicy>
+void TreapQueueNode<Node, ShufflePolicy>::setNext(const bool& shuffled, Node* node)
+{
+	linksOf(shuffled).next = node;
+}
+
+
+template <class Node, class ShufflePolicy>
+void TreapQueueNode<Node, ShufflePolicy>::setPrev(const bool& shuffled, Node* node)
+{
+	linksOf(shuffled).prev = node;
+}
+
+
+template <class Node, class ShufflePolicy>
+Node* TreapQueueNode<Node, ShufflePolicy>::getNext(const bool& shuffled) const
+{
+	return linksOf(shuffled).next;
+}
+
+
+template <class Node, class ShufflePolicy>
+Node* TreapQueueNode<Node, ShufflePolicy>::getPrev(const bool& shuffled) const
+{
+	return linksOf(shuffled).prev;
+}
+
+
+/*!
+ *  @brief   Links of the given order. Without ShuffleOn there is only the unshuffled one.
+ */
+template <class Node, class ShufflePolicy>
+typename TreapQueueNode<Node, ShufflePolicy>::OrderLinks& TreapQueueNode<Node, ShufflePolicy>::linksOf(const bool& shuffled)
+{
+	return links[ShufflePolicy::enabled && shuffled];
+}
+
+
+template <class Node, class ShufflePolicy>
+const typename TreapQueueNode<Node, ShufflePolicy>::OrderLinks& TreapQueueNode<Node, ShufflePolicy>::linksOf(const bool& shuffled) const
+{
+	return links[ShufflePolicy::enabled && shuffled];
+}
+
+
+// TreapQueue Implementation
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::TreapQueue(const Allocator& allocator) :
+	m_nodePool(NodeAllocator(allocator)), m_head(&m_headNode), m_tail(&m_tailNode), m_currSong(nullptr),
+	m_root{}, m_priorityState(0x9E3779B9u), m_size(0)
+{
+	static_assert(std::is_base_of<TreapQueueNode<Node, ShufflePolicy>, Node>::value, "Node must derive from TreapQueueNode");
+
+	m_head->setNext(m_tail);
+	m_tail->setPrev(m_head);
+}
+
+
+/*!
+ *  @brief       Adds a song to the end of the Queue (same way Spotify handles it)
+ *  @param[in]   song   The song to be added to the queue
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addToQueue(const T& song)
+{
+	QUEUE_METRICS_SCOPE(addToQueue);
+
+	addNodeToQueue(derived().newNode(song));
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addToQueue(T&& song)
+{
+	QUEUE_METRICS_SCOPE(addToQueue);
+
+	addNodeToQueue(derived().newNode(std::move(song)));
+}
+
+
+/*!
+ *  @brief       Adds a song to the end of the sub queue, which plays in order after currSong
+ *  @param[in]   song   The song to be added to the sub queue
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addToSubQueue(const T& song)
+{
+	static_assert(SubQueuePolicy::enabled, "addToSubQueue() needs SubQueueOn");
+	QUEUE_METRICS_SCOPE(addToSubQueue);
+
+	addNodeToSubQueue(derived().newNode(song));
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addToSubQueue(T&& song)
+{
+	static_assert(SubQueuePolicy::enabled, "addToSubQueue() needs SubQueueOn");
+	QUEUE_METRICS_SCOPE(addToSubQueue);
+
+	addNodeToSubQueue(derived().newNode(std::move(song)));
+}
+
+
+/*!
+ *  @brief       Adds a song constructed from args to the end of the Queue
+ *  @param[in]   args   Forwarded to T's constructor
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class... Args>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::emplaceToQueue(Args&&... args)
+{
+	addToQueue(T(std::forward<Args>(args)...));
+}
+
+
+/*!
+ *  @brief       Adds a song constructed from args to the end of the sub queue
+ *  @param[in]   args   Forwarded to T's constructor
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class... Args>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::emplaceToSubQueue(Args&&... args)
+{
+	addToSubQueue(T(std::forward<Args>(args)...));
+}
+
+
+/*!
+ *  @brief       Adds a range of songs to the end of the Queue in one splice
+ *  @param[in]   first, last   Range of T or std::unique_ptr<T>, songs are copied into the queue
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class InputIt>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addRangeToQueue(InputIt first, InputIt last)
+{
+	QUEUE_METRICS_SCOPE(addRangeToQueue);
+
+	addNodesToQueue(newNodes(first, last));
+}
+
+
+/*!
+ *  @brief       Adds a range of songs to the end of the sub queue in one splice, keeping their order
+ *  @param[in]   first, last   Range of T or std::unique_ptr<T>, songs are copied into the queue
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class InputIt>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addRangeToSubQueue(InputIt first, InputIt last)
+{
+	static_assert(SubQueuePolicy::enabled, "addRangeToSubQueue() needs SubQueueOn");
+	QUEUE_METRICS_SCOPE(addRangeToSubQueue);
+
+	addNodesToSubQueue(newNodes(first, last));
+}
+
+
+/*!
+ *  @brief       Removes a song at an index
+ *  @param[in]   songIndex  Index of song to delete
+ *
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::removeFromQueue(const int& songIndex)
+{
+	QUEUE_METRICS_SCOPE(removeFromQueue);
+
+	if (songIndex < 0 || songIndex >= m_size) {
+		throw std::invalid_argument("songIndex out of bounds");
+	}
+
+	removeNode(nodeAt(songIndex, isShuffled()), songIndex);
+}
+
+
+/*!
+ *  @brief      Moves a song within the current order, the other order is left untouched
+ *
+ *  @param[in]  songIndex     The index of where the song currently is
+ *  @param[in]  newSongIndex  The index to move the song to
+ *
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::moveSong(const int& songIndex, const int& newSongIndex)
+{
+	QUEUE_METRICS_SCOPE(moveSong);
+
+	if (songIndex == newSongIndex) {
+		return;
+	}
+	if (songIndex < 0 || songIndex >= m_size) {
+		throw std::invalid_argument("oldSongIndex out of bounds");
+	}
+	if (newSongIndex < 0 || newSongIndex >= m_size) {
+		throw std::invalid_argument("newSongIndex out of bounds");
+	}
+
+	Node* songNode = nodeAt(songIndex, isShuffled());
+	if (songNode == m_currSong) {
+		throw std::invalid_argument("Cannot move the currently playing song.");
+	}
+
+	if (songNode == m_subQueue.getTail()) {
+		Node* prev = prevOf(songNode, isShuffled());
+		m_subQueue.setTail(prev == m_head ? nullptr : prev);
+	}
+
+	// With songNode taken out, the node before newSongIndex is its new predecessor.
+	// The front of the shuffled order is only known once every played song is drawn.
+	unlink(songNode, isShuffled());
+	Node* pos = m_head;
+	if (newSongIndex > 0) {
+		pos = nodeAt(newSongIndex - 1, isShuffled());
+	}
+	else if (isShuffled()) {
+		while (placePrev()) { }
+	}
+	insertAfter(pos, songNode, isShuffled());
+
+	derived().onMoved(songIndex, newSongIndex, songNode);
+}
+
+
+/*!
+ *  @brief   Moves currSong to next song if available
+ *
+ *  @param[in]   repeatMode  Enum for what RepeatMode is set to within the Player.
+ *                           once keeps playing currSong, on wraps around to the start of the queue.
+ *
+ *  @return  True if moved forward successfully. Only returns false when currSong is the last in queue and repeat is off
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::nextSong(const RepeatMode repeatMode)
+{
+	QUEUE_METRICS_SCOPE(nextSong);
+
+	if (m_currSong == nullptr) {
+		return false;
+	}
+	if (repeatMode == RepeatMode::once) {
+		return true;
+	}
+
+	Node* next = nextOf(m_currSong, isShuffled());
+	if (next == m_tail) {
+		if (repeatMode != RepeatMode::on) {
+			return false;
+		}
+		next = wrapAround();
+	}
+
+	// An empty sub queue stays anchored to currSong
+	if (m_subQueue.getTail() == m_currSong) {
+		m_subQueue.setTail(next);
+	}
+	derived().onCursorMove(next);
+	m_currSong = next;
+	return true;
+}
+
+
+/*!
+ *  @brief   Moves currSong to previous if available
+ *  @return  True if moved back successfully. Only returns false when currSong is the first in queue
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::prevSong()
+{
+	QUEUE_METRICS_SCOPE(prevSong);
+
+	if (m_currSong == nullptr) {
+		return false;
+	}
+
+	Node* prev = prevOf(m_currSong, isShuffled());
+	if (prev == m_head) {
+		return false;
+	}
+
+	if (m_subQueue.getTail() == m_currSong) {
+		m_subQueue.setTail(prev);
+	}
+	derived().onCursorMove(prev);
+	m_currSong = prev;
+	return true;
+}
+
+
+/*!
+ *  @brief   Removes all items from the queue
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::clear()
+{
+	derived().releaseNodes();
+
+	m_head->setNext(m_tail);
+	m_tail->setPrev(m_head);
+	for (Node*& root : m_root) {
+		root = nullptr;
+	}
+
+	m_currSong = nullptr;
+	m_subQueue.setTail(nullptr);
+	m_shuffle.setFrom(nullptr);
+	m_size = 0;
+	derived().onCleared();
+}
+
+
+/*!
+ *  @brief   Hands every node back to the pool at once, without walking the queue.
+ *           Derived hides it if its nodes need destroying one by one.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::releaseNodes()
+{
+	static_assert(std::is_trivially_destructible<Node>::value, "releaseNodes() skips Node destructors");
+
+	m_nodePool.releaseAll();
+}
+
+
+/*!
+ *  @brief       Grows the node pool so count songs fit without allocating
+ *  @param[in]   count   Total number of songs to make room for
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::reserve(int count)
+{
+	m_nodePool.reserve(count);
+}
+
+
+/*!
+ *  @brief   Should only be used when only one item needs to be accessed.
+ *  @return  Returns pointer to the song at songIndex, or nullptr if songIndex is out of range
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+const T* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::getSongAt(int songIndex) const
+{
+	QUEUE_METRICS_SCOPE(getSongAt);
+
+	if (songIndex < 0 || songIndex >= m_size) {
+		return nullptr;
+	}
+
+	return &resolve(nodeAt(songIndex, isShuffled()));
+}
+
+
+/*!
+ *  @return  Returns pointer to the playing song, or nullptr if nothing is playing
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+const T* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::getCurrSong() const
+{
+	return m_currSong != nullptr ? &resolve(m_currSong) : nullptr;
+}
+
+
+/*!
+ *  @brief   Checks if queue contains no songs
+ *  @return  True if queue contains no songs, false otherwise
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::isEmpty() const
+{
+	return m_size == 0;
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::isShuffled() const
+{
+	return m_shuffle.isShuffled();
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+int TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::size() const
+{
+	return m_size;
+}
+
+
+/*!
+ *  @brief   Seed the next shuffle will use. Queues with the same songs and seed shuffle alike.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+std::uint64_t TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::getShuffleSeed() const
+{
+	static_assert(ShufflePolicy::enabled, "getShuffleSeed() needs ShuffleOn");
+	return m_shuffle.seed;
+}
+
+
+/*!
+ *  @brief       Jumps to the song at songIndex in the current order
+ *  @param[in]   songIndex  Index of the song to play
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::setCurrSong(const int& songIndex)
+{
+	QUEUE_METRICS_SCOPE(setCurrSong);
+
+	if (songIndex < 0 || songIndex >= m_size) {
+		throw std::invalid_argument("songIndex is out of bounds");
+	}
+
+	setCurrNode(nodeAt(songIndex, isShuffled()), songIndex);
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::setShuffled(const bool& shuffled)
+{
+	static_assert(ShufflePolicy::enabled, "setShuffled() needs ShuffleOn");
+	QUEUE_METRICS_SCOPE(setShuffled);
+
+	// Either way the current order changes
+	derived().onReset();
+
+	m_shuffle.shuffled = shuffled;
+	if (shuffled) {
+		shuffle(ShuffleTag(), true);
+	}
+}
+
+
+/*!
+ *  @brief       Sets the seed of the next shuffle, the current shuffled order is kept
+ *  @param[in]   seed   Any value, each shuffle advances it so repeated shuffles differ
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::setShuffleSeed(std::uint64_t seed)
+{
+	static_assert(ShufflePolicy::enabled, "setShuffleSeed() needs ShuffleOn");
+	m_shuffle.seed = seed;
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::operator std::vector<T>() const
+{
+	std::vector<T> v;
+
+	for (auto song : *this) {
+		v.push_back(*song);
+	}
+
+	return v;
+}
+
+
+/*!
+ *  @brief       Starts a new shuffled order in O(1 + sub queue length).
+ *               The songs before currSong come first in random order, then currSong followed by the sub queue
+ *               in order, then every other song in random order. Both random parts are drawn lazily
+ *               (an incremental Fisher-Yates) as playback or readers reach them.
+ *  @param[in]   keepPlayed   Whether the songs before currSong stay before it, otherwise they are still to come
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::shuffle(std::true_type, const bool& keepPlayed)
+{
+	// Bumping the generation marks every song as not yet drawn without touching it
+	m_shuffle.gen += 1;
+	m_shuffle.rng.seed(m_shuffle.seed);
+	ShuffleRng::splitMix(m_shuffle.seed);
+	m_root[true] = nullptr;
+	m_head->setNext(true, m_tail);
+	m_tail->setPrev(true, m_head);
+
+	if (isEmpty()) {
+		return;
+	}
+
+	// The sub queue only counts if it actually follows currSong in the unshuffled order
+	Node* subQueueTail = m_subQueue.getTail();
+	bool hasSubQueue = subQueueTail != nullptr && subQueueTail != m_currSong;
+	if (hasSubQueue && m_currSong != nullptr) {
+		hasSubQueue = treeIndex(subQueueTail, false) > treeIndex(m_currSong, false);
+	}
+	if (!hasSubQueue) {
+		m_subQueue.setTail(m_currSong);
+	}
+
+	m_shuffle.from = keepPlayed ? m_currSong : nullptr;
+
+	Node* node = m_head;
+	if (m_currSong != nullptr) {
+		place(m_currSong, false);
+		node = m_currSong;
+	}
+	if (hasSubQueue) {
+		do {
+			node = node->getNext(false);
+			place(node, false);
+		} while (node != subQueueTail);
+	}
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::shuffle(std::false_type, const bool&)
+{
+	// Nothing to shuffle without ShuffleOn
+}
+
+
+/*!
+ *  @brief   First song of the next cycle when repeating the whole queue, O(1) unshuffled.
+ *           Shuffled, the next cycle is reshuffled lazily like setShuffled() does, except that every song is
+ *           still to come: the song that ended the cycle leads the new order, so it is not played twice
+ *           in a row, and the rest are drawn as playback reaches them.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::wrapAround()
+{
+	if (!isShuffled() || m_size == 1) {
+		return m_head->getNext(isShuffled());
+	}
+
+	derived().onReset();
+
+	// Every song has been drawn, so nothing can be left in the sub queue
+	m_subQueue.setTail(m_currSong);
+	shuffle(ShuffleTag(), false);
+	return nextOf(m_currSong, true);
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+int TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::treeSize(const Node* node, const bool& shuffled)
+{
+	return node != nullptr ? node->linksOf(shuffled).size : 0;
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node*& TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::rootOf(const bool& shuffled) const
+{
+	return m_root[ShufflePolicy::enabled && shuffled];
+}
+
+
+/*!
+ *  @brief   Recomputes a treap node's aggregates from its children.
+ *           The unshuffled treap also counts the songs not yet drawn into the shuffled order.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::update(Node* node, const bool& shuffled) const
+{
+	typename Node::OrderLinks& links = node->linksOf(shuffled);
+	links.size = 1 + treeSize(links.left, shuffled) + treeSize(links.right, shuffled);
+
+	if (!shuffled) {
+		bool placed = isPlaced(node);
+		node->setDraw(m_shuffle.generation(), placed, (placed ? 0 : 1) + pendingOf(links.left) + pendingOf(links.right));
+	}
+}
+
+
+/*!
+ *  @brief   Whether node has been drawn into the current shuffled order
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::isPlaced(const Node* node) const
+{
+	return node->isPlaced(m_shuffle.generation());
+}
+
+
+/*!
+ *  @brief   Number of songs not yet drawn in the unshuffled subtree rooted at node.
+ *           Nodes last updated for an older shuffle are entirely undrawn.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+int TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::pendingOf(const Node* node) const
+{
+	if (node == nullptr) {
+		return 0;
+	}
+	return node->pendingOf(m_shuffle.generation(), node->linksOf(false).size);
+}
+
+
+/*!
+ *  @brief   Marks a node that is not linked into the unshuffled treap yet as drawn
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::setPlaced(Node* node) const
+{
+	node->setDraw(m_shuffle.generation(), true, 0);
+}
+
+
+/*!
+ *  @brief   Number of played songs still to be drawn, in O(log n) until they all are.
+ *           They hold the first positions of the shuffled order, ahead of every drawn song.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+int TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::undrawnBefore() const
+{
+	const Node* from = m_shuffle.getFrom();
+	if (!isShuffled() || from == nullptr) {
+		return 0;
+	}
+
+	int pending = pendingOf(m_root[false]);
+	if (from != m_tail) {
+		const Node* node = from;
+		pending = pendingOf(node->linksOf(false).left);
+		for (const Node* parent = node->linksOf(false).parent; parent != nullptr; parent = parent->linksOf(false).parent) {
+			QUEUE_METRICS_TRAVERSED(1);
+			if (parent->linksOf(false).right == node) {
+				pending += pendingOf(parent->linksOf(false).left) + (isPlaced(parent) ? 0 : 1);
+			}
+			node = parent;
+		}
+	}
+
+	// Songs are only ever added after it, so once none are left there never will be again
+	if (pending == 0) {
+		m_shuffle.setFrom(nullptr);
+	}
+	return pending;
+}
+
+
+/*!
+ *  @brief   The song not drawn yet with rank songs not drawn yet before it in the unshuffled order
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::undrawnAt(int rank) const
+{
+	Node* node = m_root[false];
+	while (true) {
+		QUEUE_METRICS_TRAVERSED(1);
+		int leftPending = pendingOf(node->linksOf(false).left);
+		if (rank < leftPending) {
+			node = node->linksOf(false).left;
+			continue;
+		}
+		rank -= leftPending;
+
+		if (!isPlaced(node)) {
+			if (rank == 0) {
+				break;
+			}
+			rank -= 1;
+		}
+		node = node->linksOf(false).right;
+	}
+	return node;
+}
+
+
+/*!
+ *  @brief   Marks node as drawn and links it in at the front or the end of the shuffled order
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::place(Node* node, const bool& front) const
+{
+	setPlaced(node);
+	for (Node* parent = node; parent != nullptr; parent = parent->linksOf(false).parent) {
+		update(parent, false);
+	}
+
+	insertAfter(front ? m_head : m_tail->getPrev(true), node, true);
+	derived().onPlaced(node, front);
+}
+
+
+/*!
+ *  @brief   Draws one song uniformly from those still to come in the shuffled order and appends it
+ *  @return  False if every one of them has been drawn already
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::placeNext() const
+{
+	int before = undrawnBefore();
+	int pending = pendingOf(m_root[false]) - before;
+	if (pending == 0) {
+		return false;
+	}
+
+	place(undrawnAt(before + static_cast<int>(m_shuffle.below(static_cast<std::uint32_t>(pending)))), false);
+	return true;
+}
+
+
+/*!
+ *  @brief   Draws one song uniformly from those played before the shuffle and puts it at the front.
+ *           Drawn back to front, so the song just before the first drawn one is always known next.
+ *  @return  False if every one of them has been drawn already
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::placePrev() const
+{
+	int pending = undrawnBefore();
+	if (pending == 0) {
+		return false;
+	}
+
+	place(undrawnAt(static_cast<int>(m_shuffle.below(static_cast<std::uint32_t>(pending)))), true);
+	return true;
+}
+
+
+/*!
+ *  @brief   Draws every remaining song into the shuffled order
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::placeAll() const
+{
+	while (placeNext()) { }
+	while (placePrev()) { }
+}
+
+
+/*!
+ *  @brief   Next node in the given order, drawing another song if the shuffled order runs out.
+ *           The first song of the shuffled order is only known once every played song is drawn.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::nextOf(const Node* node, const bool& shuffled) const
+{
+	if (shuffled && node == m_head) {
+		while (placePrev()) { }
+	}
+
+	Node* next = node->getNext(shuffled);
+	if (shuffled && next == m_tail && placeNext()) {
+		next = node->getNext(shuffled);
+	}
+	return next;
+}
+
+
+/*!
+ *  @brief   Previous node in the given order, drawing another played song if the shuffled order runs out.
+ *           The last song of the shuffled order is only known once every unplayed song is drawn.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::prevOf(const Node* node, const bool& shuffled) const
+{
+	if (shuffled && node == m_tail) {
+		while (placeNext()) { }
+	}
+
+	Node* prev = node->getPrev(shuffled);
+	if (shuffled && prev == m_head && placePrev()) {
+		prev = node->getPrev(shuffled);
+	}
+	return prev;
+}
+
+
+/*!
+ *  @brief   Joins two treaps, every node of left ends up before every node of right
+ *  @return  Root of the joined treap, its parent is nullptr
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::merge(Node* left, Node* right, const bool& shuffled) const
+{
+	if (left == nullptr || right == nullptr) {
+		Node* root = left != nullptr ? left : right;
+		if (root != nullptr) {
+			root->linksOf(shuffled).parent = nullptr;
+		}
+		return root;
+	}
+
+	QUEUE_METRICS_TRAVERSED(1);
+	if (left->priority > right->priority) {
+		Node* child = merge(left->linksOf(shuffled).right, right, shuffled);
+		left->linksOf(shuffled).right = child;
+		child->linksOf(shuffled).parent = left;
+		update(left, shuffled);
+		left->linksOf(shuffled).parent = nullptr;
+		return left;
+	}
+
+	Node* child = merge(left, right->linksOf(shuffled).left, shuffled);
+	right->linksOf(shuffled).left = child;
+	child->linksOf(shuffled).parent = right;
+	update(right, shuffled);
+	right->linksOf(shuffled).parent = nullptr;
+	return right;
+}
+
+
+/*!
+ *  @brief   Splits a treap so the first count nodes end up in left and the rest in right
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::split(Node* root, int count, const bool& shuffled, Node*& left, Node*& right) const
+{
+	if (root == nullptr) {
+		left = nullptr;
+		right = nullptr;
+		return;
+	}
+
+	QUEUE_METRICS_TRAVERSED(1);
+	typename Node::OrderLinks& links = root->linksOf(shuffled);
+	int leftSize = treeSize(links.left, shuffled);
+
+	if (count <= leftSize) {
+		Node* rest;
+		split(links.left, count, shuffled, left, rest);
+		links.left = rest;
+		if (rest != nullptr) {
+			rest->linksOf(shuffled).parent = root;
+		}
+		right = root;
+	}
+	else {
+		Node* rest;
+		split(links.right, count - leftSize - 1, shuffled, rest, right);
+		links.right = rest;
+		if (rest != nullptr) {
+			rest->linksOf(shuffled).parent = root;
+		}
+		left = root;
+	}
+
+	update(root, shuffled);
+	if (left != nullptr) {
+		left->linksOf(shuffled).parent = nullptr;
+	}
+	if (right != nullptr) {
+		right->linksOf(shuffled).parent = nullptr;
+	}
+}
+
+
+/*!
+ *  @brief   O(log n) lookup of the node at songIndex, songIndex must be in range.
+ *           In the shuffled order songs are drawn until songIndex exists, at either end.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::nodeAt(int songIndex, const bool& shuffled) const
+{
+	if (shuffled) {
+		int before = undrawnBefore();
+		for (; before > songIndex; --before) {
+			placePrev();
+		}
+		for (int placed = before + treeSize(rootOf(true), true); placed <= songIndex && placeNext(); ++placed) { }
+		songIndex -= before;
+	}
+
+	Node* node = rootOf(shuffled);
+	while (node != nullptr) {
+		QUEUE_METRICS_TRAVERSED(1);
+		int leftSize = treeSize(node->linksOf(shuffled).left, shuffled);
+		if (songIndex < leftSize) {
+			node = node->linksOf(shuffled).left;
+		}
+		else if (songIndex == leftSize) {
+			return node;
+		}
+		else {
+			songIndex -= leftSize + 1;
+			node = node->linksOf(shuffled).right;
+		}
+	}
+
+	throw std::invalid_argument("Internal logic error, null node found before expected.");
+}
+
+
+/*!
+ *  @brief   O(log n) position of a node in the given order, node must be drawn if it is the shuffled one
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+int TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::indexOf(const Node* node, const bool& shuffled) const
+{
+	return treeIndex(node, shuffled) + (shuffled ? undrawnBefore() : 0);
+}
+
+
+/*!
+ *  @brief   O(log n) position of a node in the given order's treap, which leaves out the played songs not drawn yet
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+int TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::treeIndex(const Node* node, const bool& shuffled) const
+{
+	int songIndex = treeSize(node->linksOf(shuffled).left, shuffled);
+	for (const Node* parent = node->linksOf(shuffled).parent; parent != nullptr; parent = parent->linksOf(shuffled).parent) {
+		QUEUE_METRICS_TRAVERSED(1);
+		if (parent->linksOf(shuffled).right == node) {
+			songIndex += treeSize(parent->linksOf(shuffled).left, shuffled) + 1;
+		}
+		node = parent;
+	}
+	return songIndex;
+}
+
+
+/*!
+ *  @brief   Links node in directly after pos (which may be m_head) in the given order
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::insertAfter(Node* pos, Node* node, const bool& shuffled) const
+{
+	derived().onEdit(pos, shuffled, true);
+	Node* next = pos->getNext(shuffled);
+
+	node->setPrev(shuffled, pos);
+	node->setNext(shuffled, next);
+	pos->setNext(shuffled, node);
+	next->setPrev(shuffled, node);
+
+	typename Node::OrderLinks& links = node->linksOf(shuffled);
+	links.left = nullptr;
+	links.right = nullptr;
+	links.parent = nullptr;
+	update(node, shuffled);
+
+	Node*& root = rootOf(shuffled);
+	if (next == m_tail) {
+		root = merge(root, node, shuffled);
+	}
+	else if (pos == m_head) {
+		root = merge(node, root, shuffled);
+	}
+	else {
+		Node* left;
+		Node* right;
+		split(root, treeIndex(pos, shuffled) + 1, shuffled, left, right);
+		root = merge(merge(left, node, shuffled), right, shuffled);
+	}
+}
+
+
+/*!
+ *  @brief   Takes node out of the given order, without freeing it
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::unlink(Node* node, const bool& shuffled)
+{
+	derived().onEdit(node, shuffled, false);
+	typename Node::OrderLinks& links = node->linksOf(shuffled);
+
+	links.prev->setNext(shuffled, links.next);
+	links.next->setPrev(shuffled, links.prev);
+
+	Node* parent = links.parent;
+	Node* child = merge(links.left, links.right, shuffled);
+
+	if (parent == nullptr) {
+		rootOf(shuffled) = child;
+	}
+	else {
+		typename Node::OrderLinks& parentLinks = parent->linksOf(shuffled);
+		if (parentLinks.left == node) {
+			parentLinks.left = child;
+		}
+		else {
+			parentLinks.right = child;
+		}
+		if (child != nullptr) {
+			child->linksOf(shuffled).parent = parent;
+		}
+
+		for (; parent != nullptr; parent = parent->linksOf(shuffled).parent) {
+			QUEUE_METRICS_TRAVERSED(1);
+			update(parent, shuffled);
+		}
+	}
+
+	links = typename Node::OrderLinks{ nullptr, nullptr, nullptr, nullptr, nullptr, 0 };
+}
+
+
+/*!
+ *  @brief   Links nodes in between the list neighbours prev and next, building their treap in O(n)
+ *  @return  Root of a treap holding only nodes, the caller merges it into the order's treap
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::buildChain(const std::vector<Node*>& nodes, const bool& shuffled, Node* prev, Node* next)
+{
+	// Treap nodes on the right spine, popped once their subtree is complete
+	std::vector<Node*> spine;
+
+	for (Node* node : nodes) {
+		typename Node::OrderLinks& links = node->linksOf(shuffled);
+		links.prev = prev;
+		prev->setNext(shuffled, node);
+		prev = node;
+
+		links.left = nullptr;
+		links.right = nullptr;
+		links.parent = nullptr;
+
+		Node* last = nullptr;
+		while (!spine.empty() && spine.back()->priority < node->priority) {
+			last = spine.back();
+			spine.pop_back();
+			update(last, shuffled);
+		}
+
+		links.left = last;
+		if (last != nullptr) {
+			last->linksOf(shuffled).parent = node;
+		}
+		if (!spine.empty()) {
+			spine.back()->linksOf(shuffled).right = node;
+			links.parent = spine.back();
+		}
+		spine.push_back(node);
+	}
+
+	prev->setNext(shuffled, next);
+	next->setPrev(shuffled, prev);
+
+	Node* root = spine.empty() ? nullptr : spine.front();
+	while (!spine.empty()) {
+		update(spine.back(), shuffled);
+		spine.pop_back();
+	}
+	return root;
+}
+
+
+/*!
+ *  @brief   Links a whole run of new nodes in directly after pos in one step
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::spliceAfter(Node* pos, const std::vector<Node*>& nodes, const bool& shuffled)
+{
+	derived().onEdit(pos, shuffled, true);
+	Node* next = pos->getNext(shuffled);
+	Node*& root = rootOf(shuffled);
+
+	if (next == m_tail) {
+		root = merge(root, buildChain(nodes, shuffled, pos, next), shuffled);
+	}
+	else if (pos == m_head) {
+		root = merge(buildChain(nodes, shuffled, pos, next), root, shuffled);
+	}
+	else {
+		Node* left;
+		Node* right;
+		split(root, treeIndex(pos, shuffled) + 1, shuffled, left, right);
+		root = merge(merge(left, buildChain(nodes, shuffled, pos, next), shuffled), right, shuffled);
+	}
+}
+
+
+/*!
+ *  @brief       Constructs a pooled node with a fresh treap priority, not drawn into any shuffle yet
+ *  @param[in]   args   Forwarded to Node's constructor
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class... Args>
+Node* TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::createNode(Args&&... args)
+{
+	Node* node = m_nodePool.create(std::forward<Args>(args)...);
+
+	// xorshift32, treap priorities only need to be well spread
+	m_priorityState ^= m_priorityState << 13;
+	m_priorityState ^= m_priorityState >> 17;
+	m_priorityState ^= m_priorityState << 5;
+	node->priority = m_priorityState;
+	node->setDraw(m_shuffle.generation(), false, 1);
+
+	return node;
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::destroyNode(Node* node)
+{
+	m_nodePool.destroy(node);
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addNodeToQueue(Node* node)
+{
+	bool allDrawn = isShuffled() && pendingOf(m_root[false]) == undrawnBefore();
+
+	// Only the unshuffled order takes the song directly,
+	// in the shuffled order it joins the songs that are still to be drawn.
+	insertAfter(m_tail->getPrev(false), node, false);
+	if (m_shuffle.getFrom() == m_tail) {
+		m_shuffle.setFrom(node);
+	}
+
+	m_size += 1;
+	derived().onAppended(node, 1, allDrawn);
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addNodeToSubQueue(Node* node)
+{
+	Node* pos = m_subQueue.getTail() != nullptr ? m_subQueue.getTail() : m_head;
+
+	// The sub queue is always part of the drawn shuffled order
+	if (isShuffled()) {
+		setPlaced(node);
+	}
+
+	insertAfter(pos, node, false);
+	if (isShuffled()) {
+		insertAfter(pos, node, true);
+	}
+	m_subQueue.setTail(node);
+
+	m_size += 1;
+	derived().onInserted(node, 1);
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addNodesToQueue(const std::vector<Node*>& nodes)
+{
+	if (nodes.empty()) {
+		return;
+	}
+
+	bool allDrawn = isShuffled() && pendingOf(m_root[false]) == undrawnBefore();
+
+	spliceAfter(m_tail->getPrev(false), nodes, false);
+	if (m_shuffle.getFrom() == m_tail) {
+		m_shuffle.setFrom(nodes.front());
+	}
+
+	m_size += static_cast<int>(nodes.size());
+	derived().onAppended(nodes.front(), static_cast<int>(nodes.size()), allDrawn);
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::addNodesToSubQueue(const std::vector<Node*>& nodes)
+{
+	if (nodes.empty()) {
+		return;
+	}
+
+	Node* pos = m_subQueue.getTail() != nullptr ? m_subQueue.getTail() : m_head;
+	if (isShuffled()) {
+		for (Node* node : nodes) {
+			setPlaced(node);
+		}
+	}
+
+	spliceAfter(pos, nodes, false);
+	if (isShuffled()) {
+		spliceAfter(pos, nodes, true);
+	}
+	m_subQueue.setTail(nodes.back());
+
+	m_size += static_cast<int>(nodes.size());
+	derived().onInserted(nodes.front(), static_cast<int>(nodes.size()));
+}
+
+
+/*!
+ *  @brief       Unlinks node from the queue and frees it
+ *  @param[in]   songIndex   Position of node in the current order, -1 for a song that has not been drawn yet.
+ *                           Songs played before the shuffle have a position, draw them before removing one.
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::removeNode(Node* node, int songIndex)
+{
+	if (node == m_shuffle.getFrom()) {
+		m_shuffle.setFrom(node->getNext(false));
+	}
+
+	// Clients have not seen a song still to be drawn, it only leaves the unshuffled order
+	if (songIndex < 0) {
+		unlink(node, false);
+		derived().deleteNode(node);
+		m_size -= 1;
+		return;
+	}
+
+	if (node == m_subQueue.getTail() || node == m_currSong) {
+		Node* prev = prevOf(node, isShuffled());
+		Node* replacement = prev == m_head ? nullptr : prev;
+
+		if (node == m_subQueue.getTail()) {
+			m_subQueue.setTail(replacement);
+		}
+		if (node == m_currSong) {
+			m_currSong = replacement;
+		}
+	}
+
+	unlink(node, false);
+	if (isShuffled()) {
+		unlink(node, true);
+	}
+	derived().deleteNode(node);
+
+	m_size -= 1;
+	derived().onRemoved(songIndex);
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::setCurrNode(Node* node, int songIndex)
+{
+	// Jumping onto or past the end of the sub queue consumes it
+	Node* subQueueTail = m_subQueue.getTail();
+	if (subQueueTail == nullptr || subQueueTail == m_currSong || songIndex >= indexOf(subQueueTail, isShuffled())) {
+		m_subQueue.setTail(node);
+	}
+	derived().onCursorMove(node);
+	m_currSong = node;
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class InputIt>
+std::vector<Node*> TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::newNodes(InputIt first, InputIt last)
+{
+	std::vector<Node*> nodes;
+	reserveFor(nodes, first, last, typename std::iterator_traits<InputIt>::iterator_category());
+
+	for (; first != last; ++first) {
+		nodes.push_back(derived().newNode(valueOf(*first)));
+	}
+	return nodes;
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class InputIt>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::reserveFor(std::vector<Node*>&, InputIt, InputIt, std::input_iterator_tag)
+{
+	// Length unknown up front, storage grows as songs are read
+}
+
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+template <class ForwardIt>
+void TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::reserveFor(std::vector<Node*>& nodes, ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+{
+	int count = static_cast<int>(std::distance(first, last));
+	nodes.reserve(count);
+	derived().reserve(m_size + count);
+}
+
+
+// Iterator Implementation
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::Iterator() noexcept :
+	m_queue(nullptr), m_currNode(nullptr) { }
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::Iterator(const TreapQueue& songQueue, const Node* node) noexcept :
+	m_queue(&songQueue), m_currNode(node) { }
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::begin() const
+{
+	return Iterator(*this, nextOf(m_head, isShuffled()));
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::end() const
+{
+	return Iterator(*this, m_tail);
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::rbegin() const
+{
+	// The last song of the shuffled order is only known once everything is drawn
+	if (isShuffled()) {
+		placeAll();
+	}
+	return Iterator(*this, m_tail->getPrev(isShuffled()));
+}
+
+/*!
+ *  @return  The head sentinel, the songs are walked back from rbegin() with --
+ */
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::rend() const
+{
+	return Iterator(*this, m_head);
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator& TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator++()
+{
+	if (m_currNode && m_currNode != m_queue->m_tail) {
+		m_currNode = m_queue->nextOf(m_currNode, m_queue->isShuffled());
+	}
+	return *this;
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator++(int)
+{
+	Iterator iter = *this;
+	++* this;
+	return iter;
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator& TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator--()
+{
+	if (m_currNode && m_currNode != m_queue->m_head) {
+		m_currNode = m_queue->prevOf(m_currNode, m_queue->isShuffled());
+	}
+	return *this;
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+typename TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator--(int)
+{
+	Iterator iter = *this;
+	--* this;
+	return iter;
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator==(const Iterator& iter) const
+{
+	return m_currNode == iter.m_currNode;
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+bool TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator!=(const Iterator& iter) const
+{
+	return m_currNode != iter.m_currNode;
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+T const * TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator*() const
+{
+	return &m_queue->resolve(m_currNode);
+}
+
+template <class Derived, class T, class Node, class Allocator, class ShufflePolicy, class SubQueuePolicy>
+T const * TreapQueue<Derived, T, Node, Allocator, ShufflePolicy, SubQueuePolicy>::Iterator::operator->() const
+{
+	return &m_queue->resolve(m_currNode);
+}
+
+
+#endif
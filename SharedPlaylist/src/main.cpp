@@ -4,7 +4,6 @@
 
 #include <string>
 #include <iostream>
-#include <ctime>
 
 #include "adt/player.h"
 #include "adt/song_queue.h"
@@ -19,7 +18,6 @@ int main(std::string* argv)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
 	// Nothing here, just running unit tests for now.
-	std::srand(std::time(0));
 	doStuff();
 
 	exit(0);
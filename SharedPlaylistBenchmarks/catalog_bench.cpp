@@ -0,0 +1,100 @@
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "song_catalog.h"
+#include "song_queue.h"
+
+
+// The same popular tracks queued in many sessions, songs are interned once in the catalog
+
+static void BM_SharedTracks(benchmark::State& state)
+{
+	const int sessions = static_cast<int>(state.range(0));
+	const int tracks = 1000;
+	std::vector<Song> songs;
+	for (int i = 0; i < tracks; ++i) {
+		songs.push_back(Song(i));
+	}
+
+	std::size_t bytes = 0;
+	for (auto _ : state) {
+		std::vector<std::unique_ptr<SongQueue>> queues;
+		for (int i = 0; i < sessions; ++i) {
+			queues.push_back(std::make_unique<SongQueue>());
+			queues.back()->reserve(tracks);
+			queues.back()->addRangeToQueue(songs.begin(), songs.end());
+		}
+
+		state.PauseTiming();
+		bytes = 0;
+		for (const std::unique_ptr<SongQueue>& queue : queues) {
+			bytes += queue->memoryUsage();
+		}
+		queues.clear();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * sessions * tracks);
+	state.counters["bytes_per_track"] = static_cast<double>(bytes) / (static_cast<double>(sessions) * tracks);
+	state.counters["catalog_KB"] = static_cast<double>(SongCatalog::instance().memoryUsage()) / 1024.0;
+}
+BENCHMARK(BM_SharedTracks)->Arg(10)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+
+static void BM_CatalogIntern(benchmark::State& state)
+{
+	SongCatalog& catalog = SongCatalog::instance();
+	int number = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(catalog.intern(Song(number)));
+		number = number + 1 < 100000 ? number + 1 : 0;
+	}
+}
+BENCHMARK(BM_CatalogIntern);
+
+
+static void BM_CatalogGet(benchmark::State& state)
+{
+	SongCatalog& catalog = SongCatalog::instance();
+	std::vector<SongCatalog::TrackId> ids;
+	for (int i = 0; i < 100000; ++i) {
+		ids.push_back(catalog.intern(Song(i)));
+	}
+
+	std::size_t i = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(catalog.get(ids[i]).number);
+		i = i + 1 < ids.size() ? i + 1 : 0;
+	}
+}
+BENCHMARK(BM_CatalogGet)->ThreadRange(1, 4);
+
+
+// Adding through the std::unique_ptr shim costs the caller a heap allocation per song
+static void BM_AddUniquePtr(benchmark::State& state)
+{
+	SongQueue queue;
+	for (auto _ : state) {
+		queue.clear();
+		for (int i = 0; i < state.range(0); ++i) {
+			queue.addToQueue(std::make_unique<Song>(i));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AddUniquePtr)->Arg(1 << 16);
+
+
+static void BM_AddEmplace(benchmark::State& state)
+{
+	SongQueue queue;
+	for (auto _ : state) {
+		queue.clear();
+		for (int i = 0; i < state.range(0); ++i) {
+			queue.emplaceToQueue(i);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AddEmplace)->Arg(1 << 16);
@@ -0,0 +1,205 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "song_queue.h"
+#include "shared_song_queue.h"
+
+
+// Readers iterate the whole queue while one writer keeps editing it in the background.
+// Each benchmark thread is a reader, items_per_second is songs read across all of them.
+
+static const int kQueueSize = 1000;
+
+static std::atomic<bool> g_writing(false);
+static std::thread g_writer;
+
+
+template <class Write>
+static void startWriter(Write write)
+{
+	g_writing.store(true);
+	g_writer = std::thread([write]() {
+		for (int i = 0; g_writing.load(); ++i) {
+			write(i);
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	});
+}
+
+static void stopWriter()
+{
+	g_writing.store(false);
+	g_writer.join();
+}
+
+
+// Baseline: the plain SongQueue behind one mutex, readers block each other and the writer
+static std::mutex g_lockedMutex;
+static std::unique_ptr<SongQueue> g_lockedQueue;
+
+static void BM_LockedQueueRead(benchmark::State& state)
+{
+	if (state.thread_index() == 0) {
+		g_lockedQueue.reset(new SongQueue());
+		for (int i = 0; i < kQueueSize; ++i) {
+			g_lockedQueue->addToQueue(std::make_unique<Song>(i));
+		}
+		g_lockedQueue->setCurrSong(0);
+		startWriter([](int i) {
+			std::lock_guard<std::mutex> lock(g_lockedMutex);
+			g_lockedQueue->addToQueue(std::make_unique<Song>(i));
+			g_lockedQueue->removeFromQueue(0);
+		});
+	}
+
+	for (auto _ : state) {
+		std::lock_guard<std::mutex> lock(g_lockedMutex);
+		int sum = 0;
+		for (auto song : *g_lockedQueue) {
+			sum += song->number;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * kQueueSize);
+
+	if (state.thread_index() == 0) {
+		stopWriter();
+		g_lockedQueue.reset();
+	}
+}
+BENCHMARK(BM_LockedQueueRead)->ThreadRange(1, 16)->UseRealTime();
+
+
+static std::unique_ptr<SharedSongQueue> g_sharedQueue;
+
+static void BM_SharedQueueRead(benchmark::State& state)
+{
+	if (state.thread_index() == 0) {
+		g_sharedQueue.reset(new SharedSongQueue());
+		g_sharedQueue->edit([](SongQueue& queue) {
+			for (int i = 0; i < kQueueSize; ++i) {
+				queue.addToQueue(std::make_unique<Song>(i));
+			}
+			queue.setCurrSong(0);
+		});
+		startWriter([](int i) {
+			g_sharedQueue->edit([i](SongQueue& queue) {
+				queue.addToQueue(std::make_unique<Song>(i));
+				queue.removeFromQueue(0);
+			});
+		});
+	}
+
+	for (auto _ : state) {
+		SharedSongQueue::Reader reader = g_sharedQueue->read();
+		int sum = 0;
+		for (auto song : *reader) {
+			sum += song->number;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * kQueueSize);
+
+	if (state.thread_index() == 0) {
+		stopWriter();
+		g_sharedQueue.reset();
+	}
+}
+BENCHMARK(BM_SharedQueueRead)->ThreadRange(1, 16)->UseRealTime();
+
+
+// Point lookups, the common case for listeners polling what is playing
+static void BM_SharedQueueCurrSong(benchmark::State& state)
+{
+	if (state.thread_index() == 0) {
+		g_sharedQueue.reset(new SharedSongQueue());
+		g_sharedQueue->edit([](SongQueue& queue) {
+			for (int i = 0; i < kQueueSize; ++i) {
+				queue.addToQueue(std::make_unique<Song>(i));
+			}
+			queue.setCurrSong(0);
+		});
+		startWriter([](int) {
+			g_sharedQueue->nextSong(RepeatMode::off);
+		});
+	}
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(g_sharedQueue->read()->getCurrSong());
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	if (state.thread_index() == 0) {
+		stopWriter();
+		g_sharedQueue.reset();
+	}
+}
+BENCHMARK(BM_SharedQueueCurrSong)->ThreadRange(1, 16)->UseRealTime();
+
+
+// Cost of one edit plus publishing its snapshot, which only copies the edited path
+static void BM_SharedQueueEdit(benchmark::State& state)
+{
+	SharedSongQueue queue;
+	queue.edit([&state](SongQueue& songs) {
+		for (int i = 0; i < state.range(0); ++i) {
+			songs.addToQueue(std::make_unique<Song>(i));
+		}
+		songs.setCurrSong(0);
+	});
+
+	int i = 0;
+	for (auto _ : state) {
+		queue.addToQueue(std::make_unique<Song>(i++));
+		queue.removeFromQueue(1);
+	}
+	state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_SharedQueueEdit)->Range(1 << 10, 1 << 20);
+
+
+// Edits to a shuffled queue. The first publish after the shuffle draws the whole order, the edits after it
+// only copy the edited path like unshuffled ones
+static void BM_SharedQueueShuffledEdit(benchmark::State& state)
+{
+	SharedSongQueue queue;
+	queue.edit([&state](SongQueue& songs) {
+		for (int i = 0; i < state.range(0); ++i) {
+			songs.addToQueue(std::make_unique<Song>(i));
+		}
+		songs.setCurrSong(0);
+	});
+	queue.setShuffleSeed(1);
+	queue.setShuffled(true);
+
+	int i = 0;
+	for (auto _ : state) {
+		queue.addToQueue(std::make_unique<Song>(i++));
+		queue.removeFromQueue(1);
+	}
+	state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_SharedQueueShuffledEdit)->Range(1 << 10, 1 << 20);
+
+
+// Shuffling a shared queue, the publish draws every song so readers get the whole order
+static void BM_SharedQueueShuffle(benchmark::State& state)
+{
+	SharedSongQueue queue;
+	queue.edit([&state](SongQueue& songs) {
+		for (int i = 0; i < state.range(0); ++i) {
+			songs.addToQueue(std::make_unique<Song>(i));
+		}
+		songs.setCurrSong(static_cast<int>(state.range(0) / 2));
+	});
+
+	for (auto _ : state) {
+		queue.setShuffled(true);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SharedQueueShuffle)->Range(1 << 10, 1 << 20);
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "player_engine.h"
+
+
+// Playback of many repeating sessions on one loop thread, against a simulated clock.
+// Songs last 3 to 4 minutes, so each simulated second ends roughly one in 200 tracks.
+
+static const int kSongsPerSession = 20;
+
+
+static PlayerEngine::Clock::duration lengthOf(const Song& song)
+{
+	return std::chrono::seconds(180 + (static_cast<std::uint32_t>(song.number) * 2654435761u) % 60);
+}
+
+
+static void populate(PlayerEngine& engine, int sessions)
+{
+	for (int id = 0; id < sessions; ++id) {
+		engine.create(id);
+		engine.use(id, [&](Player& player) {
+			for (int i = 0; i < kSongsPerSession; ++i) {
+				player.getQueue()->addToQueue(Song(id * kSongsPerSession + i));
+			}
+			player.setRepeatMode(RepeatMode::on);
+		});
+		engine.play(id);
+	}
+}
+
+
+// One poll per simulated second, every track that ended in it moves its session on
+static void BM_EngineSecond(benchmark::State& state)
+{
+	const PlayerEngine::Clock::time_point start;
+	std::int64_t events = 0;
+	PlayerEngine engine(lengthOf, [&](const PlayerEngine::Event&) { events += 1; }, start);
+	populate(engine, static_cast<int>(state.range(0)));
+
+	PlayerEngine::Clock::time_point now = start;
+	events = 0;
+	for (auto _ : state) {
+		now += std::chrono::seconds(1);
+		engine.poll(now);
+	}
+	state.SetItemsProcessed(events);
+	state.counters["sessions"] = static_cast<double>(engine.playingCount());
+}
+BENCHMARK(BM_EngineSecond)->Arg(1000)->Arg(10000)->Arg(100000);
+
+
+// A single tick, mostly empty slots, what run() pays each time it wakes up
+static void BM_EngineTick(benchmark::State& state)
+{
+	const PlayerEngine::Clock::time_point start;
+	PlayerEngine engine(lengthOf, PlayerEngine::Listener(), start);
+	populate(engine, static_cast<int>(state.range(0)));
+
+	PlayerEngine::Clock::time_point now = start;
+	for (auto _ : state) {
+		now += PlayerEngine::kTick;
+		engine.poll(now);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EngineTick)->Arg(1000)->Arg(100000);
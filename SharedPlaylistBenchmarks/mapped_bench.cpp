@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "song_queue.h"
+#include "mapped_song_queue.h"
+
+
+// Very large queues kept in a mapped file against the same queue on the heap.
+// The rss counters are the process' resident memory after the run (Linux only, 0 elsewhere).
+
+static const char* const kQueueFile = "mapped_bench.bin";
+
+
+static double residentMegabytes()
+{
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+	long pages = 0;
+	long resident = 0;
+	statm >> pages >> resident;
+	return static_cast<double>(resident) * MappedFile::pageSize() / (1024.0 * 1024.0);
+#else
+	return 0.0;
+#endif
+}
+
+
+static void createQueueFile(int count)
+{
+	std::remove(kQueueFile);
+	MappedSongQueue queue(kQueueFile);
+	queue.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(0);
+	queue.trim(0, 0);
+}
+
+
+static void BM_MappedReopen(benchmark::State& state)
+{
+	createQueueFile(static_cast<int>(state.range(0)));
+
+	for (auto _ : state) {
+		MappedSongQueue queue(kQueueFile);
+		benchmark::DoNotOptimize(queue.getSongAt(0));
+	}
+	std::remove(kQueueFile);
+}
+BENCHMARK(BM_MappedReopen)->Arg(1000)->Arg(1000000)->Arg(4000000)->Unit(benchmark::kMicrosecond);
+
+
+// Plays through the queue trimming every 256 songs, resident memory stays at the window
+static void BM_MappedPlayback(benchmark::State& state)
+{
+	createQueueFile(static_cast<int>(state.range(0)));
+	MappedSongQueue queue(kQueueFile);
+
+	int played = 0;
+	for (auto _ : state) {
+		if (!queue.nextSong(RepeatMode::off)) {
+			queue.setCurrSong(0);
+		}
+		if (++played % 256 == 0) {
+			queue.trim(25, 24);
+		}
+	}
+	queue.trim(25, 24);
+	state.counters["rss_MB"] = residentMegabytes();
+	state.counters["file_MB"] = static_cast<double>(queue.fileSize()) / (1024.0 * 1024.0);
+	std::remove(kQueueFile);
+}
+BENCHMARK(BM_MappedPlayback)->Arg(1000)->Arg(1000000)->Arg(4000000);
+
+
+static void BM_HeapPlayback(benchmark::State& state)
+{
+	SongQueue queue;
+	std::vector<Song> songs;
+	for (int i = 0; i < state.range(0); ++i) {
+		songs.push_back(Song(i));
+	}
+	queue.addRangeToQueue(songs.begin(), songs.end());
+	queue.setCurrSong(0);
+
+	for (auto _ : state) {
+		if (!queue.nextSong(RepeatMode::off)) {
+			queue.setCurrSong(0);
+		}
+	}
+	state.counters["rss_MB"] = residentMegabytes();
+	state.counters["heap_MB"] = static_cast<double>(queue.memoryUsage()) / (1024.0 * 1024.0);
+}
+BENCHMARK(BM_HeapPlayback)->Arg(1000)->Arg(1000000)->Arg(4000000);
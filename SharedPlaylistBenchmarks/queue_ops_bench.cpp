@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "song_queue.h"
+#include "shuffle_rng.h"
+
+
+// Every SongQueue operation at sizes from 10 to 1M songs, arg 1 runs it on a shuffled queue.
+// Operations that change the size are timed in batches, the queue is put back to its size untimed.
+
+static const int kBatch = 64;
+
+
+static void sizesAndModes(benchmark::internal::Benchmark* benchmark)
+{
+	benchmark->ArgNames({ "size", "shuffled" });
+	for (int size : { 10, 100, 1000, 10000, 100000, 1000000 }) {
+		for (int shuffled = 0; shuffled < 2; ++shuffled) {
+			benchmark->Args({ size, shuffled });
+		}
+	}
+}
+
+
+static void populate(SongQueue& queue, const benchmark::State& state, bool withCurrSong = true)
+{
+	const int count = static_cast<int>(state.range(0));
+	std::vector<Song> songs;
+	songs.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		songs.push_back(Song(i));
+	}
+	queue.addRangeToQueue(songs.begin(), songs.end());
+
+	if (withCurrSong) {
+		queue.setCurrSong(count / 2);
+	}
+	queue.setShuffleSeed(1);
+	queue.setShuffled(state.range(1) != 0);
+
+	// Draw the whole shuffled order up front, otherwise the first random access pays for it
+	benchmark::DoNotOptimize(queue.getSongAt(count - 1));
+}
+
+
+static int batchSize(const SongQueue& queue)
+{
+	return std::max(1, std::min(kBatch, queue.size() / 2));
+}
+
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static void BM_AddToQueue(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+	const int batch = batchSize(queue);
+
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < batch; ++i) {
+			queue.emplaceToQueue(i);
+		}
+		state.SetIterationTime(secondsSince(start));
+
+		for (int i = 0; i < batch; ++i) {
+			queue.removeFromQueue(rng.below(queue.size()));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_AddToQueue)->Apply(sizesAndModes)->UseManualTime();
+
+
+static void BM_AddToSubQueue(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+	const int batch = batchSize(queue);
+
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < batch; ++i) {
+			queue.emplaceToSubQueue(i);
+		}
+		state.SetIterationTime(secondsSince(start));
+
+		for (int i = 0; i < batch; ++i) {
+			queue.removeFromQueue(rng.below(queue.size()));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_AddToSubQueue)->Apply(sizesAndModes)->UseManualTime();
+
+
+static void BM_RemoveFromQueue(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+	const int batch = batchSize(queue);
+
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < batch; ++i) {
+			queue.removeFromQueue(rng.below(queue.size()));
+		}
+		state.SetIterationTime(secondsSince(start));
+
+		for (int i = 0; i < batch; ++i) {
+			queue.emplaceToQueue(i);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_RemoveFromQueue)->Apply(sizesAndModes)->UseManualTime();
+
+
+// No currSong, it is the one song moveSong refuses to move
+static void BM_MoveSong(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state, false);
+	ShuffleRng rng(2);
+
+	for (auto _ : state) {
+		queue.moveSong(rng.below(queue.size()), rng.below(queue.size()));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MoveSong)->Apply(sizesAndModes);
+
+
+static void BM_GetSongAt(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(queue.getSongAt(rng.below(queue.size())));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetSongAt)->Apply(sizesAndModes);
+
+
+static void BM_SetCurrSong(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+
+	for (auto _ : state) {
+		queue.setCurrSong(rng.below(queue.size()));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SetCurrSong)->Apply(sizesAndModes);
+
+
+static void BM_FindSong(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(queue.findSong(rng.below(queue.size())));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindSong)->Apply(sizesAndModes);
+
+
+static void BM_JumpTo(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+
+	for (auto _ : state) {
+		queue.jumpTo(rng.below(queue.size()));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_JumpTo)->Apply(sizesAndModes);
+
+
+static void BM_RemoveSong(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+	ShuffleRng rng(2);
+	const int count = queue.size();
+	const int batch = batchSize(queue);
+	std::vector<int> removed;
+	removed.reserve(batch);
+
+	for (auto _ : state) {
+		removed.clear();
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < batch; ++i) {
+			const int number = rng.below(count);
+			if (queue.removeSong(number)) {
+				removed.push_back(number);
+			}
+		}
+		state.SetIterationTime(secondsSince(start));
+
+		for (int number : removed) {
+			queue.emplaceToQueue(number);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_RemoveSong)->Apply(sizesAndModes)->UseManualTime();
+
+
+// Reshuffles a shuffled queue, or unshuffles an unshuffled one
+static void BM_SetShuffled(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		queue.setShuffled(state.range(1) != 0);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SetShuffled)->Apply(sizesAndModes);
+
+
+static void BM_NextSong(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		if (!queue.nextSong(RepeatMode::off)) {
+			queue.setCurrSong(0);
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NextSong)->Apply(sizesAndModes);
+
+
+// Playing on with RepeatMode::on, every pass over the queue ends in a wrap (and a reshuffle when shuffled)
+static void BM_NextSongRepeat(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		queue.nextSong(RepeatMode::on);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NextSongRepeat)->Apply(sizesAndModes);
+
+
+/// Playback with the next eight songs looked up after every step, as a player pre-buffering audio would
+static void BM_PeekNext(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		queue.nextSong(RepeatMode::on);
+		benchmark::DoNotOptimize(queue.peekNext(8, RepeatMode::on));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PeekNext)->Apply(sizesAndModes);
+
+
+static void BM_PrevSong(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		if (!queue.prevSong()) {
+			queue.setCurrSong(queue.size() - 1);
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PrevSong)->Apply(sizesAndModes);
+
+
+static void BM_Iterate(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto song : queue) {
+			sum += song->number;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * queue.size());
+}
+BENCHMARK(BM_Iterate)->Apply(sizesAndModes);
+
+
+template <class Range>
+static int sumOf(const Range& range)
+{
+	int sum = 0;
+	for (const Song* song : range) {
+		sum += song->number;
+	}
+	return sum;
+}
+
+
+/// Same walk as BM_Iterate with the iterator fixed to the queue's order at compile time
+static void BM_IterateOrder(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		int sum = queue.isShuffled() ? sumOf(queue.shuffledOrder()) : sumOf(queue.unshuffledOrder());
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * queue.size());
+}
+BENCHMARK(BM_IterateOrder)->Apply(sizesAndModes);
+
+
+static void BM_IterateReverse(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto song = queue.rbegin(); song != queue.rend(); --song) {
+			sum += song->number;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * queue.size());
+}
+BENCHMARK(BM_IterateReverse)->Apply(sizesAndModes);
+
+
+static void BM_IterateOrderReverse(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, state);
+
+	for (auto _ : state) {
+		int sum = 0;
+		if (queue.isShuffled()) {
+			SongQueue::Order<true> order = queue.shuffledOrder();
+			std::for_each(std::make_reverse_iterator(order.end()), std::make_reverse_iterator(order.begin()),
+				[&sum](const Song* song) { sum += song->number; });
+		}
+		else {
+			SongQueue::Order<false> order = queue.unshuffledOrder();
+			std::for_each(std::make_reverse_iterator(order.end()), std::make_reverse_iterator(order.begin()),
+				[&sum](const Song* song) { sum += song->number; });
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * queue.size());
+}
+BENCHMARK(BM_IterateOrderReverse)->Apply(sizesAndModes);
@@ -0,0 +1,88 @@
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "player_registry.h"
+
+
+// Lookup and mutation throughput with 100k live sessions of 20 songs each, shared by every benchmark
+
+static const int kSessions = 100000;
+static const int kSongsPerSession = 20;
+
+
+static PlayerRegistry& populatedRegistry()
+{
+	static PlayerRegistry* registry = []() {
+		PlayerRegistry* registry = new PlayerRegistry();
+		std::vector<Song> songs;
+		for (int i = 0; i < kSongsPerSession; ++i) {
+			songs.push_back(Song(i));
+		}
+
+		for (PlayerRegistry::SessionId id = 0; id < kSessions; ++id) {
+			registry->create(id);
+			registry->use(id, [&](Player& player) {
+				player.getQueue()->addRangeToQueue(songs.begin(), songs.end());
+				player.getQueue()->setCurrSong(0);
+			});
+		}
+		return registry;
+	}();
+	return *registry;
+}
+
+
+static void BM_RegistryLookup(benchmark::State& state)
+{
+	PlayerRegistry& registry = populatedRegistry();
+	std::mt19937_64 rng(state.thread_index());
+
+	for (auto _ : state) {
+		int size = 0;
+		registry.use(rng() % kSessions, [&](Player& player) { size = player.getQueue()->size(); });
+		benchmark::DoNotOptimize(size);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["memory_MB"] = benchmark::Counter(static_cast<double>(registry.memoryUsage()) / (1024.0 * 1024.0), benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_RegistryLookup)->Threads(1)->Threads(4)->UseRealTime();
+
+
+static void BM_RegistryMutation(benchmark::State& state)
+{
+	PlayerRegistry& registry = populatedRegistry();
+	std::mt19937_64 rng(state.thread_index());
+
+	for (auto _ : state) {
+		registry.use(rng() % kSessions, [](Player& player) {
+			SongQueue* queue = player.getQueue();
+			queue->addToQueue(std::make_unique<Song>(0));
+			queue->removeFromQueue(queue->size() - 1);
+			queue->nextSong(player.getRepeatMode());
+		});
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RegistryMutation)->Threads(1)->Threads(4)->UseRealTime();
+
+
+// Every session is evicted and then restored by its next use
+static void BM_RegistryEvictAndRestore(benchmark::State& state)
+{
+	PlayerRegistry& registry = populatedRegistry();
+
+	for (auto _ : state) {
+		registry.evictIdle(PlayerRegistry::Clock::duration::zero());
+		state.counters["evicted_MB"] = static_cast<double>(registry.memoryUsage()) / (1024.0 * 1024.0);
+
+		for (PlayerRegistry::SessionId id = 0; id < kSessions; ++id) {
+			registry.use(id, [](Player&) { });
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * kSessions);
+	state.counters["resident_MB"] = static_cast<double>(registry.memoryUsage()) / (1024.0 * 1024.0);
+}
+BENCHMARK(BM_RegistryEvictAndRestore)->Unit(benchmark::kMillisecond)->Iterations(3);
@@ -0,0 +1,83 @@
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "song_queue.h"
+
+
+// Saving and restoring a session, arg 1 draws the whole shuffled order first so both permutations are written
+
+static void populate(SongQueue& queue, int count, bool shuffled)
+{
+	std::vector<Song> songs;
+	songs.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		songs.push_back(Song(i));
+	}
+	queue.addRangeToQueue(songs.begin(), songs.end());
+	queue.setCurrSong(count / 2);
+
+	if (shuffled) {
+		queue.setShuffleSeed(42);
+		queue.setShuffled(true);
+		benchmark::DoNotOptimize(queue.snapshot().size());
+	}
+}
+
+
+static void BM_SaveQueue(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, static_cast<int>(state.range(0)), state.range(1) != 0);
+
+	std::vector<unsigned char> data;
+	for (auto _ : state) {
+		data.clear();
+		queue.save(data);
+		benchmark::DoNotOptimize(data.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_SaveQueue)->ArgsProduct({ { 1000, 100000, 1000000 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
+
+
+static void BM_LoadQueue(benchmark::State& state)
+{
+	std::vector<unsigned char> data;
+	{
+		SongQueue queue;
+		populate(queue, static_cast<int>(state.range(0)), state.range(1) != 0);
+		queue.save(data);
+	}
+
+	SongQueue queue;
+	for (auto _ : state) {
+		queue.load(data.data(), data.size());
+		benchmark::DoNotOptimize(queue.size());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_LoadQueue)->ArgsProduct({ { 1000, 100000, 1000000 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
+
+
+// What restoring costs without the format, re-adding every song and replaying the position
+static void BM_RebuildQueue(benchmark::State& state)
+{
+	std::vector<Song> songs;
+	for (int i = 0; i < state.range(0); ++i) {
+		songs.push_back(Song(i));
+	}
+
+	SongQueue queue;
+	for (auto _ : state) {
+		queue.clear();
+		queue.addRangeToQueue(songs.begin(), songs.end());
+		queue.setCurrSong(static_cast<int>(songs.size() / 2));
+		benchmark::DoNotOptimize(queue.size());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RebuildQueue)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
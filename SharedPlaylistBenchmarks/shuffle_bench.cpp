@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "song_queue.h"
+#include "compact_song_queue.h"
+#include "parallel_shuffle.h"
+#include "shuffle_rng.h"
+
+
+// The old shuffle: std::random_shuffle over the global std::rand() state.
+// random_shuffle is gone in C++17, this is the same rand() % (i + 1) Fisher-Yates it ran.
+static void BM_LegacyRandomShuffle(benchmark::State& state)
+{
+	std::vector<int> order(state.range(0));
+	std::iota(order.begin(), order.end(), 0);
+	std::srand(1);
+
+	for (auto _ : state) {
+		for (int i = static_cast<int>(order.size()) - 1; i > 0; --i) {
+			std::swap(order[i], order[std::rand() % (i + 1)]);
+		}
+		benchmark::DoNotOptimize(order.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LegacyRandomShuffle)->Range(1 << 10, 1 << 20);
+
+
+static void BM_ShuffleRngShuffle(benchmark::State& state)
+{
+	std::vector<int> order(state.range(0));
+	std::iota(order.begin(), order.end(), 0);
+	ShuffleRng rng(1);
+
+	for (auto _ : state) {
+		for (std::uint32_t i = static_cast<std::uint32_t>(order.size()) - 1; i > 0; --i) {
+			std::swap(order[i], order[rng.below(i + 1)]);
+		}
+		benchmark::DoNotOptimize(order.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ShuffleRngShuffle)->Range(1 << 10, 1 << 20);
+
+
+// The bucketed shuffle large queues switch to, arg 1 is the thread count. One thread shows what the
+// cache friendlier access pattern alone is worth against the plain Fisher-Yates above.
+static void BM_ParallelShuffle(benchmark::State& state)
+{
+	std::vector<int> order(state.range(0));
+	std::iota(order.begin(), order.end(), 0);
+	const int threads = static_cast<int>(state.range(1));
+	std::uint64_t seed = 1;
+
+	for (auto _ : state) {
+		ParallelShuffle::shuffle(order.data(), order.data() + order.size(), seed++, threads);
+		benchmark::DoNotOptimize(order.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParallelShuffle)->ArgNames({ "size", "threads" })->Ranges({ { 1 << 10, 1 << 20 }, { 1, 8 } });
+
+
+// Turning shuffle on only, songs are drawn later as playback reaches them
+static void BM_SongQueueShuffleToggle(benchmark::State& state)
+{
+	SongQueue queue;
+	for (int i = 0; i < state.range(0); ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(0);
+	queue.setShuffleSeed(1);
+
+	for (auto _ : state) {
+		queue.setShuffled(true);
+		benchmark::DoNotOptimize(queue.getSongAt(0));
+	}
+}
+BENCHMARK(BM_SongQueueShuffleToggle)->Range(1 << 10, 1 << 20);
+
+
+// Shuffle on and draw the whole order, the cost a full eager shuffle used to pay up front
+static void BM_SongQueueShuffleFull(benchmark::State& state)
+{
+	SongQueue queue;
+	for (int i = 0; i < state.range(0); ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(0);
+	queue.setShuffleSeed(1);
+
+	for (auto _ : state) {
+		queue.setShuffled(true);
+		benchmark::DoNotOptimize(*queue.rbegin());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SongQueueShuffleFull)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
+
+static void BM_CompactSongQueueShuffle(benchmark::State& state)
+{
+	CompactSongQueue queue;
+	queue.reserve(static_cast<int>(state.range(0)));
+	for (int i = 0; i < state.range(0); ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(0);
+	queue.setShuffleSeed(1);
+
+	for (auto _ : state) {
+		queue.setShuffled(true);
+		benchmark::DoNotOptimize(*queue.begin());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CompactSongQueueShuffle)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
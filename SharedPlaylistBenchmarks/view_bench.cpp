@@ -0,0 +1,65 @@
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "song_queue.h"
+
+
+// Reading the 50 rows a client shows, the old way copies the whole queue to get them
+
+static void populate(SongQueue& queue, int count)
+{
+	for (int i = 0; i < count; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(count / 2);
+}
+
+
+static void BM_CopyQueue(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, static_cast<int>(state.range(0)));
+
+	for (auto _ : state) {
+		std::vector<Song> songs = queue;
+		benchmark::DoNotOptimize(songs.data());
+	}
+}
+BENCHMARK(BM_CopyQueue)->Range(1 << 10, 1 << 20);
+
+
+static void BM_ViewAroundCurrSong(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, static_cast<int>(state.range(0)));
+
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto song : queue.around(25, 24)) {
+			sum += song->number;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+}
+BENCHMARK(BM_ViewAroundCurrSong)->Range(1 << 10, 1 << 20);
+
+
+// Scrolling one page at a time, each page is found by walking from the previous one
+static void BM_ViewScroll(benchmark::State& state)
+{
+	SongQueue queue;
+	populate(queue, static_cast<int>(state.range(0)));
+
+	int offset = 0;
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto song : queue.view(offset, 50)) {
+			sum += song->number;
+		}
+		benchmark::DoNotOptimize(sum);
+		offset = offset + 50 < queue.size() ? offset + 50 : 0;
+	}
+}
+BENCHMARK(BM_ViewScroll)->Range(1 << 10, 1 << 20);
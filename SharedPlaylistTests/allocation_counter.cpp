@@ -0,0 +1,217 @@
+#include "pch.h"
+
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+
+namespace
+{
+	// Trivial thread locals, safe to touch from operator new before any constructor has run
+	thread_local std::size_t t_allocations = 0;
+	thread_local std::size_t t_bytes = 0;
+
+
+	void* allocate(std::size_t size)
+	{
+		t_allocations += 1;
+		t_bytes += size;
+		return std::malloc(size != 0 ? size : 1);
+	}
+}
+
+
+AllocationCounter::AllocationCounter()
+{
+	restart();
+}
+
+
+/*!
+ *  @brief   Counts from zero again
+ */
+void AllocationCounter::restart()
+{
+	m_countAtStart = t_allocations;
+	m_bytesAtStart = t_bytes;
+}
+
+
+/*!
+ *  @brief   Allocations made by this thread since the counter was created or restarted
+ */
+std::size_t AllocationCounter::count() const
+{
+	return t_allocations - m_countAtStart;
+}
+
+
+/*!
+ *  @brief   Bytes requested by those allocations
+ */
+std::size_t AllocationCounter::bytes() const
+{
+	return t_bytes - m_bytesAtStart;
+}
+
+
+void* operator new(std::size_t size)
+{
+	void* ptr = allocate(size);
+	if (ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	std::free(ptr);
+}
+
+
+#ifdef __cpp_aligned_new
+namespace
+{
+	void* allocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		t_allocations += 1;
+		t_bytes += size;
+		size = size != 0 ? size : 1;
+#ifdef _WIN32
+		return _aligned_malloc(size, static_cast<std::size_t>(alignment));
+#else
+		void* ptr = nullptr;
+		return posix_memalign(&ptr, static_cast<std::size_t>(alignment), size) == 0 ? ptr : nullptr;
+#endif
+	}
+
+
+	void freeAligned(void* ptr)
+	{
+#ifdef _WIN32
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	void* ptr = allocateAligned(size, alignment);
+	if (ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateAligned(size, alignment);
+}
+
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateAligned(size, alignment);
+}
+
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	freeAligned(ptr);
+}
+
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	freeAligned(ptr);
+}
+
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	freeAligned(ptr);
+}
+
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	freeAligned(ptr);
+}
+
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(ptr);
+}
+
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(ptr);
+}
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+
+/// Counts the heap allocations the calling thread makes while it is alive.
+/// allocation_counter.cpp replaces the global operator new and delete of the test executable,
+/// so every allocation is seen, whichever library makes it.
+class AllocationCounter
+{
+public:
+	AllocationCounter();
+
+	void restart();
+
+	// GETTERS
+	std::size_t count() const;
+	std::size_t bytes() const;
+
+private:
+	std::size_t m_countAtStart;
+	std::size_t m_bytesAtStart;
+};
+
+
+/// Fails the test if statement makes more than budget heap allocations on this thread
+#define EXPECT_ALLOCATIONS_AT_MOST(budget, statement) \
+	do { \
+		AllocationCounter allocationCounter; \
+		statement; \
+		const std::size_t allocations = allocationCounter.count(); \
+		EXPECT_LE(allocations, static_cast<std::size_t>(budget)) << "allocations made by: " #statement; \
+	} while (false)
+
+#define EXPECT_NO_ALLOCATIONS(statement) EXPECT_ALLOCATIONS_AT_MOST(0, statement)
@@ -0,0 +1,144 @@
+#include "pch.h"
+
+#include <memory>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "../SharedPlaylist/src/adt/compact_song_queue.h"
+#include "../SharedPlaylist/src/adt/song_queue.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+namespace
+{
+	const int kSongs = 1000;
+
+
+	template <class Queue>
+	void populate(Queue& queue, bool shuffled)
+	{
+		for (int i = 0; i < kSongs; ++i) {
+			queue.addToQueue(Song(i));
+		}
+		queue.setShuffled(shuffled);
+		queue.setCurrSong(0);
+	}
+
+
+	template <class Queue>
+	void stepThrough(Queue& queue)
+	{
+		while (queue.nextSong(RepeatMode::off)) { }
+		while (queue.prevSong()) { }
+	}
+
+
+	template <class Queue>
+	int readAll(const Queue& queue)
+	{
+		int total = 0;
+		for (int i = 0; i < queue.size(); ++i) {
+			total += queue.getSongAt(i)->number;
+		}
+		for (auto song = queue.begin(); song != queue.end(); ++song) {
+			total += (*song)->number;
+		}
+		return total;
+	}
+}
+
+
+TEST(AllocationTests, CounterSeesAllocations)
+{
+	AllocationCounter counter;
+	std::unique_ptr<int> value(new int(1));
+	std::vector<int> values(10);
+	EXPECT_EQ(2u, counter.count());
+	EXPECT_GE(counter.bytes(), sizeof(int) * 11);
+
+	counter.restart();
+	EXPECT_EQ(0u, counter.count());
+	EXPECT_NO_ALLOCATIONS(values[0] = *value);
+}
+
+
+TEST(AllocationTests, SongQueueStepsWithoutAllocating)
+{
+	for (bool shuffled : { false, true }) {
+		SongQueue queue;
+		populate(queue, shuffled);
+
+		EXPECT_NO_ALLOCATIONS(stepThrough(queue));
+	}
+
+	// Stepping records no change, so it doesn't allocate while the change log is still growing either
+	SongQueue queue;
+	for (int i = 0; i < 10; ++i) {
+		queue.addToQueue(Song(i));
+	}
+	queue.setCurrSong(0);
+	EXPECT_NO_ALLOCATIONS(stepThrough(queue));
+}
+
+
+TEST(AllocationTests, SongQueueReadsWithoutAllocating)
+{
+	for (bool shuffled : { false, true }) {
+		SongQueue queue;
+		populate(queue, shuffled);
+
+		int total = 0;
+		EXPECT_NO_ALLOCATIONS(total = readAll(queue));
+		EXPECT_EQ(kSongs * (kSongs - 1), total);
+
+		EXPECT_NO_ALLOCATIONS(
+			for (const Song* song : queue.view(kSongs / 2, 100)) {
+				total += song->number;
+			}
+		);
+	}
+}
+
+
+TEST(AllocationTests, SongQueueAddsAtMostOncePerSong)
+{
+	// A song already in the catalog costs only its node, which comes from the pool's slabs
+	SongQueue interned;
+	populate(interned, false);
+
+	for (bool shuffled : { false, true }) {
+		SongQueue queue;
+		queue.setShuffled(shuffled);
+		EXPECT_ALLOCATIONS_AT_MOST(kSongs,
+			for (int i = 0; i < kSongs; ++i) {
+				queue.addToQueue(Song(i));
+			}
+		);
+
+		AllocationCounter counter;
+		queue.addToSubQueue(Song(0));
+		EXPECT_LE(counter.count(), 1u);
+	}
+}
+
+
+TEST(AllocationTests, CompactSongQueueHotPathsDoNotAllocate)
+{
+	for (bool shuffled : { false, true }) {
+		CompactSongQueue queue;
+		populate(queue, shuffled);
+
+		EXPECT_NO_ALLOCATIONS(stepThrough(queue));
+
+		int total = 0;
+		EXPECT_NO_ALLOCATIONS(total = readAll(queue));
+		EXPECT_EQ(kSongs * (kSongs - 1), total);
+	}
+
+	CompactSongQueue queue;
+	EXPECT_ALLOCATIONS_AT_MOST(kSongs,
+		for (int i = 0; i < kSongs; ++i) {
+			queue.addToQueue(Song(i));
+		}
+	);
+}
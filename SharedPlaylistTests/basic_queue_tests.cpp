@@ -0,0 +1,191 @@
+#include "pch.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../SharedPlaylist/src/adt/basic_song_queue.h"
+#include "../SharedPlaylist/src/adt/song_queue.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+namespace
+{
+	using RadioQueue = BasicSongQueue<std::string, std::allocator<std::string>, ShuffleOff, SubQueueOff>;
+	using FullQueue = BasicSongQueue<Song, std::allocator<Song>, ShuffleOn, SubQueueOff>;
+
+
+	/// Allocator that counts the nodes it hands out, to check the queue allocates through it
+	template <class T>
+	class CountingAllocator
+	{
+	public:
+		using value_type = T;
+
+		explicit CountingAllocator(int* live) : m_live(live) { }
+		template <class U>
+		CountingAllocator(const CountingAllocator<U>& other) : m_live(other.m_live) { }
+
+		T* allocate(std::size_t count)
+		{
+			*m_live += static_cast<int>(count);
+			return std::allocator<T>().allocate(count);
+		}
+
+		void deallocate(T* ptr, std::size_t count)
+		{
+			*m_live -= static_cast<int>(count);
+			std::allocator<T>().deallocate(ptr, count);
+		}
+
+		template <class U>
+		bool operator==(const CountingAllocator<U>& other) const { return m_live == other.m_live; }
+		template <class U>
+		bool operator!=(const CountingAllocator<U>& other) const { return m_live != other.m_live; }
+
+	private:
+		template <class U>
+		friend class CountingAllocator;
+
+		int* m_live;
+	};
+
+
+	template <class Queue>
+	std::vector<int> numbersOf(const Queue& queue)
+	{
+		std::vector<int> numbers;
+		for (auto song : queue) {
+			numbers.push_back(song->number);
+		}
+		return numbers;
+	}
+}
+
+
+static_assert(std::is_same<SongQueue, BasicSongQueue<Song>>::value, "SongQueue is the default configuration");
+#ifdef __cpp_lib_concepts
+static_assert(std::bidirectional_iterator<RadioQueue::Iterator>);
+static_assert(std::bidirectional_iterator<FullQueue::Iterator>);
+#endif
+
+
+TEST(BasicQueueTests, PlainFifo)
+{
+	RadioQueue queue;
+	queue.addToQueue("a");
+	queue.emplaceToQueue(3, 'b');
+	std::string song = "c";
+	queue.addToQueue(song);
+	EXPECT_EQ(3, queue.size());
+	EXPECT_FALSE(queue.isShuffled());
+
+	queue.setCurrSong(0);
+	EXPECT_EQ("a", *queue.getSongAt(0));
+	EXPECT_TRUE(queue.nextSong(RepeatMode::off));
+	EXPECT_TRUE(queue.nextSong(RepeatMode::off));
+	EXPECT_FALSE(queue.nextSong(RepeatMode::off));
+	EXPECT_TRUE(queue.nextSong(RepeatMode::on));
+	EXPECT_TRUE(queue.prevSong() == false);
+
+	// Dropping played songs from the front keeps the rest in order
+	queue.removeFromQueue(0);
+	std::vector<std::string> songs = queue;
+	EXPECT_EQ(std::vector<std::string>({ "bbb", "c" }), songs);
+	EXPECT_EQ(nullptr, queue.getSongAt(2));
+	EXPECT_THROW(queue.removeFromQueue(2), std::invalid_argument);
+
+	queue.moveSong(1, 0);
+	EXPECT_EQ(1u, queue.begin()->size());
+	EXPECT_EQ("bbb", **queue.rbegin());
+
+	queue.clear();
+	EXPECT_TRUE(queue.isEmpty());
+	EXPECT_TRUE(queue.begin() == queue.end());
+}
+
+
+// Disabled policies leave their links out of every node
+TEST(BasicQueueTests, PoliciesShrinkNodes)
+{
+	const int songs = 1000;
+	BasicSongQueue<Song, std::allocator<Song>, ShuffleOff, SubQueueOff> lean;
+	FullQueue full;
+	for (int i = 0; i < songs; ++i) {
+		lean.addToQueue(Song(i));
+		full.addToQueue(Song(i));
+	}
+
+	// ShuffleOff drops five links, the treap size and the draw state per song
+	const std::size_t leanPerSong = (lean.memoryUsage() - sizeof(lean)) / songs;
+	const std::size_t fullPerSong = (full.memoryUsage() - sizeof(full)) / songs;
+	EXPECT_GE(fullPerSong - leanPerSong, 6 * sizeof(void*));
+	EXPECT_LT(sizeof(lean), sizeof(full));
+}
+
+
+TEST(BasicQueueTests, AllocatesThroughAllocator)
+{
+	int live = 0;
+	{
+		BasicSongQueue<Song, CountingAllocator<Song>> queue{ CountingAllocator<Song>(&live) };
+		for (int i = 0; i < 10; ++i) {
+			queue.addToQueue(Song(i));
+		}
+		EXPECT_LT(0, live);
+
+		// Freed nodes go back to the pool, not the allocator
+		const int pooled = live;
+		queue.removeFromQueue(3);
+		EXPECT_EQ(pooled, live);
+	}
+	EXPECT_EQ(0, live);
+}
+
+
+// The generic template runs on SongQueue's engine, so it plays and shuffles the same way
+TEST(BasicQueueTests, MatchesSongQueue)
+{
+	int live = 0;
+	BasicSongQueue<Song, CountingAllocator<Song>> queue{ CountingAllocator<Song>(&live) };
+	SongQueue songQueue;
+	for (int i = 0; i < 3; ++i) {
+		queue.addToSubQueue(Song(i));
+		songQueue.addToSubQueue(Song(i));
+	}
+	for (int i = 3; i < 60; ++i) {
+		queue.addToQueue(Song(i));
+		songQueue.addToQueue(Song(i));
+	}
+	queue.setCurrSong(0);
+	songQueue.setCurrSong(0);
+	queue.addToSubQueue(Song(100));
+	songQueue.addToSubQueue(Song(100));
+	EXPECT_EQ(numbersOf(songQueue), numbersOf(queue));
+
+	queue.setShuffleSeed(7);
+	songQueue.setShuffleSeed(7);
+	queue.setShuffled(true);
+	songQueue.setShuffled(true);
+	EXPECT_EQ(1, queue.getSongAt(1)->number);
+	EXPECT_EQ(songQueue.getSongAt(40)->number, queue.getSongAt(40)->number);
+	EXPECT_EQ(numbersOf(songQueue), numbersOf(queue));
+
+	queue.moveSong(10, 30);
+	songQueue.moveSong(10, 30);
+	queue.removeFromQueue(5);
+	songQueue.removeFromQueue(5);
+	queue.addToQueue(Song(200));
+	songQueue.addToQueue(Song(200));
+	for (int i = 0; i < 20; ++i) {
+		EXPECT_EQ(songQueue.nextSong(RepeatMode::off), queue.nextSong(RepeatMode::off));
+	}
+	EXPECT_EQ(numbersOf(songQueue), numbersOf(queue));
+
+	queue.setShuffled(false);
+	songQueue.setShuffled(false);
+	EXPECT_EQ(numbersOf(songQueue), numbersOf(queue));
+}
@@ -0,0 +1,87 @@
+#include "pch.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../SharedPlaylist/src/adt/song_catalog.h"
+#include "../SharedPlaylist/src/adt/song_queue.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+TEST(CatalogTests, InterningSharesSongs)
+{
+	SongCatalog catalog;
+	SongCatalog::TrackId first = catalog.intern(Song(10));
+	SongCatalog::TrackId second = catalog.intern(Song(20));
+
+	EXPECT_NE(first, second);
+	EXPECT_EQ(first, catalog.intern(Song(10)));
+	EXPECT_EQ(2, catalog.size());
+	EXPECT_EQ(10, catalog.get(first).number);
+	EXPECT_EQ(20, catalog.get(second).number);
+
+	// Songs never move, even as the catalog grows past a chunk
+	const Song* song = &catalog.get(first);
+	for (int i = 0; i < 3 * SongCatalog::kChunkSize; ++i) {
+		catalog.intern(Song(1000 + i));
+	}
+	EXPECT_EQ(song, &catalog.get(first));
+	EXPECT_EQ(1000 + SongCatalog::kChunkSize, catalog.get(catalog.intern(Song(1000 + SongCatalog::kChunkSize))).number);
+}
+
+
+TEST(CatalogTests, QueuesShareTracks)
+{
+	SongQueue queue1;
+	SongQueue queue2;
+	for (int i = 0; i < 100; ++i) {
+		queue1.addToQueue(std::make_unique<Song>(i));
+		queue2.addToQueue(std::make_unique<Song>(99 - i));
+	}
+
+	// The same track in two queues is one Song
+	EXPECT_EQ(queue1.getSongAt(0), queue2.getSongAt(99));
+	EXPECT_EQ(queue1.getSongAt(42), queue2.getSongAt(57));
+	EXPECT_EQ(42, queue1.getSongAt(42)->number);
+}
+
+
+TEST(CatalogTests, ReadersDuringInterning)
+{
+	SongCatalog catalog;
+	const int count = 20000;
+	std::vector<SongCatalog::TrackId> ids(count);
+	std::atomic<int> published(0);
+	std::atomic<bool> failed(false);
+
+	std::thread writer([&]() {
+		for (int i = 0; i < count; ++i) {
+			ids[i] = catalog.intern(Song(i));
+			published.store(i + 1, std::memory_order_release);
+		}
+	});
+
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 3; ++t) {
+		readers.emplace_back([&]() {
+			int seen = 0;
+			while (seen < count) {
+				seen = published.load(std::memory_order_acquire);
+				for (int i = seen > 64 ? seen - 64 : 0; i < seen; ++i) {
+					if (catalog.get(ids[i]).number != i) {
+						failed = true;
+					}
+				}
+			}
+		});
+	}
+
+	writer.join();
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+	EXPECT_EQ(false, failed.load());
+	EXPECT_EQ(count, catalog.size());
+}
@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include <memory>
+
+#include "queue_test_helpers.h"
+#include "../SharedPlaylist/src/adt/compact_song_queue.h"
+#include "../SharedPlaylist/src/adt/song_queue.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+TEST(CompactQueueTests, QueueRemoval)
+{
+	CompactSongQueue queue;
+	getPopulatedQueue(queue, 5);
+
+	queue.removeFromQueue(1);
+	queue.removeFromQueue(3);
+	EXPECT_EQ(true, queueEqualsVector(queue, { 0, 2, 3 }));
+
+	bool wasError = false;
+	try {
+		queue.removeFromQueue(30);
+	}
+	catch (const std::invalid_argument&) {
+		wasError = true;
+	}
+	EXPECT_EQ(true, wasError);
+
+	// Freed slots are reused
+	queue.addToQueue(std::make_unique<Song>(5));
+	queue.addToQueue(std::make_unique<Song>(6));
+	EXPECT_EQ(true, queueEqualsVector(queue, { 0, 2, 3, 5, 6 }));
+
+	queue.clear();
+	EXPECT_EQ(true, queue.isEmpty());
+}
+
+
+TEST(CompactQueueTests, QueueMoving)
+{
+	CompactSongQueue queue;
+	getPopulatedQueue(queue, 5);
+
+	queue.moveSong(1, 3);
+	EXPECT_EQ(true, queueEqualsVector(queue, { 0, 2, 3, 1, 4 }));
+
+	queue.moveSong(4, 0);
+	EXPECT_EQ(true, queueEqualsVector(queue, { 4, 0, 2, 3, 1 }));
+
+	EXPECT_EQ(3, queue.getSongAt(3)->number);
+	EXPECT_EQ(nullptr, queue.getSongAt(5));
+}
+
+
+TEST(CompactQueueTests, ShuffleKeepsSubQueue)
+{
+	CompactSongQueue queue;
+	for (int i = 0; i < 3; ++i) {
+		queue.addToSubQueue(std::make_unique<Song>(i));
+	}
+	for (int i = 3; i < 50; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(0);
+
+	queue.setShuffled(true);
+	std::vector<Song> songs = queue;
+
+	int currIndex = 0;
+	while (songs[currIndex].number != 0) {
+		++currIndex;
+	}
+	EXPECT_EQ(1, songs[currIndex + 1].number);
+	EXPECT_EQ(2, songs[currIndex + 2].number);
+
+	queue.setShuffled(false);
+	for (int i = 0; i < queue.size(); ++i) {
+		EXPECT_EQ(i, queue.getSongAt(i)->number);
+	}
+}
+
+
+// The songs played before a shuffle are shuffled ahead of currSong, as SongQueue does
+TEST(CompactQueueTests, ShuffleKeepsPlayedSongsFirst)
+{
+	CompactSongQueue queue;
+	getPopulatedQueue(queue, 50);
+	queue.setCurrSong(20);
+
+	queue.setShuffled(true);
+	EXPECT_EQ(20, queue.getSongAt(20)->number);
+	for (int i = 0; i < 20; ++i) {
+		EXPECT_LT(queue.getSongAt(i)->number, 20);
+	}
+	EXPECT_EQ(true, queue.prevSong());
+	EXPECT_EQ(true, queue.nextSong(RepeatMode::off));
+	EXPECT_EQ(true, queue.nextSong(RepeatMode::off));
+	EXPECT_GT(queue.getSongAt(21)->number, 20);
+}
+
+
+// Memory per track of the compact layout against the pointer based SongQueue
+TEST(CompactQueueTests, MemoryPerTrack)
+{
+	const int tracks = 100000;
+
+	SongQueue queue;
+	CompactSongQueue compactQueue;
+	compactQueue.reserve(tracks);
+	for (int i = 0; i < tracks; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+		compactQueue.addToQueue(std::make_unique<Song>(i));
+	}
+
+	double bytesPerTrack = static_cast<double>(queue.memoryUsage()) / tracks;
+	double compactBytesPerTrack = static_cast<double>(compactQueue.memoryUsage()) / tracks;
+
+	// 4 links and the song, 4 B each, see the figures on CompactSongQueue
+	EXPECT_NEAR(20.0, compactBytesPerTrack, 1.0);
+	EXPECT_LT(compactBytesPerTrack * 2, bytesPerTrack);
+}
+
+
+TEST(CompactQueueTests, RepeatModes)
+{
+	CompactSongQueue queue;
+	getPopulatedQueue(queue, 5);
+	queue.setCurrSong(4);
+	EXPECT_FALSE(queue.nextSong(RepeatMode::off));
+
+	// once loops the current song, on wraps around to the start
+	EXPECT_TRUE(queue.nextSong(RepeatMode::once));
+	EXPECT_EQ(true, queueEqualsVector(queue, { 0, 1, 2, 3, 4 }));
+	EXPECT_TRUE(queue.nextSong(RepeatMode::on));
+	EXPECT_TRUE(queue.prevSong() == false);
+
+	// Shuffled, every cycle is a new shuffle led by the song that ended the last one
+	queue.setShuffled(true);
+	while (queue.nextSong(RepeatMode::off)) { }
+	const int last = queue.getSongAt(4)->number;
+	EXPECT_TRUE(queue.nextSong(RepeatMode::on));
+	EXPECT_EQ(last, queue.getSongAt(0)->number);
+	EXPECT_EQ(queue.getSongAt(1)->number, (*++queue.begin())->number);
+	EXPECT_TRUE(queue.prevSong());
+	EXPECT_FALSE(queue.prevSong());
+}
+
+
+TEST(CompactQueueTests, SeededShuffle)
+{
+	CompactSongQueue queue1;
+	CompactSongQueue queue2;
+	getPopulatedQueue(queue1, 1000);
+	getPopulatedQueue(queue2, 1000);
+
+	queue1.setShuffleSeed(42);
+	queue2.setShuffleSeed(42);
+	queue1.setShuffled(true);
+	queue2.setShuffled(true);
+
+	std::vector<Song> songs1 = queue1;
+	std::vector<Song> songs2 = queue2;
+	for (int i = 0; i < 1000; ++i) {
+		EXPECT_EQ(songs1[i].number, songs2[i].number);
+	}
+}
+
+
+TEST(CompactQueueTests, AddByValueAndEmplace)
+{
+	CompactSongQueue queue;
+	queue.addToQueue(Song(1));
+	queue.emplaceToQueue(2);
+	queue.setCurrSong(0);
+	queue.emplaceToSubQueue(10);
+
+	EXPECT_EQ(true, queueEqualsVector(queue, { 1, 10, 2 }));
+}
@@ -0,0 +1,241 @@
+#include "pch.h"
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "../SharedPlaylist/src/adt/player_engine.h"
+#include "../SharedPlaylist/src/adt/song.h"
+#include "../SharedPlaylist/src/adt/timer_wheel.h"
+
+
+namespace
+{
+	using namespace std::chrono;
+	using Clock = PlayerEngine::Clock;
+
+
+	/// Song n plays for n seconds
+	Clock::duration secondsOf(const Song& song)
+	{
+		return seconds(song.number);
+	}
+
+
+	struct Recorder
+	{
+		std::vector<PlayerEngine::Event> events;
+		std::vector<int> started;
+
+		PlayerEngine::Listener listener()
+		{
+			return [this](const PlayerEngine::Event& event) {
+				events.push_back(event);
+				started.push_back(event.song != nullptr ? event.song->number : -1);
+			};
+		}
+	};
+
+
+	struct Timer : TimerWheel::Timer
+	{
+		int id;
+	};
+
+
+	void addSongs(PlayerEngine& engine, PlayerEngine::SessionId id, std::vector<int> songs)
+	{
+		engine.use(id, [&](Player& player) {
+			for (int song : songs) {
+				player.getQueue()->addToQueue(Song(song));
+			}
+		});
+	}
+}
+
+
+TEST(EngineTests, WheelFiresInOrderAcrossRevolutions)
+{
+	const Clock::time_point start;
+	TimerWheel wheel(milliseconds(10), start);
+	Timer timers[4];
+	const milliseconds when[4] = { milliseconds(95), milliseconds(10), milliseconds(41000), milliseconds(81960) };
+	for (int i = 0; i < 4; ++i) {
+		timers[i].id = i;
+		wheel.schedule(timers[i], start + when[i]);
+	}
+	wheel.cancel(timers[0]);
+	wheel.schedule(timers[0], start + milliseconds(95));
+	EXPECT_EQ(4, wheel.size());
+
+	std::vector<int> fired;
+	auto fire = [&](TimerWheel::Timer& timer) { fired.push_back(static_cast<Timer&>(timer).id); };
+	wheel.advance(start + milliseconds(90), fire);
+	EXPECT_EQ(std::vector<int>({ 1 }), fired);
+
+	// Rounded up to the next tick, never early
+	wheel.advance(start + milliseconds(99), fire);
+	EXPECT_EQ(std::vector<int>({ 1 }), fired);
+	wheel.advance(start + milliseconds(100), fire);
+	EXPECT_EQ(std::vector<int>({ 1, 0 }), fired);
+
+	// 41 s and 81.96 s share a slot, the later one waits for its revolution
+	wheel.advance(start + seconds(60), fire);
+	EXPECT_EQ(std::vector<int>({ 1, 0, 2 }), fired);
+	EXPECT_FALSE(timers[2].isScheduled());
+	EXPECT_TRUE(timers[3].isScheduled());
+
+	wheel.advance(start + seconds(100), fire);
+	EXPECT_EQ(std::vector<int>({ 1, 0, 2, 3 }), fired);
+	EXPECT_EQ(0, wheel.size());
+}
+
+
+TEST(EngineTests, PlaysThroughQueue)
+{
+	const Clock::time_point start;
+	Recorder recorder;
+	PlayerEngine engine(secondsOf, recorder.listener(), start);
+	EXPECT_EQ(true, engine.create(1));
+	EXPECT_EQ(false, engine.create(1));
+	EXPECT_EQ(false, engine.play(1));
+
+	addSongs(engine, 1, { 30, 20, 10 });
+	EXPECT_EQ(true, engine.play(1));
+	EXPECT_EQ(std::vector<int>({ 30 }), recorder.started);
+
+	engine.poll(start + seconds(29));
+	EXPECT_EQ(std::vector<int>({ 30 }), recorder.started);
+	engine.poll(start + seconds(30));
+	EXPECT_EQ(std::vector<int>({ 30, 20 }), recorder.started);
+
+	// A late poll ends every track that is over, each starting where the last one ended
+	engine.poll(start + seconds(100));
+	EXPECT_EQ(std::vector<int>({ 30, 20, 10, -1 }), recorder.started);
+	EXPECT_EQ(PlayerEngine::EventType::queueEnded, recorder.events.back().type);
+	EXPECT_EQ(1u, recorder.events.back().session);
+	EXPECT_FALSE(engine.isPlaying(1));
+	EXPECT_EQ(0, engine.playingCount());
+}
+
+
+TEST(EngineTests, PauseResumeAndSkip)
+{
+	const Clock::time_point start;
+	Recorder recorder;
+	PlayerEngine engine(secondsOf, recorder.listener(), start);
+	engine.create(1);
+	addSongs(engine, 1, { 60, 20, 40 });
+	engine.play(1);
+
+	engine.poll(start + seconds(45));
+	engine.pause(1);
+	EXPECT_FALSE(engine.isPlaying(1));
+	engine.poll(start + seconds(500));
+	EXPECT_EQ(std::vector<int>({ 60 }), recorder.started);
+
+	// 15 s were left of the track
+	engine.play(1);
+	engine.poll(start + seconds(514));
+	EXPECT_EQ(std::vector<int>({ 60 }), recorder.started);
+	engine.poll(start + seconds(515));
+	EXPECT_EQ(std::vector<int>({ 60, 20 }), recorder.started);
+
+	EXPECT_EQ(true, engine.skip(1));
+	EXPECT_EQ(std::vector<int>({ 60, 20, 40 }), recorder.started);
+	EXPECT_EQ(false, engine.skip(1));
+	EXPECT_EQ(-1, recorder.started.back());
+
+	// Repeating wraps around on its own
+	engine.use(1, [](Player& player) { player.setRepeatMode(RepeatMode::on); });
+	engine.play(1);
+	engine.poll(start + seconds(515 + 40));
+	EXPECT_EQ(60, recorder.started.back());
+}
+
+
+TEST(EngineTests, EditsFollowPlayback)
+{
+	const Clock::time_point start;
+	Recorder recorder;
+	PlayerEngine engine(secondsOf, recorder.listener(), start);
+	engine.create(1);
+	addSongs(engine, 1, { 60, 20, 40 });
+	engine.play(1);
+
+	// Edits that keep the current song don't restart it
+	addSongs(engine, 1, { 30 });
+	EXPECT_EQ(std::vector<int>({ 60 }), recorder.started);
+
+	engine.use(1, [](Player& player) { player.getQueue()->jumpTo(40); });
+	EXPECT_EQ(std::vector<int>({ 60, 40 }), recorder.started);
+	engine.poll(start + seconds(40));
+	EXPECT_EQ(std::vector<int>({ 60, 40, 30 }), recorder.started);
+
+	engine.use(1, [](Player& player) { player.getQueue()->clear(); });
+	EXPECT_EQ(-1, recorder.started.back());
+	EXPECT_FALSE(engine.isPlaying(1));
+
+	EXPECT_EQ(true, engine.destroy(1));
+	EXPECT_EQ(false, engine.contains(1));
+	EXPECT_EQ(false, engine.play(1));
+}
+
+
+// One thread keeps every session's playback going, however many there are
+TEST(EngineTests, ManySessionsOnOneLoop)
+{
+	const int sessions = 20000;
+	const Clock::time_point start;
+	int started = 0;
+	int ended = 0;
+	PlayerEngine engine(secondsOf, [&](const PlayerEngine::Event& event) {
+		if (event.type == PlayerEngine::EventType::trackStarted) {
+			started += 1;
+		}
+		else {
+			ended += 1;
+			// Listeners can act on the engine straight away
+			engine.destroy(event.session);
+		}
+	}, start);
+
+	for (int i = 0; i < sessions; ++i) {
+		engine.create(i);
+		addSongs(engine, i, { 100 + i % 97, 150 + i % 31, 200 + i % 13 });
+		engine.play(i);
+	}
+	EXPECT_EQ(sessions, engine.playingCount());
+
+	for (Clock::time_point now = start; now <= start + seconds(600); now += seconds(1)) {
+		engine.poll(now);
+	}
+	EXPECT_EQ(3 * sessions, started);
+	EXPECT_EQ(sessions, ended);
+	EXPECT_EQ(0, engine.size());
+}
+
+
+TEST(EngineTests, RunsOnItsOwnThread)
+{
+	std::promise<void> queueEnded;
+	PlayerEngine engine([](const Song&) { return milliseconds(20); }, [&](const PlayerEngine::Event& event) {
+		if (event.type == PlayerEngine::EventType::queueEnded) {
+			queueEnded.set_value();
+		}
+	});
+	std::thread loop([&]() { engine.run(); });
+
+	engine.post([](PlayerEngine& engine) {
+		engine.create(1);
+		addSongs(engine, 1, { 1, 2, 3 });
+		engine.play(1);
+	});
+	EXPECT_EQ(std::future_status::ready, queueEnded.get_future().wait_for(seconds(10)));
+
+	engine.stop();
+	loop.join();
+	EXPECT_EQ(true, engine.contains(1));
+	EXPECT_FALSE(engine.isPlaying(1));
+}
@@ -0,0 +1,176 @@
+#include "pch.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+#include "../SharedPlaylist/src/adt/mapped_song_queue.h"
+#include "../SharedPlaylist/src/adt/compact_song_queue.h"
+#include "../SharedPlaylist/src/adt/song.h"
+#include "queue_test_helpers.h"
+
+
+static const char* const kQueueFile = "mapped_queue_tests.bin";
+
+
+TEST(MappedQueueTests, QueueEditing)
+{
+	std::remove(kQueueFile);
+	{
+		MappedSongQueue queue(kQueueFile);
+		getPopulatedQueue(queue, 5);
+
+		queue.removeFromQueue(1);
+		queue.removeFromQueue(3);
+		EXPECT_EQ(true, queueEqualsVector(queue, { 0, 2, 3 }));
+		EXPECT_THROW(queue.removeFromQueue(30), std::invalid_argument);
+
+		// Freed records are reused
+		queue.addToQueue(std::make_unique<Song>(5));
+		queue.addToSubQueue(std::make_unique<Song>(6));
+		EXPECT_EQ(true, queueEqualsVector(queue, { 6, 0, 2, 3, 5 }));
+
+		queue.moveSong(4, 1);
+		EXPECT_EQ(true, queueEqualsVector(queue, { 6, 5, 0, 2, 3 }));
+		EXPECT_EQ(2, queue.getSongAt(3)->number);
+		EXPECT_EQ(nullptr, queue.getSongAt(5));
+	}
+	std::remove(kQueueFile);
+}
+
+
+TEST(MappedQueueTests, ReopenRestoresQueue)
+{
+	std::remove(kQueueFile);
+	std::vector<Song> songs;
+	{
+		MappedSongQueue queue(kQueueFile);
+		getPopulatedQueue(queue, 5000);
+		queue.setCurrSong(100);
+		queue.addToSubQueue(std::make_unique<Song>(-1));
+		queue.setShuffleSeed(7);
+		queue.setShuffled(true);
+		queue.nextSong(RepeatMode::off);
+		songs = queue;
+	}
+
+	MappedSongQueue queue(kQueueFile);
+	EXPECT_EQ(5001, queue.size());
+	EXPECT_EQ(true, queue.isShuffled());
+
+	std::vector<Song> reopened = queue;
+	ASSERT_EQ(songs.size(), reopened.size());
+	for (size_t i = 0; i < songs.size(); ++i) {
+		EXPECT_EQ(songs[i].number, reopened[i].number);
+	}
+
+	// Playback carries on from the song after the sub queue
+	EXPECT_EQ(true, queue.prevSong());
+	EXPECT_EQ(true, queue.nextSong(RepeatMode::off));
+	EXPECT_EQ(true, queue.nextSong(RepeatMode::off));
+	queue.setShuffled(false);
+	EXPECT_EQ(-1, queue.getSongAt(101)->number);
+
+	queue.clear();
+	EXPECT_EQ(true, queue.isEmpty());
+}
+
+
+TEST(MappedQueueTests, RepeatModes)
+{
+	std::remove(kQueueFile);
+	{
+		MappedSongQueue queue(kQueueFile);
+		getPopulatedQueue(queue, 3);
+		queue.setCurrSong(2);
+
+		EXPECT_EQ(false, queue.nextSong(RepeatMode::off));
+		EXPECT_EQ(true, queue.nextSong(RepeatMode::once));
+		EXPECT_EQ(2, queue.getSongAt(2)->number);
+		EXPECT_EQ(true, queue.nextSong(RepeatMode::on));
+		EXPECT_EQ(false, queue.prevSong());
+
+		// A shuffled queue reshuffles when it wraps, led by the song that ended the last cycle
+		queue.setShuffled(true);
+		queue.setCurrSong(2);
+		const int last = queue.getSongAt(2)->number;
+		EXPECT_EQ(true, queue.nextSong(RepeatMode::on));
+		EXPECT_EQ(last, queue.getSongAt(0)->number);
+		EXPECT_EQ(true, queue.prevSong());
+	}
+	std::remove(kQueueFile);
+}
+
+
+// Same layout and shuffle as CompactSongQueue, so both draw the same order from the same seed
+TEST(MappedQueueTests, ShuffleMatchesCompactQueue)
+{
+	std::remove(kQueueFile);
+	{
+		MappedSongQueue queue(kQueueFile);
+		CompactSongQueue compactQueue;
+		for (int i = 0; i < 3000; ++i) {
+			queue.addToQueue(std::make_unique<Song>(i));
+			compactQueue.addToQueue(std::make_unique<Song>(i));
+		}
+		queue.setCurrSong(10);
+		compactQueue.setCurrSong(10);
+
+		queue.setShuffleSeed(42);
+		compactQueue.setShuffleSeed(42);
+		queue.setShuffled(true);
+		compactQueue.setShuffled(true);
+
+		std::vector<Song> songs = queue;
+		std::vector<Song> compactSongs = compactQueue;
+		for (int i = 0; i < 3000; ++i) {
+			EXPECT_EQ(compactSongs[i].number, songs[i].number);
+		}
+
+		// Dropping pages from memory does not change what is read back
+		queue.trim(25, 24);
+		std::vector<Song> trimmed = queue;
+		for (int i = 0; i < 3000; ++i) {
+			EXPECT_EQ(songs[i].number, trimmed[i].number);
+		}
+	}
+	std::remove(kQueueFile);
+}
+
+
+TEST(MappedQueueTests, RejectsOtherFiles)
+{
+	std::remove(kQueueFile);
+	{
+		std::ofstream file(kQueueFile, std::ios::binary);
+		file << "not a queue, but long enough to hold a header if it was one....";
+	}
+	EXPECT_THROW(MappedSongQueue queue(kQueueFile), std::invalid_argument);
+	std::remove(kQueueFile);
+}
+
+
+TEST(MappedQueueTests, RejectsCorruptLinks)
+{
+	std::remove(kQueueFile);
+	{
+		MappedSongQueue queue(kQueueFile);
+		getPopulatedQueue(queue, 10);
+	}
+	{
+		// Records are 20 bytes from offset 64, the song then next[0]: point song 3's next past every record
+		std::fstream file(kQueueFile, std::ios::binary | std::ios::in | std::ios::out);
+		const std::uint32_t link = 5000;
+		file.seekp(64 + 20 * 4 + 4);
+		file.write(reinterpret_cast<const char*>(&link), sizeof(link));
+	}
+	{
+		// Opening only reads the header, the bad link is caught once it is followed
+		MappedSongQueue queue(kQueueFile);
+		EXPECT_EQ(3, queue.getSongAt(3)->number);
+		EXPECT_THROW(queue.getSongAt(4), std::invalid_argument);
+		EXPECT_THROW(std::vector<Song> songs = queue, std::invalid_argument);
+	}
+	std::remove(kQueueFile);
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../SharedPlaylist/src/adt/queue_metrics.h"
+#include "../SharedPlaylist/src/adt/player.h"
+#include "../SharedPlaylist/src/adt/song_queue.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+namespace
+{
+	std::uint64_t histogramTotal(const QueueMetrics::OpStats& stats)
+	{
+		std::uint64_t total = 0;
+		for (std::uint64_t count : stats.latency) {
+			total += count;
+		}
+		return total;
+	}
+}
+
+
+TEST(MetricsTests, CountsCallsAndNodes)
+{
+	SongQueue queue;
+	for (int i = 0; i < 1000; ++i) {
+		queue.addToQueue(Song(i));
+	}
+	queue.setCurrSong(0);
+
+	QueueMetrics::reset();
+	for (int i = 0; i < 10; ++i) {
+		queue.getSongAt(i * 97);
+	}
+	queue.nextSong(RepeatMode::off);
+	queue.nextSong(RepeatMode::off);
+	queue.prevSong();
+
+	QueueMetrics::Snapshot snapshot = QueueMetrics::snapshot();
+	const QueueMetrics::OpStats& lookups = snapshot[QueueMetrics::Op::getSongAt];
+
+	if (!QueueMetrics::enabled()) {
+		EXPECT_EQ(0u, lookups.calls);
+		EXPECT_EQ(0u, snapshot[QueueMetrics::Op::nextSong].calls);
+		return;
+	}
+
+	EXPECT_EQ(10u, lookups.calls);
+	EXPECT_EQ(2u, snapshot[QueueMetrics::Op::nextSong].calls);
+	EXPECT_EQ(1u, snapshot[QueueMetrics::Op::prevSong].calls);
+	EXPECT_EQ(0u, snapshot[QueueMetrics::Op::moveSong].calls);
+
+	// Every lookup walks down the treap, which stays shallow
+	EXPECT_GE(lookups.nodesTraversed, 10u);
+	EXPECT_LE(lookups.nodesTraversed, 10u * 64);
+	EXPECT_EQ(lookups.calls, histogramTotal(lookups));
+}
+
+
+TEST(MetricsTests, CountsPlayerAndNestedOperations)
+{
+	Player player;
+	player.getQueue()->addToQueue(Song(1));
+	player.getQueue()->addToQueue(Song(2));
+
+	QueueMetrics::reset();
+	player.setShuffle(true);
+
+	QueueMetrics::Snapshot snapshot = QueueMetrics::snapshot();
+	if (!QueueMetrics::enabled()) {
+		EXPECT_EQ(0u, snapshot[QueueMetrics::Op::playerSetShuffle].calls);
+		return;
+	}
+
+	EXPECT_EQ(1u, snapshot[QueueMetrics::Op::playerSetShuffle].calls);
+	EXPECT_EQ(1u, snapshot[QueueMetrics::Op::setShuffled].calls);
+	EXPECT_GE(snapshot[QueueMetrics::Op::playerSetShuffle].totalNanos, snapshot[QueueMetrics::Op::setShuffled].totalNanos);
+}
+
+
+TEST(MetricsTests, KeepsCountsOfExitedThreads)
+{
+	QueueMetrics::reset();
+
+	std::thread worker([]() {
+		SongQueue queue;
+		for (int i = 0; i < 5; ++i) {
+			queue.addToQueue(Song(i));
+		}
+	});
+	worker.join();
+
+	QueueMetrics::Snapshot snapshot = QueueMetrics::snapshot();
+	EXPECT_EQ(QueueMetrics::enabled() ? 5u : 0u, snapshot[QueueMetrics::Op::addToQueue].calls);
+
+	QueueMetrics::reset();
+	EXPECT_EQ(0u, QueueMetrics::snapshot()[QueueMetrics::Op::addToQueue].calls);
+}
+
+
+TEST(MetricsTests, ExportsPrometheusText)
+{
+	SongQueue queue;
+	queue.addToQueue(Song(1));
+	queue.addToQueue(Song(2));
+	queue.setCurrSong(0);
+
+	QueueMetrics::reset();
+	queue.nextSong(RepeatMode::off);
+
+	std::ostringstream out;
+	QueueMetrics::snapshot().exportText(out);
+	const std::string text = out.str();
+
+	EXPECT_NE(std::string::npos, text.find("# TYPE shared_playlist_op_latency_ns histogram\n"));
+	if (!QueueMetrics::enabled()) {
+		EXPECT_EQ(std::string::npos, text.find("op=\""));
+		return;
+	}
+
+	EXPECT_NE(std::string::npos, text.find("shared_playlist_op_calls_total{op=\"SongQueue::nextSong\"} 1\n"));
+	EXPECT_NE(std::string::npos, text.find("shared_playlist_op_latency_ns_bucket{op=\"SongQueue::nextSong\",le=\"+Inf\"} 1\n"));
+	EXPECT_NE(std::string::npos, text.find("shared_playlist_op_latency_ns_count{op=\"SongQueue::nextSong\"} 1\n"));
+	EXPECT_EQ(std::string::npos, text.find("SongQueue::moveSong"));
+}
@@ -0,0 +1,96 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "../SharedPlaylist/src/adt/parallel_shuffle.h"
+#include "../SharedPlaylist/src/adt/compact_song_queue.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+namespace
+{
+	std::vector<int> shuffled(int count, std::uint64_t seed, int threads)
+	{
+		std::vector<int> items(count);
+		std::iota(items.begin(), items.end(), 0);
+		ParallelShuffle::shuffle(items.data(), items.data() + items.size(), seed, threads);
+		return items;
+	}
+}
+
+
+TEST(ParallelShuffleTests, SameSeedSameOrderOnAnyThreadCount)
+{
+	const int count = 100000;
+	std::vector<int> serial = shuffled(count, 42, 1);
+	EXPECT_EQ(serial, shuffled(count, 42, 4));
+	EXPECT_EQ(serial, shuffled(count, 42, 64));
+	EXPECT_NE(serial, shuffled(count, 43, 4));
+
+	std::vector<int> sorted = serial;
+	std::sort(sorted.begin(), sorted.end());
+	for (int i = 0; i < count; ++i) {
+		ASSERT_EQ(i, sorted[i]);
+	}
+}
+
+
+// Every item should land in every position about equally often
+TEST(ParallelShuffleTests, Uniform)
+{
+	const int count = 8;
+	const int rounds = 16000;
+	std::vector<std::vector<int>> hits(count, std::vector<int>(count, 0));
+	for (int seed = 0; seed < rounds; ++seed) {
+		std::vector<int> items = shuffled(count, seed, 1);
+		for (int i = 0; i < count; ++i) {
+			hits[items[i]][i] += 1;
+		}
+	}
+
+	for (int item = 0; item < count; ++item) {
+		for (int position = 0; position < count; ++position) {
+			EXPECT_NEAR(rounds / count, hits[item][position], rounds / count / 8);
+		}
+	}
+}
+
+
+TEST(ParallelShuffleTests, LargeQueueKeepsSubQueue)
+{
+	const int count = static_cast<int>(ParallelShuffle::kThreshold) + 1000;
+	CompactSongQueue compact;
+	compact.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		compact.addToQueue(Song(i));
+	}
+	compact.setCurrSong(100);
+	for (int i = 0; i < 3; ++i) {
+		compact.addToSubQueue(Song(count + i));
+	}
+
+	compact.setShuffleSeed(5);
+	compact.setShuffled(true);
+
+	std::vector<Song> songs = compact;
+	ASSERT_EQ(static_cast<std::size_t>(count + 3), songs.size());
+	EXPECT_EQ(100, songs[100].number);
+	for (int i = 0; i < 3; ++i) {
+		EXPECT_EQ(count + i, songs[i + 101].number);
+	}
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_LT(songs[i].number, 100);
+	}
+
+	// Linked both ways and a permutation of the queue
+	std::vector<int> numbers;
+	for (auto song = compact.rbegin(); song != compact.rend(); --song) {
+		numbers.push_back((*song)->number);
+	}
+	ASSERT_EQ(songs.size(), numbers.size());
+	EXPECT_EQ(songs.back().number, numbers.front());
+	std::sort(numbers.begin(), numbers.end());
+	EXPECT_TRUE(std::adjacent_find(numbers.begin(), numbers.end()) == numbers.end());
+}
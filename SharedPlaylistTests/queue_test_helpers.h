@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+/// Empties queue and fills it with songs 0 to len - 1, for any of the queue types
+template <class Queue>
+void getPopulatedQueue(Queue& queue, int len)
+{
+	queue.clear();
+	for (int i = 0; i < len; i++) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+}
+
+
+/// Whether queue plays exactly the song numbers in vector, in that order
+template <class Queue>
+bool queueEqualsVector(const Queue& queue, const std::vector<int>& vector)
+{
+	if (static_cast<std::size_t>(queue.size()) != vector.size()) {
+		return false;
+	}
+
+	std::size_t i = 0;
+	for (auto song = queue.begin(); song != queue.end(); ++song, ++i) {
+		if ((*song)->number != vector[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -1,11 +1,15 @@
 #include "pch.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <iostream>
-#include <iostream>
 
+#include "queue_test_helpers.h"
 #include "../SharedPlaylist/src/adt/song_queue.h"
+#include "../SharedPlaylist/src/adt/queue_delta.h"
 #include "../SharedPlaylist/src/adt/song.h"
+#include "../SharedPlaylist/src/adt/player.h"
 
 
 // Checks whether or not iterating forward is the same as backwards.
@@ -21,32 +25,6 @@ void checkPointers(const SongQueue& queue)
 	EXPECT_EQ(i, -1);
 }
 
-void getPopulatedQueue(SongQueue& queue, int len)
-{
-	queue.clear();
-	std::unique_ptr<Song> song;
-	for (int i = 0; i < len; i++) {
-		song = std::make_unique<Song>(i);
-		queue.addToQueue(std::move(song));
-	}
-}
-
-bool queueEqualsVector(SongQueue& queue, std::vector<int> vector)
-{
-	if (queue.size() != vector.size()) {
-		return false;
-	}
-
-	auto song = queue.begin();
-	for (int i = 0; song != queue.end(); ++song, ++i) {
-		if ((*song)->number != vector[i]) {
-			return false;
-		}
-	}
-
-	return true;
-}
-
 
 // Simple test for queue.isEmpty()
 TEST(QueueTests, QueueIsEmpty) 
@@ -222,4 +200,809 @@ TEST(QueueTests, ShuffleTest)
 
 	queue.setShuffled(true);
 
-}
\ No newline at end of file
+}
+
+// Index based operations on a large queue, these used to walk the whole list
+TEST(QueueTests, QueueLargeIndexing)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 20000);
+
+	EXPECT_EQ(19999, queue.getSongAt(19999)->number);
+	EXPECT_EQ(12345, queue.getSongAt(12345)->number);
+
+	// Drag a song from near the end to near the front
+	queue.moveSong(19998, 1);
+	EXPECT_EQ(19998, queue.getSongAt(1)->number);
+	EXPECT_EQ(1, queue.getSongAt(2)->number);
+	EXPECT_EQ(19999, queue.getSongAt(19999)->number);
+
+	queue.removeFromQueue(19999);
+	EXPECT_EQ(19997, queue.getSongAt(19998)->number);
+	EXPECT_EQ(19999, queue.size());
+
+	checkPointers(queue);
+}
+
+
+// currSong and the sub queue keep their place and order when shuffled
+TEST(QueueTests, ShuffleKeepsSubQueue)
+{
+	SongQueue queue;
+	for (int i = 0; i < 3; ++i) {
+		queue.addToSubQueue(std::make_unique<Song>(i));
+	}
+	for (int i = 3; i < 50; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(0);
+
+	queue.setShuffled(true);
+	std::vector<Song> songs = queue;
+
+	int currIndex = 0;
+	while (songs[currIndex].number != 0) {
+		++currIndex;
+	}
+	EXPECT_EQ(1, songs[currIndex + 1].number);
+	EXPECT_EQ(2, songs[currIndex + 2].number);
+	checkPointers(queue);
+
+	// Unshuffling restores the original order
+	queue.setShuffled(false);
+	for (int i = 0; i < queue.size(); ++i) {
+		EXPECT_EQ(i, queue.getSongAt(i)->number);
+	}
+}
+
+
+// Nodes freed by removal and clear() are reused by later adds
+TEST(QueueTests, QueueClearAndReuse)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 1000);
+
+	for (int i = 0; i < 500; ++i) {
+		queue.removeFromQueue(0);
+		queue.addToQueue(std::make_unique<Song>(1000 + i));
+	}
+	EXPECT_EQ(500, queue.getSongAt(0)->number);
+	EXPECT_EQ(1499, queue.getSongAt(999)->number);
+
+	queue.clear();
+	EXPECT_EQ(true, queue.isEmpty());
+	EXPECT_EQ(nullptr, queue.getSongAt(0));
+
+	getPopulatedQueue(queue, 10);
+	EXPECT_EQ(true, queueEqualsVector(queue, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+	checkPointers(queue);
+}
+
+
+// Bulk insertion splices whole ranges in, keeping their order
+TEST(QueueTests, QueueAddRange)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 3);
+
+	std::vector<Song> album = { Song(10), Song(11), Song(12) };
+	queue.addRangeToQueue(album.begin(), album.end());
+	EXPECT_EQ(true, queueEqualsVector(queue, { 0, 1, 2, 10, 11, 12 }));
+
+	std::vector<std::unique_ptr<Song>> playNext;
+	playNext.push_back(std::make_unique<Song>(20));
+	playNext.push_back(std::make_unique<Song>(21));
+
+	queue.setCurrSong(1);
+	queue.addRangeToSubQueue(playNext.begin(), playNext.end());
+	queue.addToSubQueue(std::make_unique<Song>(22));
+	EXPECT_EQ(true, queueEqualsVector(queue, { 0, 1, 20, 21, 22, 2, 10, 11, 12 }));
+
+	// Empty ranges are a no-op
+	queue.addRangeToQueue(album.end(), album.end());
+	EXPECT_EQ(9, queue.size());
+
+	EXPECT_EQ(21, queue.getSongAt(3)->number);
+	checkPointers(queue);
+}
+
+
+// Shuffling is lazy: the songs played so far stay ahead of currSong, every song is drawn as playback and readers reach it
+TEST(QueueTests, LazyShuffle)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 100000);
+	queue.setCurrSong(500);
+
+	queue.setShuffled(true);
+	EXPECT_EQ(500, queue.getSongAt(500)->number);
+
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_EQ(true, queue.nextSong(RepeatMode::off));
+	}
+	EXPECT_EQ(100000, queue.size());
+
+	// Reading the whole order draws every song exactly once
+	std::vector<bool> seen(100000, false);
+	int count = 0;
+	for (auto song : queue) {
+		EXPECT_EQ(false, seen[song->number]);
+		seen[song->number] = true;
+		++count;
+	}
+	EXPECT_EQ(100000, count);
+	checkPointers(queue);
+
+	// Songs added while shuffled are drawn like the rest
+	queue.setShuffled(true);
+	queue.addToQueue(std::make_unique<Song>(100000));
+	std::vector<Song> songs = queue;
+	EXPECT_EQ(100001, songs.size());
+}
+
+
+// Like before shuffles were lazy, the songs before currSong are shuffled ahead of it and can be stepped back through
+TEST(QueueTests, ShuffleKeepsPlayedSongsFirst)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 1000);
+	queue.setCurrSong(300);
+	queue.addToSubQueue(std::make_unique<Song>(1000));
+	queue.setShuffled(true);
+
+	EXPECT_EQ(300, queue.getCurrSong()->number);
+	EXPECT_EQ(true, queue.prevSong());
+	EXPECT_LT(queue.getCurrSong()->number, 300);
+	EXPECT_EQ(true, queue.nextSong(RepeatMode::off));
+	EXPECT_EQ(300, queue.getCurrSong()->number);
+	EXPECT_EQ(300, queue.findSong(300));
+	EXPECT_EQ(1000, queue.getSongAt(301)->number);
+
+	std::vector<bool> seen(1001, false);
+	int songIndex = 0;
+	for (auto song : queue) {
+		EXPECT_EQ(false, seen[song->number]);
+		seen[song->number] = true;
+		EXPECT_EQ(songIndex < 300, song->number < 300);
+		++songIndex;
+	}
+	EXPECT_EQ(1001, songIndex);
+	checkPointers(queue);
+
+	// Wrapping around starts a cycle where every song is still to come
+	queue.setCurrSong(queue.size() - 1);
+	const int last = queue.getCurrSong()->number;
+	EXPECT_EQ(true, queue.nextSong(RepeatMode::on));
+	EXPECT_EQ(last, queue.getSongAt(0)->number);
+}
+
+
+// A shuffle is determined by the seed and the queue, so replicas can agree on the order
+TEST(QueueTests, SeededShuffle)
+{
+	SongQueue queue1;
+	SongQueue queue2;
+	getPopulatedQueue(queue1, 1000);
+	getPopulatedQueue(queue2, 1000);
+	queue1.setCurrSong(10);
+	queue2.setCurrSong(10);
+
+	queue1.setShuffleSeed(42);
+	queue2.setShuffleSeed(42);
+	queue1.setShuffled(true);
+	queue2.setShuffled(true);
+	EXPECT_EQ(queue1.getShuffleSeed(), queue2.getShuffleSeed());
+
+	std::vector<Song> songs1 = queue1;
+	std::vector<Song> songs2 = queue2;
+	for (int i = 0; i < 1000; ++i) {
+		EXPECT_EQ(songs1[i].number, songs2[i].number);
+	}
+
+	// Each shuffle advances the seed, so reshuffling gives a new order
+	queue1.setShuffled(true);
+	std::vector<Song> reshuffled = queue1;
+	bool differs = false;
+	for (int i = 0; i < 1000; ++i) {
+		differs = differs || reshuffled[i].number != songs1[i].number;
+	}
+	EXPECT_EQ(true, differs);
+}
+
+
+// A client one edit behind catches up with a few bytes instead of the whole queue
+TEST(QueueTests, VersionDelta)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 1000);
+	queue.setCurrSong(0);
+
+	QueueSnapshot snapshot = queue.snapshot();
+	std::vector<Song> songs = snapshot;
+	std::uint64_t version = snapshot.getVersion();
+	int currIndex = snapshot.getCurrIndex();
+	int subQueueSize = snapshot.getSubQueueSize();
+
+	queue.moveSong(10, 2);
+	std::vector<unsigned char> delta;
+	EXPECT_EQ(true, queue.getDelta(version, delta));
+	EXPECT_GE(12u, delta.size());
+
+	queue.removeFromQueue(500);
+	queue.nextSong(RepeatMode::off);
+	queue.addToSubQueue(std::make_unique<Song>(-1));
+	queue.addToQueue(std::make_unique<Song>(1000));
+	EXPECT_EQ(true, queue.getDelta(version, delta));
+
+	version = QueueDelta::apply(delta, version, songs, currIndex, subQueueSize);
+	EXPECT_EQ(queue.getVersion(), version);
+	EXPECT_EQ(true, queueEqualsVector(queue, [&songs]() {
+		std::vector<int> numbers;
+		for (const Song& song : songs) {
+			numbers.push_back(song.number);
+		}
+		return numbers;
+	}()));
+	EXPECT_EQ(1, currIndex);
+	EXPECT_EQ(1, subQueueSize);
+
+	// Reshuffling replaces the whole order, the client has to refetch it
+	queue.setShuffled(true);
+	EXPECT_EQ(false, queue.getDelta(version, delta));
+}
+
+
+TEST(QueueTests, VersionDeltaHistory)
+{
+	QueueChangeLog log(4);
+	for (int i = 0; i < 6; ++i) {
+		log.record(QueueChangeLog::ChangeType::remove, i);
+	}
+
+	std::vector<QueueChangeLog::Change> changes;
+	EXPECT_EQ(false, log.changesSince(1, changes));
+	EXPECT_EQ(true, log.changesSince(2, changes));
+	EXPECT_EQ(4, changes.size());
+	EXPECT_EQ(2, changes[0].index);
+	EXPECT_EQ(5, changes[3].index);
+
+	// Cursor changes bump the version but take no room, so the edits before them stay reachable
+	for (int i = 0; i < 100; ++i) {
+		log.record(QueueChangeLog::ChangeType::cursor);
+	}
+	EXPECT_EQ(106, log.getVersion());
+	EXPECT_EQ(true, log.changesSince(2, changes));
+	EXPECT_EQ(4, changes.size());
+	EXPECT_EQ(true, log.changesSince(50, changes));
+	EXPECT_EQ(0, changes.size());
+
+	log.record(QueueChangeLog::ChangeType::remove, 6);
+	EXPECT_EQ(false, log.changesSince(2, changes));
+	EXPECT_EQ(true, log.changesSince(3, changes));
+	EXPECT_EQ(4, changes.size());
+	EXPECT_EQ(6, changes[3].index);
+	EXPECT_EQ(106, changes[3].version);
+}
+
+
+TEST(QueueTests, QueueView)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 1000);
+	queue.setCurrSong(500);
+
+	// Paging through the queue, each page starts from the cached cursor
+	for (int offset = 0; offset < 1000; offset += 50) {
+		int i = offset;
+		for (auto song : queue.view(offset, 50)) {
+			EXPECT_EQ(i, song->number);
+			++i;
+		}
+		EXPECT_EQ(offset + 50, i);
+	}
+
+	SongQueue::View tail = queue.view(990, 50);
+	EXPECT_EQ(10, tail.size());
+	int i = 999;
+	for (auto song = tail.rbegin(); song != tail.rend(); ++song) {
+		EXPECT_EQ(i, (*song)->number);
+		--i;
+	}
+	EXPECT_EQ(989, i);
+
+	SongQueue::View window = queue.around(25, 24);
+	EXPECT_EQ(475, window.getOffset());
+	EXPECT_EQ(50, window.size());
+	EXPECT_EQ(475, (*window.begin())->number);
+
+	// Edits invalidate the cursor, the next view looks its start up again
+	queue.removeFromQueue(0);
+	EXPECT_EQ(476, (*queue.view(475, 1).begin())->number);
+
+	EXPECT_THROW(queue.view(1000, 1), std::invalid_argument);
+	EXPECT_EQ(true, queue.view(999, 5).size() == 0);
+}
+
+
+// Checks that two queues hold the same songs in the same order
+void checkSameOrder(const SongQueue& expected, const SongQueue& actual)
+{
+	std::vector<Song> expectedSongs = expected;
+	std::vector<Song> actualSongs = actual;
+	ASSERT_EQ(expectedSongs.size(), actualSongs.size());
+	for (size_t i = 0; i < expectedSongs.size(); ++i) {
+		EXPECT_EQ(expectedSongs[i].number, actualSongs[i].number);
+	}
+}
+
+
+TEST(QueueTests, SaveAndLoad)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 200);
+	queue.setCurrSong(20);
+	queue.addToSubQueue(std::make_unique<Song>(1000));
+	queue.addToSubQueue(std::make_unique<Song>(1001));
+	queue.setShuffled(true);
+	for (int i = 0; i < 5; ++i) {
+		queue.nextSong(RepeatMode::off);
+	}
+
+	std::vector<unsigned char> data;
+	queue.save(data);
+
+	SongQueue loaded;
+	getPopulatedQueue(loaded, 10);
+	EXPECT_EQ(data.size(), loaded.load(data.data(), data.size()));
+	EXPECT_EQ(true, loaded.isShuffled());
+	EXPECT_EQ(queue.getShuffleSeed(), loaded.getShuffleSeed());
+
+	// Songs not drawn yet come out of the restored generator in the same order
+	checkSameOrder(queue, loaded);
+	checkPointers(loaded);
+	for (int i = 0; i < 20; ++i) {
+		EXPECT_EQ(queue.nextSong(RepeatMode::off), loaded.nextSong(RepeatMode::off));
+		EXPECT_EQ(queue.getSongAt(0)->number, loaded.getSongAt(0)->number);
+	}
+
+	queue.setShuffled(false);
+	loaded.setShuffled(false);
+	checkSameOrder(queue, loaded);
+	EXPECT_EQ(queue.getSongAt(21)->number, loaded.getSongAt(21)->number);
+}
+
+
+TEST(QueueTests, LoadRejectsBadData)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 50);
+	queue.setShuffled(true);
+
+	std::vector<unsigned char> data;
+	queue.save(data);
+
+	SongQueue loaded;
+	getPopulatedQueue(loaded, 3);
+	EXPECT_THROW(loaded.load(data.data(), data.size() - 1), std::invalid_argument);
+	data[4] = 99;
+	EXPECT_THROW(loaded.load(data.data(), data.size()), std::invalid_argument);
+
+	// A failed load leaves the queue as it was
+	EXPECT_EQ(3, loaded.size());
+	EXPECT_EQ(false, loaded.isShuffled());
+	checkPointers(loaded);
+}
+
+
+TEST(QueueTests, PlayerSaveAndLoad)
+{
+	Player player;
+	player.setRepeatMode(RepeatMode::on);
+	player.setShuffle(true);
+
+	std::vector<unsigned char> data;
+	player.save(data);
+
+	Player loaded;
+	EXPECT_EQ(data.size(), loaded.load(data.data(), data.size()));
+	EXPECT_EQ(RepeatMode::on, loaded.getRepeatMode());
+	EXPECT_EQ(true, loaded.getQueue()->isShuffled());
+}
+
+
+TEST(QueueTests, AddByValueAndEmplace)
+{
+	SongQueue queue;
+	queue.addToQueue(Song(1));
+	queue.emplaceToQueue(2);
+	queue.addToQueue(std::make_unique<Song>(3));
+	queue.setCurrSong(0);
+	queue.emplaceToSubQueue(10);
+	queue.addToSubQueue(Song(11));
+
+	std::vector<Song> songs = queue;
+	std::vector<int> expected = { 1, 10, 11, 2, 3 };
+	ASSERT_EQ(expected.size(), songs.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		EXPECT_EQ(expected[i], songs[i].number);
+	}
+	checkPointers(queue);
+}
+
+
+TEST(QueueTests, FindAndRemoveById)
+{
+	SongQueue queue;
+	for (int number : { 1, 2, 3, 2, 4, 2 }) {
+		queue.addToQueue(Song(number));
+	}
+
+	EXPECT_TRUE(queue.contains(2));
+	EXPECT_FALSE(queue.contains(5));
+	EXPECT_EQ(1, queue.findSong(2));
+	EXPECT_EQ(4, queue.findSong(4));
+	EXPECT_EQ(-1, queue.findSong(5));
+
+	// The first occurrence goes, then the rest of them
+	EXPECT_TRUE(queue.removeSong(2));
+	EXPECT_EQ(2, queue.findSong(2));
+	EXPECT_EQ(2, queue.removeAllOccurrences(2));
+	EXPECT_FALSE(queue.contains(2));
+	EXPECT_FALSE(queue.removeSong(2));
+	EXPECT_EQ(0, queue.removeAllOccurrences(2));
+
+	std::vector<Song> songs = queue;
+	ASSERT_EQ(3u, songs.size());
+	EXPECT_EQ(1, songs[0].number);
+	EXPECT_EQ(3, songs[1].number);
+	EXPECT_EQ(4, songs[2].number);
+	checkPointers(queue);
+
+	// Removing by index keeps the index in step
+	queue.removeFromQueue(0);
+	EXPECT_FALSE(queue.contains(1));
+	EXPECT_EQ(0, queue.findSong(3));
+
+	queue.clear();
+	EXPECT_FALSE(queue.contains(3));
+	queue.addToQueue(Song(3));
+	EXPECT_EQ(0, queue.findSong(3));
+}
+
+
+TEST(QueueTests, RemovePlayedSongKeepsViewInStep)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 20);
+	queue.setShuffleSeed(7);
+	queue.setCurrSong(10);
+	queue.setShuffled(true);
+
+	EXPECT_EQ(3, queue.view(12, 3).size());
+
+	// Song 3 played before the shuffle, removing it shifts every position after it
+	std::uint64_t version = queue.getVersion();
+	EXPECT_EQ(1, queue.removeAllOccurrences(3));
+	EXPECT_NE(version, queue.getVersion());
+
+	std::vector<Song> songs = queue;
+	std::vector<int> expected;
+	for (int songIndex = 12; songIndex < 15; ++songIndex) {
+		expected.push_back(songs[songIndex].number);
+	}
+	std::vector<int> viewed;
+	for (const Song* song : queue.view(12, 3)) {
+		viewed.push_back(song->number);
+	}
+	EXPECT_EQ(expected, viewed);
+	checkPointers(queue);
+}
+
+
+TEST(QueueTests, JumpToById)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 20);
+
+	EXPECT_FALSE(queue.jumpTo(100));
+	EXPECT_TRUE(queue.jumpTo(7));
+	EXPECT_EQ(8, queue.getSongAt(queue.findSong(7) + 1)->number);
+	EXPECT_TRUE(queue.nextSong(RepeatMode::off));
+
+	QueueSnapshot snapshot = queue.snapshot();
+	EXPECT_EQ(8, snapshot.getCurrIndex());
+
+	// While shuffled, a song that has not been drawn yet is drawn on the spot
+	queue.setShuffleSeed(5);
+	queue.setShuffled(true);
+	for (int number = 0; number < 20; ++number) {
+		ASSERT_TRUE(queue.jumpTo(number));
+		int songIndex = queue.findSong(number);
+		EXPECT_EQ(number, queue.getSongAt(songIndex)->number);
+		EXPECT_EQ(songIndex, queue.snapshot().getCurrIndex());
+	}
+	EXPECT_EQ(20, queue.size());
+	checkPointers(queue);
+}
+
+
+TEST(QueueTests, IndexFollowsShuffleAndLoad)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 200);
+	queue.setShuffled(true);
+
+	// Songs not drawn yet leave without being drawn
+	for (int number = 0; number < 200; number += 2) {
+		EXPECT_TRUE(queue.removeSong(number));
+	}
+	EXPECT_EQ(100, queue.size());
+	for (int number = 0; number < 200; ++number) {
+		EXPECT_EQ(number % 2 == 1, queue.contains(number));
+	}
+
+	std::vector<unsigned char> data;
+	queue.save(data);
+	SongQueue loaded;
+	loaded.load(data.data(), data.size());
+
+	for (int songIndex = 0; songIndex < loaded.size(); ++songIndex) {
+		int number = loaded.getSongAt(songIndex)->number;
+		EXPECT_EQ(songIndex, loaded.findSong(number));
+		EXPECT_EQ(queue.findSong(number), songIndex);
+	}
+
+	loaded.setShuffled(false);
+	for (int songIndex = 0; songIndex < loaded.size(); ++songIndex) {
+		EXPECT_EQ(songIndex, loaded.findSong(2 * songIndex + 1));
+	}
+}
+
+
+TEST(QueueTests, RepeatModes)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 5);
+	queue.setCurrSong(4);
+
+	EXPECT_FALSE(queue.nextSong(RepeatMode::off));
+
+	// once loops the current song
+	std::uint64_t version = queue.getVersion();
+	EXPECT_TRUE(queue.nextSong(RepeatMode::once));
+	EXPECT_EQ(4, queue.snapshot().getCurrIndex());
+	EXPECT_EQ(version, queue.getVersion());
+
+	// on wraps around to the start
+	EXPECT_TRUE(queue.nextSong(RepeatMode::on));
+	EXPECT_EQ(0, queue.snapshot().getCurrIndex());
+	EXPECT_TRUE(queue.nextSong(RepeatMode::on));
+	EXPECT_EQ(1, queue.snapshot().getCurrIndex());
+	EXPECT_TRUE(queue.prevSong());
+	EXPECT_FALSE(queue.prevSong());
+
+	SongQueue single;
+	single.addToQueue(Song(1));
+	single.setCurrSong(0);
+	single.setShuffled(true);
+	EXPECT_TRUE(single.nextSong(RepeatMode::on));
+	EXPECT_EQ(1, single.getSongAt(single.snapshot().getCurrIndex())->number);
+}
+
+
+TEST(QueueTests, ShuffledRepeatReshufflesEachCycle)
+{
+	const int count = 50;
+	SongQueue queue;
+	SongQueue replica;
+	for (SongQueue* q : { &queue, &replica }) {
+		getPopulatedQueue(*q, count);
+		q->setCurrSong(0);
+		q->setShuffleSeed(9);
+		q->setShuffled(true);
+	}
+
+	std::vector<int> previous;
+	for (int cycle = 0; cycle < 4; ++cycle) {
+		// Each cycle after the first starts on the song that ended the last one
+		std::vector<int> played = { queue.getSongAt(0)->number };
+		for (int i = 1; i < count; ++i) {
+			ASSERT_TRUE(queue.nextSong(RepeatMode::on));
+			ASSERT_TRUE(replica.nextSong(RepeatMode::on));
+			int currIndex = queue.snapshot().getCurrIndex();
+			EXPECT_EQ(i, currIndex);
+			played.push_back(queue.getSongAt(currIndex)->number);
+			EXPECT_EQ(played.back(), replica.getSongAt(currIndex)->number);
+		}
+
+		std::vector<int> sorted = played;
+		std::sort(sorted.begin(), sorted.end());
+		for (int number = 0; number < count; ++number) {
+			EXPECT_EQ(number, sorted[number]);
+		}
+		EXPECT_NE(previous, played);
+		previous = played;
+
+		ASSERT_TRUE(queue.nextSong(RepeatMode::on));
+		ASSERT_TRUE(replica.nextSong(RepeatMode::on));
+		EXPECT_EQ(1, queue.snapshot().getCurrIndex());
+		EXPECT_EQ(played.back(), queue.getSongAt(0)->number);
+		EXPECT_TRUE(queue.prevSong());
+		EXPECT_TRUE(replica.prevSong());
+	}
+	checkPointers(queue);
+}
+
+
+namespace
+{
+	std::vector<int> numbersOf(const std::vector<const Song*>& songs)
+	{
+		std::vector<int> numbers;
+		for (const Song* song : songs) {
+			numbers.push_back(song->number);
+		}
+		return numbers;
+	}
+}
+
+
+TEST(QueueTests, PeekNextAndPrev)
+{
+	SongQueue queue;
+	EXPECT_TRUE(queue.peekNext(3).empty());
+
+	getPopulatedQueue(queue, 10);
+	queue.setCurrSong(6);
+
+	EXPECT_EQ(std::vector<int>({ 7, 8, 9 }), numbersOf(queue.peekNext(5)));
+	EXPECT_EQ(std::vector<int>({ 7, 8, 9, 0, 1 }), numbersOf(queue.peekNext(5, RepeatMode::on)));
+	EXPECT_EQ(std::vector<int>({ 6, 6 }), numbersOf(queue.peekNext(2, RepeatMode::once)));
+	EXPECT_EQ(std::vector<int>({ 5, 4, 3 }), numbersOf(queue.peekPrev(3)));
+	EXPECT_TRUE(queue.peekNext(0).empty());
+	EXPECT_THROW(queue.peekNext(-1), std::invalid_argument);
+
+	// Peeking does not move the cursor
+	EXPECT_EQ(6, queue.snapshot().getCurrIndex());
+
+	// The window follows playback and every edit that touches it
+	queue.nextSong(RepeatMode::off);
+	EXPECT_EQ(std::vector<int>({ 8, 9 }), numbersOf(queue.peekNext(3)));
+	queue.addToSubQueue(Song(20));
+	EXPECT_EQ(std::vector<int>({ 20, 8, 9 }), numbersOf(queue.peekNext(3)));
+	queue.removeSong(8);
+	queue.addToQueue(Song(21));
+	EXPECT_EQ(std::vector<int>({ 20, 9, 21 }), numbersOf(queue.peekNext(3)));
+	queue.moveSong(queue.findSong(21), 0);
+	EXPECT_EQ(std::vector<int>({ 20, 9 }), numbersOf(queue.peekNext(3)));
+	queue.removeFromQueue(0);
+	queue.addToQueue(Song(22));
+	EXPECT_EQ(std::vector<int>({ 20, 9, 22 }), numbersOf(queue.peekNext(3)));
+	EXPECT_EQ(std::vector<int>({ 6, 5 }), numbersOf(queue.peekPrev(2)));
+}
+
+
+TEST(QueueTests, PeekNextShuffled)
+{
+	const int count = 300;
+	SongQueue queue;
+	getPopulatedQueue(queue, count);
+	queue.setCurrSong(0);
+	queue.setShuffled(true);
+
+	// Peeking draws the songs it reads, the same ones playback then reaches
+	std::vector<int> peeked = numbersOf(queue.peekNext(count));
+	ASSERT_EQ(static_cast<std::size_t>(count - 1), peeked.size());
+	for (int i = 0; i < 100; ++i) {
+		ASSERT_TRUE(queue.nextSong(RepeatMode::off));
+		EXPECT_EQ(peeked[i], queue.getSongAt(i + 1)->number);
+
+		std::vector<int> next = numbersOf(queue.peekNext(4));
+		EXPECT_EQ(std::vector<int>(peeked.begin() + i + 1, peeked.begin() + i + 5), next);
+	}
+
+	// With repeat the next cycle is drawn on the wrap, so peeking stops at the end of this one
+	queue.setCurrSong(count - 3);
+	EXPECT_EQ(2u, queue.peekNext(10, RepeatMode::on).size());
+}
+
+
+#ifdef __cpp_lib_concepts
+static_assert(std::bidirectional_iterator<SongQueue::Iterator>);
+static_assert(std::bidirectional_iterator<SongQueue::OrderIterator<false>>);
+static_assert(std::bidirectional_iterator<SongQueue::OrderIterator<true>>);
+#endif
+
+
+TEST(QueueTests, IteratorsWorkWithAlgorithms)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 20);
+
+	auto found = std::find_if(queue.begin(), queue.end(), [](const Song* song) { return song->number == 7; });
+	ASSERT_TRUE(found != queue.end());
+	EXPECT_EQ(7, found->number);
+	EXPECT_EQ(20, std::distance(queue.begin(), queue.end()));
+
+	// Stepping back from end() and from rend() both stay on the songs
+	SongQueue::Iterator last = queue.end();
+	EXPECT_EQ(19, (*--last)->number);
+	int count = 0;
+	for (auto song = queue.rbegin(); song != queue.rend(); --song) {
+		EXPECT_EQ(19 - count, song->number);
+		count += 1;
+	}
+	EXPECT_EQ(20, count);
+
+	SongQueue::Iterator unset;
+	unset = queue.begin();
+	EXPECT_TRUE(unset == queue.begin());
+
+	std::vector<int> reversed;
+	std::reverse_iterator<SongQueue::Iterator> song(queue.end());
+	for (; song != std::reverse_iterator<SongQueue::Iterator>(queue.begin()); ++song) {
+		reversed.push_back((*song)->number);
+	}
+	ASSERT_EQ(20u, reversed.size());
+	EXPECT_EQ(19, reversed.front());
+	EXPECT_EQ(0, reversed.back());
+}
+
+
+// Stepping back from end() on a lazily shuffled queue draws the rest of the order first
+TEST(QueueTests, ReverseIteratorsOnLazyShuffle)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 20);
+	queue.setCurrSong(5);
+	queue.setShuffled(true);
+
+	EXPECT_EQ(queue.getSongAt(19), *std::prev(queue.end()));
+
+	SongQueue reversedQueue;
+	getPopulatedQueue(reversedQueue, 20);
+	reversedQueue.setCurrSong(5);
+	reversedQueue.setShuffled(true);
+
+	std::vector<const Song*> reversed;
+	std::reverse_iterator<SongQueue::Iterator> song(reversedQueue.end());
+	for (; song != std::reverse_iterator<SongQueue::Iterator>(reversedQueue.begin()); ++song) {
+		reversed.push_back(*song);
+	}
+	ASSERT_EQ(20u, reversed.size());
+	for (int i = 0; i < 20; ++i) {
+		EXPECT_EQ(reversedQueue.getSongAt(19 - i), reversed[i]);
+	}
+}
+
+
+TEST(QueueTests, OrderIterators)
+{
+	SongQueue queue;
+	getPopulatedQueue(queue, 200);
+	EXPECT_THROW(queue.shuffledOrder(), std::invalid_argument);
+
+	queue.setCurrSong(50);
+	queue.setShuffled(true);
+
+	// The shuffled order matches the current order, the unshuffled one keeps the order songs were added in
+	SongQueue::Order<true> shuffled = queue.shuffledOrder();
+	EXPECT_EQ(200, std::distance(shuffled.begin(), shuffled.end()));
+	EXPECT_TRUE(std::equal(shuffled.begin(), shuffled.end(), queue.begin()));
+	EXPECT_EQ(50, (*std::next(shuffled.begin(), 50))->number);
+
+	int number = 0;
+	for (const Song* song : queue.unshuffledOrder()) {
+		EXPECT_EQ(number++, song->number);
+	}
+	EXPECT_EQ(200, number);
+
+	SongQueue::OrderIterator<false> last = queue.unshuffledOrder().end();
+	EXPECT_EQ(199, (--last)->number);
+	EXPECT_EQ(199, (last++)->number);
+	EXPECT_TRUE(last == queue.unshuffledOrder().end());
+
+	std::vector<const Song*> songs(queue.unshuffledOrder().begin(), queue.unshuffledOrder().end());
+	EXPECT_TRUE(std::is_sorted(songs.begin(), songs.end(), [](const Song* a, const Song* b) { return a->number < b->number; }));
+	EXPECT_EQ(200, queue.unshuffledOrder().size());
+}
@@ -0,0 +1,133 @@
+#include "pch.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../SharedPlaylist/src/adt/player_registry.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+TEST(RegistryTests, CreateUseDestroy)
+{
+	PlayerRegistry registry;
+	EXPECT_EQ(true, registry.create(1));
+	EXPECT_EQ(true, registry.create(2));
+	EXPECT_EQ(false, registry.create(1));
+	EXPECT_EQ(2, registry.size());
+
+	EXPECT_EQ(true, registry.use(1, [](Player& player) {
+		player.getQueue()->addToQueue(std::make_unique<Song>(7));
+	}));
+	EXPECT_EQ(false, registry.use(3, [](Player&) { }));
+
+	int size = 0;
+	registry.use(1, [&](Player& player) { size = player.getQueue()->size(); });
+	EXPECT_EQ(1, size);
+
+	EXPECT_EQ(true, registry.destroy(1));
+	EXPECT_EQ(false, registry.destroy(1));
+	EXPECT_EQ(false, registry.contains(1));
+	EXPECT_EQ(true, registry.contains(2));
+	EXPECT_EQ(1, registry.size());
+}
+
+
+TEST(RegistryTests, EvictAndRestore)
+{
+	PlayerRegistry registry;
+	registry.create(5);
+	registry.use(5, [](Player& player) {
+		for (int i = 0; i < 500; ++i) {
+			player.getQueue()->addToQueue(std::make_unique<Song>(i));
+		}
+		player.getQueue()->setCurrSong(40);
+		player.setRepeatMode(RepeatMode::on);
+		player.setShuffle(true);
+	});
+
+	std::vector<Song> songs;
+	registry.use(5, [&](Player& player) { songs = *player.getQueue(); });
+	const std::size_t residentMemory = registry.memoryUsage(5);
+
+	EXPECT_EQ(true, registry.evict(5));
+	EXPECT_EQ(false, registry.isResident(5));
+	EXPECT_EQ(0, registry.residentCount());
+	EXPECT_GT(residentMemory, 4 * registry.memoryUsage(5));
+
+	// Using an evicted session brings it back exactly as it was
+	registry.use(5, [&](Player& player) {
+		std::vector<Song> restored = *player.getQueue();
+		ASSERT_EQ(songs.size(), restored.size());
+		for (size_t i = 0; i < songs.size(); ++i) {
+			EXPECT_EQ(songs[i].number, restored[i].number);
+		}
+		EXPECT_EQ(RepeatMode::on, player.getRepeatMode());
+		EXPECT_EQ(true, player.getQueue()->isShuffled());
+	});
+	EXPECT_EQ(true, registry.isResident(5));
+}
+
+
+TEST(RegistryTests, EvictIdleAndMemory)
+{
+	PlayerRegistry registry;
+	for (PlayerRegistry::SessionId id = 0; id < 200; ++id) {
+		registry.create(id);
+		registry.use(id, [&](Player& player) {
+			player.getQueue()->addToQueue(std::make_unique<Song>(static_cast<int>(id)));
+		});
+	}
+	EXPECT_EQ(200, registry.residentCount());
+
+	const std::size_t before = registry.memoryUsage();
+	EXPECT_EQ(200, registry.evictIdle(PlayerRegistry::Clock::duration::zero()));
+	EXPECT_EQ(0, registry.residentCount());
+	EXPECT_GT(before, registry.memoryUsage());
+
+	// Recently used sessions are not idle
+	registry.use(10, [](Player&) { });
+	EXPECT_EQ(0, registry.evictIdle(std::chrono::hours(1)));
+	EXPECT_EQ(1, registry.residentCount());
+
+	for (PlayerRegistry::SessionId id = 0; id < 200; ++id) {
+		registry.destroy(id);
+	}
+	EXPECT_EQ(sizeof(PlayerRegistry), registry.memoryUsage());
+}
+
+
+TEST(RegistryTests, ConcurrentSessions)
+{
+	PlayerRegistry registry;
+	const int threadCount = 4;
+	const int sessionsPerThread = 250;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&, t]() {
+			for (int i = 0; i < sessionsPerThread; ++i) {
+				PlayerRegistry::SessionId id = t * sessionsPerThread + i;
+				registry.create(id);
+				for (int song = 0; song < 10; ++song) {
+					registry.use(id, [&](Player& player) {
+						player.getQueue()->addToQueue(std::make_unique<Song>(song));
+					});
+				}
+				if (i % 3 == 0) {
+					registry.evict(id);
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	EXPECT_EQ(threadCount * sessionsPerThread, registry.size());
+	for (PlayerRegistry::SessionId id = 0; id < threadCount * sessionsPerThread; ++id) {
+		int size = 0;
+		registry.use(id, [&](Player& player) { size = player.getQueue()->size(); });
+		EXPECT_EQ(10, size);
+	}
+}
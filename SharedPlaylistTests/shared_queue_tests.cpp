@@ -0,0 +1,257 @@
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../SharedPlaylist/src/adt/shared_song_queue.h"
+#include "../SharedPlaylist/src/adt/shared_player.h"
+#include "../SharedPlaylist/src/adt/epoch_domain.h"
+#include "../SharedPlaylist/src/adt/persistent_song_list.h"
+#include "../SharedPlaylist/src/adt/song.h"
+
+
+TEST(SharedQueueTests, SnapshotMatchesQueue)
+{
+	SongQueue queue;
+	for (int i = 0; i < 10; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(3);
+	queue.addToSubQueue(std::make_unique<Song>(-1));
+	queue.addToSubQueue(std::make_unique<Song>(-2));
+
+	QueueSnapshot snapshot = queue.snapshot();
+	EXPECT_EQ(12, snapshot.size());
+	EXPECT_EQ(3, snapshot.getCurrIndex());
+	EXPECT_EQ(3, snapshot.getCurrSong()->number);
+	EXPECT_EQ(2, snapshot.getSubQueueSize());
+	EXPECT_EQ(-1, snapshot.getSongAt(4)->number);
+
+	int i = 0;
+	for (auto song : snapshot) {
+		EXPECT_EQ(queue.getSongAt(i)->number, song->number);
+		++i;
+	}
+	EXPECT_EQ(12, i);
+}
+
+
+// A pinned snapshot keeps its contents while the queue changes underneath it
+TEST(SharedQueueTests, ReaderKeepsSnapshot)
+{
+	SharedSongQueue queue;
+	for (int i = 0; i < 5; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+
+	{
+		SharedSongQueue::Reader reader = queue.read();
+		queue.removeFromQueue(0);
+		queue.addToQueue(std::make_unique<Song>(5));
+		queue.addToQueue(std::make_unique<Song>(6));
+
+		EXPECT_EQ(5, reader->size());
+		EXPECT_EQ(0, reader->getSongAt(0)->number);
+		EXPECT_EQ(6, queue.size());
+	}
+
+	// Nothing pins the old snapshots anymore
+	queue.clear();
+	EXPECT_EQ(true, queue.isEmpty());
+}
+
+
+TEST(SharedQueueTests, EpochReclamation)
+{
+	struct Counted
+	{
+		explicit Counted(int& live) : live(live) { ++live; }
+		~Counted() { --live; }
+		int& live;
+	};
+
+	int live = 0;
+	EpochDomain epochs;
+	{
+		EpochDomain::Guard guard(epochs);
+		epochs.retire(new Counted(live));
+		epochs.retire(new Counted(live));
+		EXPECT_EQ(2, live);
+		EXPECT_EQ(2, epochs.pendingCount());
+	}
+
+	// Readers that start after the retirement don't hold it back
+	EpochDomain::Guard guard(epochs);
+	epochs.reclaim();
+	EXPECT_EQ(0, live);
+	EXPECT_EQ(0, epochs.pendingCount());
+}
+
+
+// With every slot taken, a further reader waits for one to free up
+TEST(SharedQueueTests, EpochSlotsExhausted)
+{
+	EpochDomain epochs;
+	std::vector<EpochDomain::Guard> guards;
+	guards.reserve(EpochDomain::kSlots);
+	for (int i = 0; i < EpochDomain::kSlots; ++i) {
+		guards.emplace_back(epochs);
+	}
+
+	std::atomic<bool> pinned(false);
+	std::thread reader([&]() {
+		EpochDomain::Guard guard(epochs);
+		pinned = true;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	EXPECT_FALSE(pinned);
+	guards.pop_back();
+	reader.join();
+	EXPECT_TRUE(pinned);
+}
+
+
+TEST(SharedQueueTests, ConcurrentReadersAndWriter)
+{
+	SharedSongQueue queue;
+	queue.edit([](SongQueue& songs) {
+		for (int i = 0; i < 100; ++i) {
+			songs.addToQueue(std::make_unique<Song>(i));
+		}
+		songs.setCurrSong(0);
+	});
+
+	std::atomic<bool> done(false);
+	std::atomic<int> inconsistent(0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; ++t) {
+		readers.emplace_back([&]() {
+			while (!done.load()) {
+				SharedSongQueue::Reader reader = queue.read();
+
+				// Every snapshot holds each song once and a valid currSong
+				std::vector<bool> seen(200, false);
+				for (auto song : *reader) {
+					if (seen[song->number]) {
+						inconsistent += 1;
+					}
+					seen[song->number] = true;
+				}
+				if (reader->getCurrSong() == nullptr) {
+					inconsistent += 1;
+				}
+			}
+		});
+	}
+
+	for (int i = 0; i < 500; ++i) {
+		queue.setShuffled(i % 2 == 0);
+		queue.nextSong(RepeatMode::off);
+		queue.addToQueue(std::make_unique<Song>(100 + i % 100));
+		queue.removeFromQueue(queue.size() - 1);
+	}
+	done.store(true);
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+
+	EXPECT_EQ(0, inconsistent.load());
+	EXPECT_EQ(100, queue.size());
+}
+
+
+// Racing shuffle toggles and playback never leave the player and the published queue disagreeing
+TEST(SharedQueueTests, SharedPlayerFromManyThreads)
+{
+	SharedPlayer player;
+	player.setRepeatMode(RepeatMode::on);
+	player.getQueue().edit([](SongQueue& songs) {
+		for (int i = 0; i < 100; ++i) {
+			songs.addToQueue(std::make_unique<Song>(i));
+		}
+		songs.setCurrSong(0);
+	});
+
+	for (int round = 0; round < 200; ++round) {
+		std::vector<std::thread> threads;
+		threads.emplace_back([&]() { player.setShuffle(true); });
+		threads.emplace_back([&]() { player.setShuffle(false); });
+		threads.emplace_back([&]() {
+			for (int i = 0; i < 5; ++i) {
+				player.nextSong();
+			}
+		});
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		ASSERT_EQ(player.getQueue().read()->isShuffled(), player.getShuffle());
+		ASSERT_NE(nullptr, player.getQueue().read()->getCurrSong());
+	}
+	EXPECT_EQ(100, player.getQueue().size());
+}
+
+
+TEST(SharedQueueTests, PersistentSongListEdits)
+{
+	std::vector<Song> songs;
+	for (int i = 0; i < 100; ++i) {
+		songs.push_back(Song(i));
+	}
+
+	PersistentSongList list(songs);
+	PersistentSongList edited = list.erased(0).inserted(50, Song(-1)).appended(Song(100));
+
+	EXPECT_EQ(100, list.size());
+	EXPECT_EQ(0, list.getSongAt(0)->number);
+	EXPECT_EQ(99, list.getSongAt(99)->number);
+
+	EXPECT_EQ(101, edited.size());
+	EXPECT_EQ(1, edited.getSongAt(0)->number);
+	EXPECT_EQ(-1, edited.getSongAt(50)->number);
+	EXPECT_EQ(51, edited.getSongAt(51)->number);
+	EXPECT_EQ(100, edited.getSongAt(100)->number);
+	EXPECT_EQ(nullptr, edited.getSongAt(101));
+}
+
+
+// Snapshots are kept as history, each one unaffected by the edits made after it
+TEST(SharedQueueTests, SnapshotHistory)
+{
+	SongQueue queue;
+	for (int i = 0; i < 1000; ++i) {
+		queue.addToQueue(std::make_unique<Song>(i));
+	}
+	queue.setCurrSong(0);
+
+	std::vector<QueueSnapshot> history;
+	for (int i = 0; i < 100; ++i) {
+		history.push_back(queue.snapshot());
+		queue.removeFromQueue(queue.size() - 1);
+		queue.nextSong(RepeatMode::off);
+	}
+
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_EQ(1000 - i, history[i].size());
+		EXPECT_EQ(i, history[i].getCurrIndex());
+		EXPECT_EQ(999 - i, history[i].getSongAt(history[i].size() - 1)->number);
+	}
+
+	// A shuffled snapshot holds the whole drawn order
+	queue.setShuffled(true);
+	QueueSnapshot shuffled = queue.snapshot();
+	std::vector<Song> songs = queue;
+	EXPECT_EQ(true, shuffled.isShuffled());
+	EXPECT_EQ(100, shuffled.getCurrIndex());
+
+	int i = 0;
+	for (auto song : shuffled) {
+		EXPECT_EQ(songs[i].number, song->number);
+		++i;
+	}
+	EXPECT_EQ(900, i);
+}